@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "integrador/montecarlo.hpp"
+
+// Reutiliza un almacén de muestras (--store) sin volver a evaluar f:
+//   - la integral sobre un subcubo [li, ls]^d del dominio (--subdomain)
+//   - la integral de w(x) f(x) para un peso w en el lenguaje de --expr
+//     (--weight), p. ej. el cociente de densidades de un re-muestreo por
+//     importancia
+//   - un error bootstrap por remuestreo de bloques (--bootstrap)
+// Con MPI se pasan los archivos de todos los procesos (muestras.mcs.0, ...).
+
+// ¿Las dos cabeceras son de la misma corrida? Solo puede cambiar el proceso escritor
+static bool misma_corrida(const montecarlo::CabeceraMuestras& a, const montecarlo::CabeceraMuestras& b) {
+    return a.dimensiones == b.dimensiones && a.motor == b.motor && a.muestreo == b.muestreo &&
+           a.precision_mixta == b.precision_mixta && a.lim_inf == b.lim_inf && a.lim_sup == b.lim_sup &&
+           a.seed == b.seed && a.N == b.N && a.procesos == b.procesos;
+}
+
+static void uso(const char* programa) {
+    std::cerr << "Usage: " << programa
+              << " archivo [archivo ...] [--subdomain li ls] [--weight expr] [--bootstrap B] [--seed s]" << std::endl;
+    exit(1);
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> rutas;
+    double sub_inf = -HUGE_VAL, sub_sup = HUGE_VAL;
+    std::string texto_peso;
+    int bootstrap = 0;
+    unsigned long long seed = 12345;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string opcion = argv[i];
+        if (opcion == "--subdomain" && i + 2 < argc) {
+            sub_inf = atof(argv[++i]);
+            sub_sup = atof(argv[++i]);
+        } else if (opcion == "--weight" && i + 1 < argc) {
+            texto_peso = argv[++i];
+        } else if (opcion == "--bootstrap" && i + 1 < argc) {
+            bootstrap = atoi(argv[++i]);
+        } else if (opcion == "--seed" && i + 1 < argc) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else if (opcion.compare(0, 2, "--") == 0) {
+            uso(argv[0]);
+        } else {
+            rutas.push_back(opcion);
+        }
+    }
+    if (rutas.empty() || sub_inf > sub_sup || bootstrap < 0) uso(argv[0]);
+
+    // Todos los archivos tienen que venir de la misma corrida, cada uno de un proceso distinto
+    std::vector<std::unique_ptr<montecarlo::LectorMuestras>> lectores;
+    std::vector<const montecarlo::LectorMuestras*> punteros;
+    std::vector<std::string> escritores;
+    for (const std::string& ruta : rutas) {
+        lectores.emplace_back(new montecarlo::LectorMuestras);
+        std::string error;
+        if (!lectores.back()->abrir(ruta, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        const montecarlo::CabeceraMuestras& a = lectores.front()->cabecera();
+        const montecarlo::CabeceraMuestras& b = lectores.back()->cabecera();
+        if (!misma_corrida(a, b)) {
+            std::cerr << ruta << " no es de la misma corrida que " << rutas.front() << std::endl;
+            return 1;
+        }
+        if (b.proceso < 0 || b.proceso >= b.procesos) {
+            std::cerr << ruta << ": proceso " << b.proceso << " fuera de los " << b.procesos << " de la corrida"
+                      << std::endl;
+            return 1;
+        }
+        escritores.resize(std::size_t(b.procesos));
+        if (!escritores[b.proceso].empty()) {
+            std::cerr << ruta << " y " << escritores[b.proceso] << " son del mismo proceso (" << b.proceso << ")"
+                      << std::endl;
+            return 1;
+        }
+        escritores[b.proceso] = ruta;
+        punteros.push_back(lectores.back().get());
+    }
+
+    // Cada muestra puede estar una sola vez entre todos los archivos
+    std::vector<std::pair<long long, long long>> rangos;
+    for (const montecarlo::LectorMuestras* lector : punteros) {
+        for (const montecarlo::BloqueMapeado& b : lector->bloques()) rangos.push_back({b.inicio, b.inicio + b.n});
+    }
+    std::sort(rangos.begin(), rangos.end());
+    for (std::size_t i = 1; i < rangos.size(); i++) {
+        if (rangos[i].first < rangos[i - 1].second) {
+            std::cerr << "Las muestras [" << rangos[i].first << ", " << std::min(rangos[i].second, rangos[i - 1].second)
+                      << ") aparecen más de una vez" << std::endl;
+            return 1;
+        }
+    }
+
+    const montecarlo::CabeceraMuestras& cabecera = lectores.front()->cabecera();
+    const int d = cabecera.dimensiones;
+    montecarlo::Dominio dominio{cabecera.lim_inf, cabecera.lim_sup, d};
+
+    montecarlo::Expresion peso;
+    if (!texto_peso.empty()) {
+        std::string error;
+        if (!montecarlo::compilar_expresion(texto_peso, d, peso, error)) {
+            std::cerr << "--weight: " << error << std::endl;
+            return 1;
+        }
+    }
+
+    double time_1 = montecarlo::tiempo();
+
+    std::vector<montecarlo::Momentos> bloques = montecarlo::momentos_por_bloque(
+        punteros, texto_peso.empty() ? nullptr : &peso, sub_inf, sub_sup);
+    montecarlo::Momentos total;
+    for (const montecarlo::Momentos& m : bloques) total += m;
+    if (total.n == 0) {
+        std::cerr << "Los archivos no tienen ningún bloque completo" << std::endl;
+        return 1;
+    }
+    montecarlo::Resultado resultado = montecarlo::estimar(total, total.n, dominio.volumen());
+
+    double time_2 = montecarlo::tiempo();
+
+    long long esperadas = cabecera.N;
+    long long leidas = 0;
+    for (const montecarlo::LectorMuestras* lector : punteros) leidas += lector->muestras();
+
+    std::cout << std::setprecision(10);
+    std::cout << "Dimensiones: " << d << "  dominio: [" << cabecera.lim_inf << ", " << cabecera.lim_sup << "]"
+              << std::endl;
+    std::cout << "Muestras: " << leidas << " de " << esperadas << " en " << bloques.size() << " bloques" << std::endl;
+    std::cout << "Integral: " << resultado.integral << std::endl;
+    std::cout << "Error: " << resultado.error << std::endl;
+    if (bootstrap > 0) {
+        std::cout << "Error bootstrap (" << bootstrap << " remuestreos): "
+                  << montecarlo::error_bootstrap(bloques, dominio.volumen(), bootstrap, seed) << std::endl;
+    }
+    std::cout << "Tiempo: " << time_2 - time_1 << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include <iostream>
+
+#include <mpi.h>
+
+#include "../integrador/distribuido.hpp"
+#include "../integrador/montecarlo.hpp"
+
+int main(int argc, char* argv[]) {
+
+    // Verificación y lectura de argumentos ingresados por el usuario
+    montecarlo::Parametros p = montecarlo::leer_parametros(argc, argv);
+
+    // Un proceso por nodo (o socket) con un equipo de hilos OpenMP: solo el
+    // hilo principal llama a MPI, fuera de las regiones paralelas
+    int provisto;
+    MPI_Init_thread(NULL, NULL, MPI_THREAD_FUNNELED, &provisto);
+
+    double time_1 = MPI_Wtime();
+
+    // Tamaño y rango
+    int size, rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    if (provisto < MPI_THREAD_FUNNELED) {
+        if (rank == 0) std::cerr << "La biblioteca MPI no soporta MPI_THREAD_FUNNELED" << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    // Tiempos por fase y contadores de hardware con --profile
+    montecarlo::iniciar_instrumentacion(p);
+
+    // Cada proceso recibe su parte (un rango alineado a bloques, o tramos
+    // pedidos con --schedule dynamic), que su equipo de hilos reparte
+    montecarlo::Ejecucion resultado = montecarlo::ejecutar(p, MPI_COMM_WORLD);
+
+    double time_2 = MPI_Wtime();
+
+    // Impresión de resultados solo para proceso 0
+    if (rank == 0) {
+        montecarlo::imprimir_resultados(p, resultado);
+        std::cout << "Tiempo: " << time_2 - time_1 << std::endl;
+        std::cout << "Procesos: " << size << ", hilos por proceso: " << omp_get_max_threads() << std::endl;
+    }
+
+    montecarlo::reportar_instrumentacion(p, MPI_COMM_WORLD);
+
+    MPI_Finalize();
+
+    return 0;
+}
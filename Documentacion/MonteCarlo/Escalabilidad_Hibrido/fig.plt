@@ -0,0 +1,17 @@
+set terminal epslatex color size 6.0in,5.0in standalone font "" 14
+set output 'Figure.tex'
+set border linewidth 6 
+set ylabel '\textbf{Speedup} $S$'
+set xlabel '\textbf{Número de núcleos} $P \times T$'
+set ytics scale 2
+set xtics scale 2
+
+f(x) = x
+
+plot for [p=1:8] 'speedupMC_Hibrido.dat' u ($1==p ? $3 : 1/0):4 w lp pt 7 ps 2.5 lw 3 t sprintf('%d procesos', p),     f(x) w l lw 3 lc rgb "blue" t 'Ideal'
+
+set output
+system('latex Figure.tex')
+system('dvips Figure.dvi')
+system('ps2pdf Figure.ps')
+system('rm Figure.tex Figure.log Figure.aux Figure-inc.eps Figure.dvi Figure.ps')
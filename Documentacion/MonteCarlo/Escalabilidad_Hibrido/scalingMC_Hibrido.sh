@@ -0,0 +1,43 @@
+#!/bin/bash
+
+echo "Compilando maxThreads.cpp..."
+g++ maxThreads.cpp -o maxThreads.x -fopenmp || { echo "Error"; exit 1; }
+
+# Núcleos disponibles por nodo: el producto procesos x hilos no los supera
+MAX_CORES=$(./maxThreads.x | awk '{print $3}')
+echo "Máximo número de núcleos: $MAX_CORES"
+
+echo "Compilando MPI + OpenMP..."
+mpic++ -O3 -fopenmp MC_Hibrido.cpp -o MC_Hibrido.x || { echo "Error al compilar"; exit 1; }
+
+# Máximo de procesos a probar (en un clúster: uno por nodo o por socket)
+MAX_PROCS=${MAX_PROCS:-4}
+
+[ -f scaling_hibrido.dat ] && rm scaling_hibrido.dat
+
+echo "Ejecutando pruebas híbridas..."
+for (( p=1; p<=${MAX_PROCS}; p++ )); do
+    for (( t=1; p*t<=${MAX_CORES}; t++ )); do
+        echo "Con $p procesos x $t hilos..."
+
+        # Cada proceso queda ligado a t núcleos consecutivos para su equipo de hilos
+        TIEMPO=$(mpirun -np $p --map-by slot:PE=$t --bind-to core -x OMP_NUM_THREADS=$t -x OMP_PROC_BIND=close \
+                 ./MC_Hibrido.x --li 0 --ls 1 --d 3 --n 10000000 --method mc | grep "Tiempo:" | awk '{print $2}')
+
+        echo "$p $t $TIEMPO" >> scaling_hibrido.dat
+    done
+done
+
+T1=$(head -n 1 scaling_hibrido.dat | awk '{print $3}')
+
+# Columnas: procesos, hilos, núcleos usados, speedup
+awk -v T1="$T1" '{printf "%d %d %d %.6f\n", $1, $2, $1*$2, T1/$3}' scaling_hibrido.dat > speedupMC_Hibrido.dat
+
+echo "Listo: speedupMC_Hibrido.dat generado."
+
+if [ -f fig.plt ]; then
+    echo "Generando figura..."
+    gnuplot fig.plt
+fi
+
+echo "Finalizado."
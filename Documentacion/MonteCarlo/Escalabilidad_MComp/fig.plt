@@ -8,7 +8,11 @@ set xtics scale 2
 
 f(x) = x
 
-plot 'speedupMC_MemComp.dat' u 1:2 w p pt 7 ps 2.5 lc rgb "red" t 'Speedup',     f(x) w l lw 3 lc rgb "blue" t 'Ideal'
+# Columnas de bench_escalabilidad: hilos (5), speedup (12) y su intervalo de confianza (13, 14)
+set datafile separator ','
+plot 'escalabilidad_strong.csv' every ::1 u 5:12:13:14 w yerrorbars pt 7 ps 2.5 lc rgb "red" t 'Fuerte', \
+     'escalabilidad_weak.csv' every ::1 u 5:12:13:14 w yerrorbars pt 5 ps 2.5 lc rgb "dark-green" t 'Débil (escalado)', \
+     f(x) w l lw 3 lc rgb "blue" t 'Ideal'
 
 set output
 system('latex Figure.tex')
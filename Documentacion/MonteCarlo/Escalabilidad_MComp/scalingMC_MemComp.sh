@@ -1,32 +1,24 @@
 #!/bin/bash
 
-echo "Compilando maxThreads.cpp..."
-g++ maxThreads.cpp -o maxThreads.x -fopenmp || { echo "Error"; exit 1; }
-
-MAX_THREADS=$(./maxThreads.x | awk '{print $3}')
-echo "Máximo número de hilos: $MAX_THREADS"
-
-echo "Compilando MC_MemComp.cpp..."
-g++ MC_MemComp.cpp -o MC_MemComp.x -fopenmp || { echo "Error"; exit 1; }
-
-[ -f scaling.dat ] && rm scaling.dat
-
-echo "Ejecutando pruebas..."
-for (( t=1; t<=${MAX_THREADS}; t++ )); do
-    echo "Con $t hilos..."
-
-    TIEMPO=$(OMP_NUM_THREADS=$t ./MC_MemComp.x --li 0 --ls 1 --d 3 --n 10000000              | grep "Tiempo:" | awk '{print $2}')
-
-    echo "$t $TIEMPO" >> scaling.dat
+echo "Compilando bench_escalabilidad.cpp..."
+g++ -O3 -std=c++17 -fopenmp ../Rendimiento/bench_escalabilidad.cpp -o bench_escalabilidad.x || { echo "Error"; exit 1; }
+
+# De 1 hilo al máximo de OpenMP, con calentamiento y 7 repeticiones por
+# configuración. Los hilos llenan un socket antes de pasar al siguiente
+# (--pin close), y la salida informa la ganancia al sumar cada socket.
+# REFERENCIA=directorio compara contra los CSV de una corrida anterior y
+# termina con error si alguna configuración es más lenta.
+ESTADO=0
+for MODO in strong weak; do
+    echo "Ejecutando pruebas ($MODO)..."
+    ANTERIOR=${REFERENCIA:+--referencia $REFERENCIA/escalabilidad_$MODO.csv}
+    ./bench_escalabilidad.x --modo $MODO --d 3 --n 10000000 --pin close --salida escalabilidad_$MODO $ANTERIOR || ESTADO=1
 done
 
-T1=$(head -n 1 scaling.dat | awk '{print $2}')
-
-awk -v T1="$T1" '{printf "%d %.6f\n", $1, T1/$2}' scaling.dat > speedupMC_MemComp.dat
-
 if [ -f fig.plt ]; then
     echo "Generando figura..."
     gnuplot fig.plt
 fi
 
 echo "Finalizado."
+exit $ESTADO
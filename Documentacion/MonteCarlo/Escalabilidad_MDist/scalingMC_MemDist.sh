@@ -1,30 +1,26 @@
 #!/bin/bash
 
-echo "Compilando MPI..."
-mpic++ MC_MemDist_mpi.cpp -o MC_MemDist_mpi.x || { echo "Error al compilar"; exit 1; }
+echo "Compilando bench_escalabilidad.cpp con MPI..."
+mpic++ -DCON_MPI -O3 -std=c++17 ../Rendimiento/bench_escalabilidad.cpp -o bench_escalabilidad_mpi.x || { echo "Error al compilar"; exit 1; }
 
 MAX_PROCS=8
 
-[ -f scaling_mpi.dat ] && rm scaling_mpi.dat
-
-echo "Ejecutando pruebas MPI..."
-for (( p=1; p<=${MAX_PROCS}; p++ )); do
-    echo "Con $p procesos..."
-
-    TIEMPO=$(mpirun -np $p ./MC_MemDist_mpi.x --li 0 --ls 1 --d 3 --n 10000000               | grep "Tiempo:" | awk '{print $2}')
-
-    echo "$p $TIEMPO" >> scaling_mpi.dat
+# Un solo lanzamiento: cada configuración de p procesos corre en los primeros p
+# rangos. REFERENCIA=directorio compara contra los CSV de una corrida anterior.
+ESTADO=0
+for MODO in strong weak; do
+    echo "Ejecutando pruebas MPI ($MODO)..."
+    ANTERIOR=${REFERENCIA:+--referencia $REFERENCIA/escalabilidad_$MODO.csv}
+    mpirun -np $MAX_PROCS ./bench_escalabilidad_mpi.x --modo $MODO --hilos 1 --d 3 --n 10000000 \
+        --salida escalabilidad_$MODO $ANTERIOR || ESTADO=1
 done
 
-T1=$(head -n 1 scaling_mpi.dat | awk '{print $2}')
-
-awk -v T1="$T1" '{printf "%d %.6f\n", $1, T1/$2}' scaling_mpi.dat > speedupMC_MemDist.dat
-
-echo "Listo: speedupMC_MemDist.dat generado."
+echo "Listo: escalabilidad_strong.csv y escalabilidad_weak.csv generados."
 
 if [ -f fig.plt ]; then
     echo "Generando figura..."
-    sed 's/speedupFourier.dat/speedupMC_MemDist.dat/' fig.plt | gnuplot
+    gnuplot fig.plt
 fi
 
 echo "Finalizado."
+exit $ESTADO
@@ -0,0 +1,500 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#ifdef CON_MPI
+#include <mpi.h>
+
+#include "../integrador/distribuido.hpp"
+#endif
+#include "../integrador/montecarlo.hpp"
+
+// Banco de escalabilidad fuerte y débil. Para cada variante (motor o muestreo),
+// dimensión, número de procesos y número de hilos mide varias repeticiones de la
+// integración de la gaussiana (tras un calentamiento) y reporta la mediana con
+// su intervalo de confianza del 95 %, speedup, eficiencia S(p)/p y muestras/s.
+//
+// Compilado con -DCON_MPI y lanzado con mpirun -np P, cada configuración de p
+// procesos corre en un subcomunicador de los primeros p rangos.
+//
+// Los hilos se fijan a CPUs (--pin close por defecto: un socket se llena antes
+// de pasar al siguiente), así que cada fila sabe cuántos sockets ocupa. Al final
+// se informa la ganancia por socket: el speedup con la mayor cantidad de hilos
+// que ocupa s sockets dividido por el de s - 1 sockets. Con MPI el valor por
+// defecto es --pin none: sin un --bind-to de mpirun, todos los rangos de un
+// nodo verían la misma máscara y fijarían sus hilos a las mismas CPUs.
+//
+// Uso: ./bench_escalabilidad.x [--modo strong|weak] [--n muestras] [--d 3,8]
+//        [--hilos 1-8] [--procesos 1,2,4] [--variantes philox,sobol]
+//        [--repeticiones 7] [--calentamiento 1] [--salida prefijo]
+//        [--referencia anterior.csv] [--tolerancia 0.10] [--pin close|spread|none]
+//
+// Escribe prefijo.csv (que leen los fig.plt) y prefijo.json con los datos de la
+// máquina. Con --referencia compara contra una corrida anterior y termina con
+// código 1 si alguna configuración es más lenta que la tolerancia, con
+// intervalos de confianza disjuntos.
+
+// Lista "1,2,4" o rango "1-8" (o combinaciones "1-4,8,16")
+std::vector<int> leer_lista(const std::string& texto) {
+    std::vector<int> lista;
+    std::stringstream campos(texto);
+    std::string campo;
+    while (std::getline(campos, campo, ',')) {
+        std::size_t guion = campo.find('-');
+        if (guion == std::string::npos) {
+            lista.push_back(atoi(campo.c_str()));
+        } else {
+            int desde = atoi(campo.substr(0, guion).c_str());
+            int hasta = atoi(campo.substr(guion + 1).c_str());
+            for (int i = desde; i <= hasta; i++) lista.push_back(i);
+        }
+    }
+    return lista;
+}
+
+std::vector<std::string> leer_nombres(const std::string& texto) {
+    std::vector<std::string> nombres;
+    std::stringstream campos(texto);
+    std::string campo;
+    while (std::getline(campos, campo, ',')) nombres.push_back(campo);
+    return nombres;
+}
+
+// Motor o secuencia de una variante: philox, xoshiro, pcg64, splitmix, mt, sobol, halton
+bool leer_variante(const std::string& nombre, montecarlo::Parametros& p) {
+    if (nombre == "sobol") p.muestreo = montecarlo::Muestreo::SOBOL;
+    else if (nombre == "halton") p.muestreo = montecarlo::Muestreo::HALTON;
+    else return montecarlo::leer_motor(nombre.c_str(), p.motor);
+    return true;
+}
+
+// Mediana e intervalo de confianza del 95 % por estadísticos de orden: no
+// supone normalidad, y los tiempos de ejecución rara vez la tienen
+struct Estadistica {
+    double mediana = 0.0;
+    double inferior = 0.0;
+    double superior = 0.0;
+};
+
+Estadistica resumir(std::vector<double> tiempos) {
+    std::sort(tiempos.begin(), tiempos.end());
+    const int n = int(tiempos.size());
+    Estadistica e;
+    e.mediana = n % 2 ? tiempos[n / 2] : 0.5 * (tiempos[n / 2 - 1] + tiempos[n / 2]);
+    const double radio = 1.96 * std::sqrt(double(n)) / 2.0;
+    int j = int(std::floor(n / 2.0 - radio));
+    int k = int(std::ceil(n / 2.0 + radio)) - 1;
+    e.inferior = tiempos[std::max(j, 0)];
+    e.superior = tiempos[std::min(k, n - 1)];
+    return e;
+}
+
+// Una fila de resultados
+struct Medicion {
+    std::string modo, variante;
+    int dimensiones = 0, procesos = 1, hilos = 1;
+    int sockets = 0;  // ocupados por los hilos de cada proceso (0 sin --pin)
+    long long N = 0;
+    int repeticiones = 0;
+    Estadistica tiempo;
+    double speedup = 0.0, speedup_inferior = 0.0, speedup_superior = 0.0;
+    double eficiencia = 0.0;
+    double muestras_por_segundo = 0.0;
+
+    int nucleos() const { return procesos * hilos; }
+
+    std::string clave() const {
+        std::ostringstream s;
+        s << modo << ',' << variante << ',' << dimensiones << ',' << procesos << ',' << hilos << ',' << N;
+        return s.str();
+    }
+};
+
+const char* CABECERA_CSV = "modo,variante,d,procesos,hilos,nucleos,N,repeticiones,mediana,ic_inferior,ic_superior,"
+                           "speedup,speedup_inferior,speedup_superior,eficiencia,muestras_por_segundo,sockets";
+
+void escribir_csv(std::ostream& salida, const Medicion& m) {
+    salida << m.modo << ',' << m.variante << ',' << m.dimensiones << ',' << m.procesos << ',' << m.hilos << ','
+           << m.nucleos() << ',' << m.N << ',' << m.repeticiones << ',' << m.tiempo.mediana << ','
+           << m.tiempo.inferior << ',' << m.tiempo.superior << ',' << m.speedup << ',' << m.speedup_inferior << ','
+           << m.speedup_superior << ',' << m.eficiencia << ',' << m.muestras_por_segundo << ',' << m.sockets << '\n';
+}
+
+// Ganancia al sumar un socket, para una variante, dimensión y número de procesos:
+// la fila con más hilos que ocupa s sockets contra la que ocupa s - 1. Con
+// escalado perfecto, la ganancia es el cociente de hilos.
+struct GananciaSocket {
+    const Medicion* antes;
+    const Medicion* despues;
+
+    double ganancia() const { return despues->speedup / antes->speedup; }
+    double ideal() const { return double(despues->hilos) / antes->hilos; }
+};
+
+std::vector<GananciaSocket> ganancias_por_socket(const std::vector<Medicion>& mediciones) {
+    // Mayor número de hilos de cada (variante, d, procesos, sockets)
+    std::map<std::string, const Medicion*> mayor;
+    auto clave = [](const Medicion& m, int sockets) {
+        std::ostringstream s;
+        s << m.variante << ',' << m.dimensiones << ',' << m.procesos << ',' << sockets;
+        return s.str();
+    };
+    for (const Medicion& m : mediciones) {
+        if (m.sockets == 0) continue;
+        const Medicion*& actual = mayor[clave(m, m.sockets)];
+        if (!actual || m.hilos > actual->hilos) actual = &m;
+    }
+
+    std::vector<GananciaSocket> ganancias;
+    for (const auto& fila : mayor) {
+        const Medicion* despues = fila.second;
+        if (despues->sockets < 2) continue;
+        auto antes = mayor.find(clave(*despues, despues->sockets - 1));
+        if (antes != mayor.end()) ganancias.push_back({antes->second, despues});
+    }
+    return ganancias;
+}
+
+// Filas de un CSV anterior, indexadas por configuración
+std::map<std::string, Medicion> leer_csv(const std::string& ruta) {
+    std::map<std::string, Medicion> filas;
+    std::ifstream archivo(ruta);
+    std::string linea;
+    std::getline(archivo, linea);
+    while (std::getline(archivo, linea)) {
+        std::vector<std::string> c = leer_nombres(linea);
+        if (c.size() < 11) continue;
+        Medicion m;
+        m.modo = c[0];
+        m.variante = c[1];
+        m.dimensiones = atoi(c[2].c_str());
+        m.procesos = atoi(c[3].c_str());
+        m.hilos = atoi(c[4].c_str());
+        m.N = atoll(c[6].c_str());
+        m.tiempo.mediana = atof(c[8].c_str());
+        m.tiempo.inferior = atof(c[9].c_str());
+        m.tiempo.superior = atof(c[10].c_str());
+        filas[m.clave()] = m;
+    }
+    return filas;
+}
+
+// Texto entre comillas para JSON (los valores de la máquina pueden traer comillas)
+std::string cadena_json(const std::string& texto) {
+    std::string s = "\"";
+    for (char c : texto) {
+        if (c == '"' || c == '\\') s += '\\';
+        if (c >= 0 && c < 0x20) continue;
+        s += c;
+    }
+    return s + "\"";
+}
+
+// Datos de la máquina que acompañan a cada corrida
+std::vector<std::pair<std::string, std::string>> datos_maquina(int procesos_mpi) {
+    std::vector<std::pair<std::string, std::string>> datos;
+
+    char host[256] = "";
+    gethostname(host, sizeof(host) - 1);
+    datos.push_back({"host", host});
+
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string linea, modelo;
+    while (std::getline(cpuinfo, linea)) {
+        if (linea.compare(0, 10, "model name") == 0) {
+            modelo = linea.substr(linea.find(':') + 2);
+            break;
+        }
+    }
+    datos.push_back({"cpu", modelo});
+    datos.push_back({"nucleos_logicos", std::to_string(std::thread::hardware_concurrency())});
+    datos.push_back({"sockets", std::to_string(montecarlo::topologia().sockets)});
+    datos.push_back({"nodos_numa", std::to_string(montecarlo::topologia().nodos)});
+    datos.push_back({"afinidad", montecarlo::nombre(montecarlo::afinidad_hilos)});
+#ifdef _OPENMP
+    datos.push_back({"hilos_openmp", std::to_string(omp_get_max_threads())});
+#endif
+    datos.push_back({"procesos_mpi", std::to_string(procesos_mpi)});
+#ifdef CON_MPI
+    char version[MPI_MAX_LIBRARY_VERSION_STRING];
+    int largo;
+    MPI_Get_library_version(version, &largo);
+    std::string mpi(version, largo);
+    datos.push_back({"mpi", mpi.substr(0, mpi.find(','))});
+#endif
+    datos.push_back({"compilador", __VERSION__});
+    datos.push_back({"simd", montecarlo::simd::nombre(montecarlo::simd::nivel())});
+    datos.push_back({"tamano_bloque", std::to_string(montecarlo::TAMANO_BLOQUE)});
+
+    char fecha[32];
+    std::time_t ahora = std::time(nullptr);
+    std::strftime(fecha, sizeof(fecha), "%Y-%m-%dT%H:%M:%S", std::localtime(&ahora));
+    datos.push_back({"fecha", fecha});
+    return datos;
+}
+
+int main(int argc, char* argv[]) {
+    int rank = 0, size = 1;
+#ifdef CON_MPI
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+#endif
+
+    std::string modo = "strong", salida = "escalabilidad", referencia;
+    long long n = 10000000;
+    int repeticiones = 7, calentamiento = 1;
+    double tolerancia = 0.10;
+    std::vector<int> dimensiones = {3};
+    std::vector<int> hilos, procesos;
+    std::vector<std::string> variantes = {"philox"};
+#ifdef CON_MPI
+    montecarlo::Afinidad afinidad = montecarlo::Afinidad::NINGUNA;
+#else
+    montecarlo::Afinidad afinidad = montecarlo::Afinidad::CERCANA;
+#endif
+    bool afinidad_valida = true;
+
+#ifdef _OPENMP
+    for (int t = 1; t <= omp_get_max_threads(); t++) hilos.push_back(t);
+#else
+    hilos.push_back(1);
+#endif
+    for (int p = 1; p <= size; p++) procesos.push_back(p);
+
+    // Cada opción lleva un valor; una desconocida o sin valor invalida la corrida
+    bool opciones_validas = argc % 2 == 1;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string opcion = argv[i];
+        std::string valor = argv[i + 1];
+        if (opcion == "--modo") modo = valor;
+        else if (opcion == "--n") n = (long long)atof(valor.c_str());
+        else if (opcion == "--d") dimensiones = leer_lista(valor);
+        else if (opcion == "--hilos") hilos = leer_lista(valor);
+        else if (opcion == "--procesos") procesos = leer_lista(valor);
+        else if (opcion == "--variantes") variantes = leer_nombres(valor);
+        else if (opcion == "--repeticiones") repeticiones = atoi(valor.c_str());
+        else if (opcion == "--calentamiento") calentamiento = atoi(valor.c_str());
+        else if (opcion == "--salida") salida = valor;
+        else if (opcion == "--referencia") referencia = valor;
+        else if (opcion == "--tolerancia") tolerancia = atof(valor.c_str());
+        else if (opcion == "--pin") afinidad_valida = montecarlo::leer_afinidad(valor.c_str(), afinidad);
+        else {
+            if (rank == 0) std::cerr << "Opción desconocida: " << opcion << std::endl;
+            opciones_validas = false;
+        }
+    }
+    if (!opciones_validas && argc % 2 == 0 && rank == 0) std::cerr << "Falta el valor de " << argv[argc - 1] << std::endl;
+
+    bool valido = opciones_validas && afinidad_valida && (modo == "strong" || modo == "weak") && n > 0 && repeticiones > 0 && calentamiento >= 0;
+    for (int d : dimensiones) valido = valido && d > 0;
+    for (int t : hilos) valido = valido && t > 0;
+    for (int p : procesos) valido = valido && p > 0 && p <= size;
+    for (const std::string& v : variantes) {
+        montecarlo::Parametros prueba;
+        valido = valido && leer_variante(v, prueba);
+    }
+    if (!valido) {
+        if (rank == 0) std::cerr << "Argumentos inválidos; ver el encabezado de bench_escalabilidad.cpp" << std::endl;
+#ifdef CON_MPI
+        MPI_Finalize();
+#endif
+        return 1;
+    }
+
+    // La topología se lee antes de fijar ningún hilo
+    montecarlo::afinidad_hilos = afinidad;
+    montecarlo::topologia();
+
+    // Se lee antes de medir: la referencia puede ser el mismo archivo de salida
+    std::map<std::string, Medicion> anteriores;
+    if (rank == 0 && !referencia.empty()) anteriores = leer_csv(referencia);
+
+    std::vector<Medicion> mediciones;
+    montecarlo::Gaussiana func;
+
+    for (const std::string& variante : variantes) {
+        for (int d : dimensiones) {
+            for (int p : procesos) {
+#ifdef CON_MPI
+                // Subcomunicador con los primeros p rangos; el resto espera
+                MPI_Comm grupo;
+                MPI_Comm_split(MPI_COMM_WORLD, rank < p ? 0 : MPI_UNDEFINED, rank, &grupo);
+                if (grupo == MPI_COMM_NULL) continue;
+#endif
+                for (int t : hilos) {
+#ifdef _OPENMP
+                    omp_set_num_threads(t);
+#endif
+                    montecarlo::Parametros parametros;
+                    leer_variante(variante, parametros);
+                    montecarlo::Dominio dominio{0.0, 1.0, d};
+
+                    // Débil: n muestras por núcleo
+                    const long long N = modo == "weak" ? n * p * t : n;
+                    const montecarlo::Rango rango = montecarlo::repartir_bloques(N, p, rank);
+
+                    std::vector<double> tiempos;
+                    for (int r = 0; r < calentamiento + repeticiones; r++) {
+#ifdef CON_MPI
+                        MPI_Barrier(grupo);
+#endif
+                        double t1 = montecarlo::tiempo();
+                        montecarlo::Replicas local = montecarlo::integrar(func, dominio, rango, parametros);
+#ifdef CON_MPI
+                        montecarlo::reducir(local, 0, grupo);
+#endif
+                        double transcurrido = montecarlo::tiempo() - t1;
+#ifdef CON_MPI
+                        // El tiempo de la configuración es el del proceso más lento
+                        double maximo;
+                        MPI_Reduce(&transcurrido, &maximo, 1, MPI_DOUBLE, MPI_MAX, 0, grupo);
+                        transcurrido = maximo;
+#endif
+                        if (r >= calentamiento) tiempos.push_back(transcurrido);
+                    }
+
+                    if (rank == 0) {
+                        Medicion m;
+                        m.modo = modo;
+                        m.variante = variante;
+                        m.dimensiones = d;
+                        m.procesos = p;
+                        m.hilos = t;
+                        m.sockets = montecarlo::sockets_ocupados(t);
+                        m.N = N;
+                        m.repeticiones = repeticiones;
+                        m.tiempo = resumir(tiempos);
+                        m.muestras_por_segundo = N / m.tiempo.mediana;
+                        mediciones.push_back(m);
+                    }
+                }
+#ifdef CON_MPI
+                MPI_Comm_free(&grupo);
+#endif
+            }
+        }
+    }
+
+    int codigo = 0;
+    if (rank == 0) {
+        // Speedup respecto de la configuración con menos núcleos de cada
+        // variante y dimensión. Fuerte: S = p0 T0 / T. Débil (Gustafson): la
+        // eficiencia es T0 / T y S = E p.
+        for (Medicion& m : mediciones) {
+            const Medicion* base = nullptr;
+            for (const Medicion& otra : mediciones) {
+                if (otra.variante == m.variante && otra.dimensiones == m.dimensiones &&
+                    (!base || otra.nucleos() < base->nucleos())) {
+                    base = &otra;
+                }
+            }
+            const double t0 = base->tiempo.mediana;
+            const double factor = modo == "weak" ? double(m.nucleos()) : double(base->nucleos());
+            m.speedup = factor * t0 / m.tiempo.mediana;
+            m.speedup_inferior = factor * t0 / m.tiempo.superior;
+            m.speedup_superior = factor * t0 / m.tiempo.inferior;
+            m.eficiencia = m.speedup / m.nucleos();
+        }
+
+        // Tabla por pantalla
+        std::cout << std::left << std::setw(9) << "variante" << std::right << std::setw(4) << "d" << std::setw(6)
+                  << "proc" << std::setw(6) << "hilos" << std::setw(5) << "sock" << std::setw(14) << "N" << std::setw(12) << "mediana"
+                  << std::setw(24) << "IC 95%" << std::setw(10) << "speedup" << std::setw(8) << "efic."
+                  << std::setw(14) << "muestras/s" << std::endl;
+        for (const Medicion& m : mediciones) {
+            std::ostringstream ic;
+            ic << std::setprecision(4) << "[" << m.tiempo.inferior << ", " << m.tiempo.superior << "]";
+            std::cout << std::left << std::setw(9) << m.variante << std::right << std::setw(4) << m.dimensiones
+                      << std::setw(6) << m.procesos << std::setw(6) << m.hilos << std::setw(5) << m.sockets << std::setw(14) << m.N
+                      << std::setw(12) << std::setprecision(4) << m.tiempo.mediana << std::setw(24) << ic.str()
+                      << std::setw(10) << std::setprecision(3) << m.speedup << std::setw(8) << m.eficiencia
+                      << std::setw(14) << std::setprecision(4) << m.muestras_por_segundo << std::endl;
+        }
+
+        const std::vector<GananciaSocket> ganancias = ganancias_por_socket(mediciones);
+        if (!ganancias.empty()) std::cout << "Ganancia por socket (" << montecarlo::nombre(afinidad) << "):" << std::endl;
+        for (const GananciaSocket& g : ganancias) {
+            std::cout << "  " << g.despues->variante << " d=" << g.despues->dimensiones << " proc=" << g.despues->procesos
+                      << ": " << g.antes->sockets << " -> " << g.despues->sockets << " sockets, " << g.antes->hilos
+                      << " -> " << g.despues->hilos << " hilos, speedup " << std::setprecision(3) << g.antes->speedup
+                      << " -> " << g.despues->speedup << " (x" << g.ganancia() << ", ideal x" << g.ideal() << ")"
+                      << std::endl;
+        }
+        if (ganancias.empty() && afinidad != montecarlo::Afinidad::NINGUNA) {
+            std::cout << "Todas las configuraciones caben en un socket: sin ganancia por socket" << std::endl;
+        }
+
+        std::ofstream csv(salida + ".csv");
+        csv << std::setprecision(9) << CABECERA_CSV << '\n';
+        for (const Medicion& m : mediciones) escribir_csv(csv, m);
+
+        std::ofstream json(salida + ".json");
+        json << std::setprecision(9) << "{\n  \"maquina\": {";
+        std::vector<std::pair<std::string, std::string>> datos = datos_maquina(size);
+        for (std::size_t i = 0; i < datos.size(); i++) {
+            json << (i ? ", " : "") << cadena_json(datos[i].first) << ": " << cadena_json(datos[i].second);
+        }
+        json << "},\n  \"resultados\": [\n";
+        for (std::size_t i = 0; i < mediciones.size(); i++) {
+            const Medicion& m = mediciones[i];
+            json << "    {\"modo\": " << cadena_json(m.modo) << ", \"variante\": " << cadena_json(m.variante)
+                 << ", \"d\": " << m.dimensiones << ", \"procesos\": " << m.procesos << ", \"hilos\": " << m.hilos
+                 << ", \"sockets\": " << m.sockets
+                 << ", \"N\": " << m.N << ", \"repeticiones\": " << m.repeticiones
+                 << ", \"mediana\": " << m.tiempo.mediana << ", \"ic\": [" << m.tiempo.inferior << ", "
+                 << m.tiempo.superior << "], \"speedup\": " << m.speedup << ", \"eficiencia\": " << m.eficiencia
+                 << ", \"muestras_por_segundo\": " << m.muestras_por_segundo << "}"
+                 << (i + 1 < mediciones.size() ? ",\n" : "\n");
+        }
+        json << "  ],\n  \"ganancia_por_socket\": [\n";
+        for (std::size_t i = 0; i < ganancias.size(); i++) {
+            const GananciaSocket& g = ganancias[i];
+            json << "    {\"variante\": " << cadena_json(g.despues->variante) << ", \"d\": " << g.despues->dimensiones
+                 << ", \"procesos\": " << g.despues->procesos << ", \"sockets\": " << g.despues->sockets
+                 << ", \"hilos\": [" << g.antes->hilos << ", " << g.despues->hilos << "], \"speedup\": ["
+                 << g.antes->speedup << ", " << g.despues->speedup << "], \"ganancia\": " << g.ganancia()
+                 << ", \"ideal\": " << g.ideal() << "}" << (i + 1 < ganancias.size() ? ",\n" : "\n");
+        }
+        json << "  ]\n}\n";
+
+        // Regresión: mediana más lenta que la tolerancia y con intervalos de
+        // confianza disjuntos, para no confundir ruido con una regresión
+        if (!referencia.empty()) {
+            int comparadas = 0, regresiones = 0;
+            for (const Medicion& m : mediciones) {
+                auto it = anteriores.find(m.clave());
+                if (it == anteriores.end()) continue;
+                const Medicion& antes = it->second;
+                comparadas++;
+                if (m.tiempo.mediana > antes.tiempo.mediana * (1.0 + tolerancia) &&
+                    m.tiempo.inferior > antes.tiempo.superior) {
+                    regresiones++;
+                    std::cout << "REGRESIÓN " << m.clave() << ": " << antes.tiempo.mediana << " s -> "
+                              << m.tiempo.mediana << " s" << std::endl;
+                }
+            }
+            std::cout << "Comparadas con " << referencia << ": " << comparadas << ", regresiones: " << regresiones
+                      << std::endl;
+            if (regresiones > 0) codigo = 1;
+        }
+    }
+
+#ifdef CON_MPI
+    MPI_Bcast(&codigo, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Finalize();
+#endif
+    return codigo;
+}
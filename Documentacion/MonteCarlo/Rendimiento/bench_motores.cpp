@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../integrador/montecarlo.hpp"
+
+// Micro-benchmark de los generadores uniformes: para cada motor mide
+//  - uniformes/s con el llenado masivo llenar() (un solo hilo)
+//  - muestras/s integrando la gaussiana en d dimensiones con integrar()
+//
+// Uso: ./bench_motores.x [--d dimensiones] [--n muestras]
+
+// Mejor de varias repeticiones, para filtrar ruido del sistema
+template <class Funcion>
+double mejor_tiempo(int repeticiones, Funcion&& funcion) {
+    double mejor = 1e300;
+    for (int r = 0; r < repeticiones; r++) {
+        double t1 = montecarlo::tiempo();
+        funcion();
+        double t2 = montecarlo::tiempo();
+        if (t2 - t1 < mejor) mejor = t2 - t1;
+    }
+    return mejor;
+}
+
+int main(int argc, char* argv[]) {
+    int dimensiones = 3;
+    long long N = 10000000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string opcion = argv[i];
+        if (opcion == "--d") dimensiones = atoi(argv[i + 1]);
+        else if (opcion == "--n") N = atoll(argv[i + 1]);
+    }
+
+    const montecarlo::Motor motores[] = {montecarlo::Motor::PHILOX, montecarlo::Motor::XOSHIRO,
+                                         montecarlo::Motor::PCG64, montecarlo::Motor::SPLITMIX,
+                                         montecarlo::Motor::MT64};
+    montecarlo::Dominio dominio{0.0, 1.0, dimensiones};
+    std::vector<double> buffer(4096);
+
+    std::cout << "SIMD: " << montecarlo::simd::nombre(montecarlo::simd::nivel())
+              << "  d = " << dimensiones << "  N = " << N << std::endl;
+    std::cout << std::left << std::setw(14) << "motor"
+              << std::right << std::setw(16) << "uniformes/s"
+              << std::setw(16) << "muestras/s"
+              << std::setw(14) << "integral" << std::endl;
+
+    for (montecarlo::Motor motor : motores) {
+        montecarlo::despachar_motor(motor, [&](auto tipo) {
+            using Flujo = typename decltype(tipo)::type;
+
+            // Generación pura: N*d uniformes en tramos que caben en L1
+            long long sorteos = N * dimensiones;
+            double suma = 0.0;
+            double t_llenado = mejor_tiempo(3, [&] {
+                Flujo flujo(12345, dimensiones);
+                flujo.posicionar(0);
+                for (long long hechos = 0; hechos < sorteos; hechos += buffer.size()) {
+                    std::size_t m = std::min<long long>(buffer.size(), sorteos - hechos);
+                    flujo.llenar(buffer.data(), m);
+                    suma += buffer[0];
+                }
+            });
+
+            // Integración completa (generación + evaluación + acumulación)
+            montecarlo::Momentos momentos;
+            double t_integral = mejor_tiempo(3, [&] {
+                momentos = montecarlo::integrar<Flujo>(montecarlo::Gaussiana{}, dominio, {0, N}, 12345);
+            });
+            montecarlo::Resultado r = montecarlo::estimar(momentos, N, dominio.volumen());
+
+            std::cout << std::left << std::setw(14) << montecarlo::nombre(motor)
+                      << std::right << std::scientific << std::setprecision(3)
+                      << std::setw(16) << sorteos / t_llenado
+                      << std::setw(16) << N / t_integral
+                      << std::fixed << std::setprecision(6)
+                      << std::setw(14) << r.integral << std::endl;
+            return suma;
+        });
+    }
+
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../integrador/montecarlo.hpp"
+
+// Validación de la precisión mixta (--precision mixed). Para cada integrando y
+// dimensión genera N puntos del flujo float de Philox (los mismos que usa la
+// precisión mixta) y evalúa cada punto dos veces: en float y en double. Como
+// un float es exacto en double, la diferencia media de las dos evaluaciones es
+// el sesgo de evaluar en float, medido sin ruido de muestreo. Se compara con el
+// error estadístico de la integral con esos N puntos.
+//
+// Para la gaussiana, cuya integral exacta se conoce, también compara la
+// estimación mixta con el valor exacto: eso incluye el sesgo de generar los
+// puntos con 23 bits (cada sorteo es el centro de una de 2^23 celdas).
+//
+// Uso: ./validar_precision.x [--n muestras] [--seed semilla] [--tolerancia 0.1]
+//
+// Termina con código 1 si en algún caso |sesgo| > tolerancia * error estadístico
+// o si la estimación mixta de la gaussiana se aleja más de 4 errores del valor exacto.
+
+// Sumas de las evaluaciones double y de la diferencia float - double
+struct Comparacion {
+    montecarlo::Momentos doble;
+    montecarlo::Momentos diferencia;
+    montecarlo::Momentos mixta;
+
+    Comparacion& operator+=(const Comparacion& otro) {
+        doble += otro.doble;
+        diferencia += otro.diferencia;
+        mixta += otro.mixta;
+        return *this;
+    }
+};
+
+template <class F>
+Comparacion comparar(const F& func, const montecarlo::Dominio& dominio, long long N, unsigned long long seed) {
+    using namespace montecarlo;
+    const std::size_t d = dominio.dimensiones;
+    const long long bloques = (N + TAMANO_BLOQUE - 1) / TAMANO_BLOQUE;
+    Comparacion total;
+
+    MONTECARLO_OMP(parallel)
+    {
+        FlujoPhilox flujo(seed, dominio.dimensiones);
+        EspacioLote espacio(dominio.dimensiones);
+        espacio.soa_float.resize(d * TAMANO_LOTE);
+        espacio.sorteos_float.resize(d * TAMANO_LOTE);
+        std::vector<float> valores_float(TAMANO_LOTE);
+        std::vector<double> diferencias(TAMANO_LOTE), mixtos(TAMANO_LOTE);
+        Comparacion local;
+
+        MONTECARLO_OMP(for schedule(dynamic) nowait)
+        for (long long b = 0; b < bloques; b++) {
+            long long inicio = b * TAMANO_BLOQUE;
+            long long fin = std::min(inicio + (long long)TAMANO_BLOQUE, N);
+            flujo.saltar_a_muestra(inicio);
+            for (long long hechos = inicio; hechos < fin; hechos += TAMANO_LOTE) {
+                std::size_t m = fin - hechos < (long long)TAMANO_LOTE ? std::size_t(fin - hechos) : TAMANO_LOTE;
+                llenar_lote_float(espacio.soa_float.data(), m, dominio, flujo, espacio);
+                for (std::size_t i = 0; i < m * d; i++) espacio.soa[i] = espacio.soa_float[i];
+
+                func.evaluar_lote(espacio.soa_float.data(), m, d, valores_float.data());
+                func.evaluar_lote(espacio.soa.data(), m, d, espacio.valores.data());
+                for (std::size_t i = 0; i < m; i++) {
+                    mixtos[i] = valores_float[i];
+                    diferencias[i] = mixtos[i] - espacio.valores[i];
+                }
+                local.doble += simd::sumar(espacio.valores.data(), m);
+                local.diferencia += simd::sumar(diferencias.data(), m);
+                local.mixta += simd::sumar(mixtos.data(), m);
+            }
+        }
+
+        MONTECARLO_OMP(critical)
+        total += local;
+    }
+    return total;
+}
+
+int main(int argc, char* argv[]) {
+    long long N = 100000000;
+    unsigned long long seed = 12345;
+    double tolerancia = 0.1;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string opcion = argv[i];
+        if (opcion == "--n") N = atoll(argv[i + 1]);
+        else if (opcion == "--seed") seed = strtoull(argv[i + 1], nullptr, 10);
+        else if (opcion == "--tolerancia") tolerancia = atof(argv[i + 1]);
+    }
+
+    struct Caso {
+        std::string texto;  // vacío: la gaussiana
+        int d;
+    };
+    const Caso casos[] = {
+        {"", 1}, {"", 2}, {"", 4}, {"", 8}, {"", 16},
+        {"prod(1 + x_i/i)*exp(-sum(x_i))", 4},
+        {"cos(sum(x_i))", 8},
+        {"1/(1 + sum(x_i^2))", 8},
+        {"sqrt(sum(x_i^2))*log(1 + x1)", 3},
+    };
+
+    std::cout << "SIMD: " << montecarlo::simd::nombre(montecarlo::simd::nivel()) << "  N = " << N
+              << "  dominio [0, 1]^d" << std::endl;
+    std::cout << std::left << std::setw(34) << "integrando" << std::right << std::setw(4) << "d"
+              << std::setw(14) << "integral" << std::setw(12) << "error" << std::setw(12) << "sesgo"
+              << std::setw(12) << "+-" << std::setw(11) << "sesgo/err" << std::setw(13) << "N(sesgo=err)"
+              << std::setw(11) << "z exacto" << std::endl;
+
+    bool valido = true;
+    for (const Caso& caso : casos) {
+        montecarlo::Dominio dominio{0.0, 1.0, caso.d};
+        Comparacion c;
+        if (caso.texto.empty()) {
+            c = comparar(montecarlo::Gaussiana{}, dominio, N, seed);
+        } else {
+            montecarlo::Expresion expresion;
+            std::string error;
+            if (!montecarlo::compilar_expresion(caso.texto, caso.d, expresion, error)) {
+                std::cerr << caso.texto << ": " << error << std::endl;
+                return 1;
+            }
+            c = comparar(expresion, dominio, N, seed);
+        }
+
+        montecarlo::Resultado doble = montecarlo::estimar(c.doble, N, dominio.volumen());
+        montecarlo::Resultado sesgo = montecarlo::estimar(c.diferencia, N, dominio.volumen());
+        montecarlo::Resultado mixta = montecarlo::estimar(c.mixta, N, dominio.volumen());
+        double relacion = std::fabs(sesgo.integral) / doble.error;
+        // El error baja como 1/sqrt(N): iguala al sesgo con N (error / sesgo)^2 puntos
+        double equilibrio = relacion > 0.0 ? N / (relacion * relacion) : INFINITY;
+
+        std::cout << std::left << std::setw(34) << (caso.texto.empty() ? "gaussiana" : caso.texto) << std::right
+                  << std::setw(4) << caso.d << std::setw(14) << std::setprecision(8) << doble.integral
+                  << std::setw(12) << std::setprecision(3) << doble.error << std::setw(12) << sesgo.integral
+                  << std::setw(12) << sesgo.error << std::setw(11) << relacion << std::setw(13) << equilibrio;
+        if (caso.texto.empty()) {
+            double exacto = std::pow(std::sqrt(M_PI) / 2 * std::erf(1.0), caso.d);
+            double z = (mixta.integral - exacto) / mixta.error;
+            std::cout << std::setw(11) << z;
+            if (std::fabs(z) > 4.0) valido = false;
+        } else {
+            std::cout << std::setw(11) << "-";
+        }
+        std::cout << std::setprecision(6) << std::endl;
+        if (relacion > tolerancia) valido = false;
+    }
+
+    std::cout << (valido ? "Sesgo de la precisión mixta por debajo de " : "FALLA: sesgo por encima de ")
+              << tolerancia << " veces el error estadístico" << std::endl;
+    return valido ? 0 : 1;
+}
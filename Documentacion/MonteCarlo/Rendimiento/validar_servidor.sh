@@ -0,0 +1,44 @@
+#!/bin/bash
+
+# Validación del servidor de trabajos (ServidorLotes). Corre entradas de una y
+# de varias rondas (líneas vacías y más de 4096 trabajos) con 1 a 4 hilos, con
+# un límite de tiempo: un servidor que no termina falla. Con varios hilos la
+# salida tiene que ser idéntica a la de un solo hilo.
+#
+# Uso: ./validar_servidor.sh (termina con código 1 si algún caso falla)
+
+echo "Compilando ServidorLotes.cpp..."
+g++ -O2 -std=c++17 -fopenmp ../ServidorLotes.cpp -o validar_servidor.x || { echo "Error"; exit 1; }
+
+DIRECTORIO=$(mktemp -d)
+trap 'rm -rf "$DIRECTORIO"' EXIT
+
+# Un trabajo y el final de la entrada justo después de una línea vacía
+printf 'gaussiana 0 1 3 1000\n\n' > "$DIRECTORIO/un_trabajo.txt"
+
+# Rondas cortadas por líneas vacías, con un registro inválido
+for r in 1 2 3; do
+    printf 'gaussiana 0 1 %d 20000 %d\n"x1*x2" -1 1 2 5000\ngaussiana 0 1 0 10\n\n' $r $r
+done > "$DIRECTORIO/rondas.txt"
+
+# Más trabajos que TRABAJOS_POR_RONDA
+for i in $(seq 1 5000); do echo "gaussiana 0 1 3 1000 $i"; done > "$DIRECTORIO/muchos.txt"
+
+ESTADO=0
+for CASO in un_trabajo rondas muchos; do
+    ENTRADA="$DIRECTORIO/$CASO.txt"
+    for HILOS in 1 2 3 4; do
+        SALIDA="$DIRECTORIO/$CASO.$HILOS.jsonl"
+        if ! OMP_NUM_THREADS=$HILOS timeout 60 ./validar_servidor.x "$ENTRADA" > "$SALIDA" 2> /dev/null; then
+            echo "FALLA: $CASO con $HILOS hilos no terminó"
+            ESTADO=1
+        elif ! cmp -s "$SALIDA" "$DIRECTORIO/$CASO.1.jsonl"; then
+            echo "FALLA: $CASO con $HILOS hilos difiere de un hilo"
+            ESTADO=1
+        fi
+    done
+    echo "$CASO: $(wc -l < "$DIRECTORIO/$CASO.1.jsonl") resultados"
+done
+
+[ $ESTADO -eq 0 ] && echo "Servidor validado"
+exit $ESTADO
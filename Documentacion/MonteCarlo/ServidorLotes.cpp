@@ -0,0 +1,39 @@
+#include <fstream>
+#include <iostream>
+
+#include "integrador/montecarlo.hpp"
+#include "integrador/trabajos.hpp"
+
+int main(int argc, char* argv[]) {
+
+    // Trabajos desde un archivo o, sin argumentos, desde la entrada estándar
+    if (argc > 2) {
+        std::cerr << "Usage: " << argv[0] << " [archivo de trabajos]" << std::endl;
+        return 1;
+    }
+
+    std::ifstream archivo;
+    if (argc == 2) {
+        archivo.open(argv[1]);
+        if (!archivo) {
+            std::cerr << "No se pudo abrir " << argv[1] << std::endl;
+            return 1;
+        }
+    }
+    std::istream& entrada = argc == 2 ? archivo : std::cin;
+
+    double time_1 = montecarlo::tiempo();
+
+    // Un único equipo de hilos atiende todos los trabajos; los resultados salen
+    // como líneas JSON por la salida estándar
+    long long trabajos = montecarlo::servir(entrada, std::cout);
+
+    double time_2 = montecarlo::tiempo();
+
+    // Estadísticas por la salida de errores, para no mezclarlas con el JSON
+    std::cerr << "Trabajos: " << trabajos << std::endl;
+    std::cerr << "Tiempo: " << time_2 - time_1 << std::endl;
+    std::cerr << "Trabajos por segundo: " << trabajos / (time_2 - time_1) << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,287 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "momentos.hpp"
+#include "motores.hpp"
+#include "nucleo.hpp"
+#include "paralelo.hpp"
+#include "parametros.hpp"
+
+namespace montecarlo {
+
+// Caché persistente de resultados (--cache directorio). Cada flujo está
+// indexado por muestra, así que los momentos de [0, N) de un integrando,
+// dominio, muestreo y semilla son siempre los mismos: se guardan en disco y
+// una corrida posterior los reutiliza. Si pide más muestras, integra solo las
+// que faltan, [N_anterior, N), y las combina con las guardadas.
+//
+// Una entrada por semilla (cada réplica usa la suya), en un archivo cuyo
+// nombre es el hash de la clave. La entrada guarda segmentos contiguos desde
+// la muestra 0, uno por cada extensión, con sus momentos: un N ya pedido
+// alguna vez es un acierto exacto, y un N intermedio reutiliza los segmentos
+// hasta la última frontera anterior.
+
+// Tramo contiguo de muestras de una entrada y sus momentos
+struct SegmentoCache {
+    Rango rango;
+    Momentos momentos;
+};
+
+struct EntradaCache {
+    std::string clave;  // completa, para descartar colisiones del hash
+    std::vector<SegmentoCache> segmentos;
+
+    long long fin() const { return segmentos.empty() ? 0 : segmentos.back().rango.fin; }
+};
+
+// FNV-1a de 64 bits
+inline std::uint64_t fnv1a(const void* datos, std::size_t bytes, std::uint64_t h = 14695981039346656037ull) {
+    const unsigned char* p = static_cast<const unsigned char*>(datos);
+    for (std::size_t i = 0; i < bytes; i++) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+inline std::string hexadecimal(std::uint64_t valor) {
+    char texto[17];
+    std::snprintf(texto, sizeof(texto), "%016llx", (unsigned long long)valor);
+    return texto;
+}
+
+// Identidad del integrando: la gaussiana, el texto de --expr o el contenido
+// de la biblioteca de --plugin (recompilarla invalida sus entradas)
+inline std::string identidad_integrando(const Parametros& p) {
+    if (!p.plugin.empty()) {
+        std::ifstream archivo(p.plugin, std::ios::binary);
+        std::vector<char> contenido((std::istreambuf_iterator<char>(archivo)), std::istreambuf_iterator<char>());
+        if (contenido.empty()) return "plugin:" + p.plugin;  // la encontró dlopen en otro directorio
+        return "plugin:" + hexadecimal(fnv1a(contenido.data(), contenido.size())) + ":" +
+               std::to_string(contenido.size());
+    }
+    if (!p.expresiones.empty()) return "expr:" + p.expresiones[0];
+    return "gaussiana";
+}
+
+// Integrando y precisión de la evaluación: junto con la semilla, el dominio y
+// el muestreo, determinan los momentos de un rango de muestras
+inline std::string identidad_evaluacion(const Parametros& p) {
+    return std::string("precision=") + (p.precision_mixta ? "mixed" : "double") +
+           " integrando=" + identidad_integrando(p);
+}
+
+// Clave de una réplica. Los límites van en hexadecimal (%a): dos límites
+// distintos nunca comparten clave por redondeo al imprimirlos.
+inline std::string clave_cache(const Parametros& p, unsigned long long seed) {
+    char dominio[128];
+    std::snprintf(dominio, sizeof(dominio), "li=%a ls=%a d=%d", p.lim_inf, p.lim_sup, p.dimensiones);
+    return std::string("MCCA1 ") + dominio + " motor=" + nombre(p.motor) +
+           " muestreo=" + std::to_string(int(p.muestreo)) + " seed=" + std::to_string(seed) + " " +
+           identidad_evaluacion(p);
+}
+
+inline std::string ruta_cache(const std::string& directorio, const std::string& clave) {
+    return directorio + "/" + hexadecimal(fnv1a(clave.data(), clave.size())) + ".mcc";
+}
+
+// Formato binario: firma, la clave con su largo y los segmentos
+constexpr char FIRMA_CACHE[8] = {'M', 'C', 'C', 'A', '0', '0', '0', '1'};
+
+inline bool cargar_entrada_cache(const std::string& ruta, EntradaCache& e) {
+    std::FILE* archivo = std::fopen(ruta.c_str(), "rb");
+    if (!archivo) return false;
+
+    bool ok = true;
+    auto leer = [&](void* datos, std::size_t bytes) {
+        ok = ok && std::fread(datos, 1, bytes, archivo) == bytes;
+    };
+    char firma[sizeof(FIRMA_CACHE)];
+    std::int64_t largo = 0, segmentos = 0;
+    leer(firma, sizeof(firma));
+    ok = ok && std::memcmp(firma, FIRMA_CACHE, sizeof(firma)) == 0;
+    leer(&largo, sizeof(largo));
+    if (ok && largo >= 0 && largo < (1 << 20)) {
+        e.clave.resize(std::size_t(largo));
+        leer(&e.clave[0], e.clave.size());
+    } else {
+        ok = false;
+    }
+    leer(&segmentos, sizeof(segmentos));
+    if (ok && segmentos >= 0) {
+        e.segmentos.resize(std::size_t(segmentos));
+        leer(e.segmentos.data(), e.segmentos.size() * sizeof(SegmentoCache));
+    }
+    std::fclose(archivo);
+
+    // Los segmentos tienen que ser contiguos desde 0
+    long long fin = 0;
+    for (const SegmentoCache& s : e.segmentos) {
+        ok = ok && s.rango.inicio == fin && s.rango.fin > fin && s.momentos.n == s.rango.tamano();
+        fin = s.rango.fin;
+    }
+    return ok && segmentos >= 0;
+}
+
+// Escribe en un temporal propio del proceso y renombra: quien lea la entrada
+// mientras tanto ve la anterior completa o la nueva completa
+inline bool guardar_entrada_cache(const std::string& ruta, const EntradaCache& e) {
+    const std::string temporal = ruta + ".tmp." + std::to_string(getpid());
+    std::FILE* archivo = std::fopen(temporal.c_str(), "wb");
+    if (!archivo) return false;
+
+    bool ok = true;
+    auto escribir = [&](const void* datos, std::size_t bytes) {
+        ok = ok && std::fwrite(datos, 1, bytes, archivo) == bytes;
+    };
+    const std::int64_t largo = std::int64_t(e.clave.size());
+    const std::int64_t segmentos = std::int64_t(e.segmentos.size());
+    escribir(FIRMA_CACHE, sizeof(FIRMA_CACHE));
+    escribir(&largo, sizeof(largo));
+    escribir(e.clave.data(), e.clave.size());
+    escribir(&segmentos, sizeof(segmentos));
+    escribir(e.segmentos.data(), e.segmentos.size() * sizeof(SegmentoCache));
+
+    ok = (std::fclose(archivo) == 0) && ok;
+    ok = ok && std::rename(temporal.c_str(), ruta.c_str()) == 0;
+    if (!ok) std::remove(temporal.c_str());
+    return ok;
+}
+
+// Cerrojo exclusivo (flock) sobre ruta.lock entre procesos que van a extender
+// la misma entrada. Se libera al destruirse o si el proceso muere.
+class CerrojoCache {
+public:
+    explicit CerrojoCache(const std::string& ruta) {
+        descriptor = open((ruta + ".lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+        if (descriptor < 0) return;
+        int r;
+        do {
+            r = flock(descriptor, LOCK_EX);
+        } while (r != 0 && errno == EINTR);
+        if (r != 0) {
+            close(descriptor);
+            descriptor = -1;
+        }
+    }
+
+    ~CerrojoCache() {
+        if (descriptor >= 0) close(descriptor);
+    }
+
+    CerrojoCache(const CerrojoCache&) = delete;
+    CerrojoCache& operator=(const CerrojoCache&) = delete;
+
+    bool tomado() const { return descriptor >= 0; }
+
+private:
+    int descriptor = -1;
+};
+
+// Una réplica frente a la caché. Al construirse lee la entrada (sin cerrojo:
+// el renombrado es atómico) y combina los segmentos que caben en [0, N). Si
+// falta muestrear más allá del fin de la entrada, toma el cerrojo y vuelve a
+// leerla, por si otro proceso la extendió mientras tanto: dos procesos que
+// piden lo mismo a la vez no integran dos veces las mismas muestras.
+class ConsultaCache {
+public:
+    ConsultaCache(const std::string& directorio, const std::string& clave, long long N)
+        : ruta(ruta_cache(directorio, clave)), clave(clave), N(N) {
+        if (mkdir(directorio.c_str(), 0777) != 0 && errno != EEXIST) {
+            std::cerr << "No se pudo crear el directorio de caché " << directorio << std::endl;
+            guardable = false;
+        }
+        leer();
+        if (desde < N && N > entrada.fin() && guardable) {
+            cerrojo.reset(new CerrojoCache(ruta));
+            if (cerrojo->tomado()) leer();
+            else guardable = false;
+        }
+    }
+
+    // Muestras que hay que integrar
+    Rango faltante() const { return {desde, N}; }
+
+    long long muestras_reutilizadas() const { return desde; }
+
+    // Combina los momentos de faltante() con los reutilizados. Si extienden la
+    // entrada, la guarda con un segmento nuevo y libera el cerrojo.
+    Momentos completar(const Momentos& nuevos) {
+        Momentos total = reutilizados;
+        total += nuevos;
+        if (cerrojo && desde < N && desde == entrada.fin()) {
+            entrada.segmentos.push_back({faltante(), nuevos});
+            if (!guardar_entrada_cache(ruta, entrada)) {
+                std::cerr << "No se pudo escribir la entrada de caché " << ruta << std::endl;
+            }
+        }
+        cerrojo.reset();
+        return total;
+    }
+
+private:
+    void leer() {
+        entrada = EntradaCache();
+        if (!cargar_entrada_cache(ruta, entrada) || entrada.clave != clave) entrada = EntradaCache();
+        entrada.clave = clave;
+        reutilizados = Momentos();
+        desde = 0;
+        for (const SegmentoCache& s : entrada.segmentos) {
+            if (s.rango.fin > N) break;
+            reutilizados += s.momentos;
+            desde = s.rango.fin;
+        }
+    }
+
+    std::string ruta, clave;
+    long long N;
+    bool guardable = true;
+    EntradaCache entrada;
+    Momentos reutilizados;
+    long long desde = 0;
+    std::unique_ptr<CerrojoCache> cerrojo;
+};
+
+// Momentos de cada réplica y muestras que salieron de la caché (de todas)
+struct ResultadoCache {
+    Replicas momentos;
+    long long reutilizadas = 0;
+};
+
+// Como integrar(func, dominio, {0, p.puntos_por_replica()}, p), con la caché
+// de p.cache: cada réplica reutiliza lo guardado e integra solo lo que falta
+template <class F>
+ResultadoCache integrar_con_cache(const F& func, const Dominio& dominio, const Parametros& p) {
+    ResultadoCache resultado;
+    for (int r = 0; r < p.replicas; r++) {
+        const unsigned long long seed = derivar_semilla(p.seed, r);
+        ConsultaCache consulta(p.cache, clave_cache(p, seed), p.puntos_por_replica());
+        Momentos nuevos;
+        if (consulta.faltante().tamano() > 0) {
+            nuevos = despachar_flujo(p, [&](auto tipo) {
+                using Flujo = typename decltype(tipo)::type;
+                return integrar<Flujo>(func, dominio, consulta.faltante(), seed);
+            });
+        }
+        resultado.reutilizadas += consulta.muestras_reutilizadas();
+        resultado.momentos.push_back(consulta.completar(nuevos));
+    }
+    return resultado;
+}
+
+} // namespace montecarlo
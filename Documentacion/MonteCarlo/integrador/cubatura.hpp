@@ -0,0 +1,361 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "instrumentacion.hpp"
+#include "lotes.hpp"
+#include "momentos.hpp"
+#include "nucleo.hpp"
+#include "openmp.hpp"
+#include "paralelo.hpp"
+#include "parametros.hpp"
+#include "topologia.hpp"
+
+namespace montecarlo {
+
+// Cubatura adaptativa determinista (--method cubature, o --method auto en
+// dimensión baja). Cada región rectangular se integra con una regla de grado
+// alto y otra de grado menor sobre los mismos puntos; la diferencia entre ambas
+// es el error estimado de la región. Las regiones con más error se bisecan,
+// desde un montículo, hasta que el error total baja de la tolerancia o se
+// agotan las N evaluaciones de --n.
+//
+// d = 1: Gauss-Kronrod 7-15 (15 puntos). d >= 2: Genz y Malik (1980), grado 7
+// con la regla de grado 5 anidada, 2^d + 2d^2 + 2d + 1 puntos; se corta por la
+// dimensión con mayor diferencia cuarta de f a lo largo del eje. Para f suave
+// el error baja como una potencia alta de las evaluaciones, no como N^{-1/2}.
+//
+// Las regiones que se bisecan en una ronda se eligen en orden de error, con un
+// máximo fijo por ronda, y sus hijas se evalúan juntas: en trozos de unas
+// TAMANO_LOTE evaluaciones (una región entera si tiene más puntos, evaluada en
+// varios evaluar_lote) repartidos entre hilos y procesos. Cada región se evalúa
+// siempre en el mismo trozo y en la misma posición, así que el resultado no
+// depende del número de hilos ni de procesos.
+
+// Tolerancia relativa sin --target-abs ni --target-rel: muy por debajo del
+// error de Monte Carlo con cualquier N razonable
+constexpr double TOLERANCIA_CUBATURA = 1e-8;
+
+// Regiones que se bisecan como máximo en una ronda
+constexpr std::size_t REGIONES_POR_RONDA = 256;
+
+// Regla de cubatura sobre [-1, 1]^d: nodos[j * d + k] es la coordenada k del
+// punto j. Los pesos están normalizados a suma 1 (se multiplican por el volumen
+// de la región). ejes[4k .. 4k+3] son los puntos c + l2 e_k, c - l2 e_k,
+// c + l3 e_k y c - l3 e_k, y cociente = l2^2 / l3^2, para la diferencia cuarta
+// que elige el corte.
+struct ReglaCubatura {
+    int dimensiones = 0;
+    int puntos = 0;
+    std::vector<double> nodos;
+    std::vector<double> pesos;
+    std::vector<double> pesos_bajos;
+    std::vector<int> ejes;
+    double cociente = 0.0;
+
+    void agregar(const std::vector<double>& nodo, double peso, double peso_bajo) {
+        nodos.insert(nodos.end(), nodo.begin(), nodo.end());
+        pesos.push_back(peso);
+        pesos_bajos.push_back(peso_bajo);
+        puntos++;
+    }
+};
+
+// Gauss-Kronrod 7-15 (QUADPACK, qk15): los 15 nodos de Kronrod, con los de
+// Gauss en las posiciones impares de la mitad positiva
+inline ReglaCubatura regla_gauss_kronrod() {
+    static const double nodos[8] = {0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+                                    0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+                                    0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+                                    0.207784955007898467600689403773245, 0.0};
+    static const double kronrod[8] = {0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+                                      0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+                                      0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+                                      0.204432940075298892414161999234649, 0.209482141084727828012999174891714};
+    static const double gauss[4] = {0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+                                    0.381830050505118944950369775488975, 0.417959183673469387755102040816327};
+
+    ReglaCubatura regla;
+    regla.dimensiones = 1;
+    for (int j = 0; j < 8; j++) {
+        const double peso = kronrod[j] / 2.0;
+        const double peso_bajo = j % 2 == 1 ? gauss[j / 2] / 2.0 : 0.0;
+        regla.agregar({nodos[j]}, peso, peso_bajo);
+        if (j < 7) regla.agregar({-nodos[j]}, peso, peso_bajo);
+    }
+    return regla;
+}
+
+// Genz-Malik de grado 7 y su regla anidada de grado 5 (d >= 2)
+inline ReglaCubatura regla_genz_malik(int d) {
+    const double l2 = std::sqrt(9.0 / 70.0);
+    const double l4 = std::sqrt(9.0 / 10.0);  // también l3
+    const double l5 = std::sqrt(9.0 / 19.0);
+    const double dd = double(d);
+
+    const double w1 = (12824.0 - 9120.0 * dd + 400.0 * dd * dd) / 19683.0;
+    const double w2 = 980.0 / 6561.0;
+    const double w3 = (1820.0 - 400.0 * dd) / 19683.0;
+    const double w4 = 200.0 / 19683.0;
+    const double w5 = 6859.0 / 19683.0 / std::ldexp(1.0, d);
+    const double b1 = (729.0 - 950.0 * dd + 50.0 * dd * dd) / 729.0;
+    const double b2 = 245.0 / 486.0;
+    const double b3 = (265.0 - 100.0 * dd) / 1458.0;
+    const double b4 = 25.0 / 729.0;
+
+    ReglaCubatura regla;
+    regla.dimensiones = d;
+    regla.cociente = l2 * l2 / (l4 * l4);
+    std::vector<double> nodo(d, 0.0);
+    regla.agregar(nodo, w1, b1);
+
+    for (int k = 0; k < d; k++) {
+        for (double x : {l2, -l2, l4, -l4}) {
+            nodo[k] = x;
+            regla.ejes.push_back(regla.puntos);
+            regla.agregar(nodo, std::fabs(x) == l2 ? w2 : w3, std::fabs(x) == l2 ? b2 : b3);
+        }
+        nodo[k] = 0.0;
+    }
+    for (int k = 0; k < d; k++) {
+        for (int l = k + 1; l < d; l++) {
+            for (double x : {l4, -l4}) {
+                for (double y : {l4, -l4}) {
+                    nodo[k] = x;
+                    nodo[l] = y;
+                    regla.agregar(nodo, w4, b4);
+                }
+            }
+            nodo[k] = nodo[l] = 0.0;
+        }
+    }
+    for (long long vertice = 0; vertice < (1LL << d); vertice++) {
+        for (int k = 0; k < d; k++) nodo[k] = (vertice >> k) & 1 ? -l5 : l5;
+        regla.agregar(nodo, w5, 0.0);
+    }
+    return regla;
+}
+
+inline ReglaCubatura regla_cubatura(int dimensiones) {
+    return dimensiones == 1 ? regla_gauss_kronrod() : regla_genz_malik(dimensiones);
+}
+
+inline const char* nombre_regla(int dimensiones) {
+    return dimensiones == 1 ? "Gauss-Kronrod 7-15" : "Genz-Malik, grado 7";
+}
+
+// Integral y error estimado de una región, y la dimensión por la que se corta
+struct EstimacionRegion {
+    double integral = 0.0;
+    double error = 0.0;
+    int corte = 0;
+};
+
+// Región [centro - semiancho, centro + semiancho]
+struct Region {
+    std::vector<double> centro;
+    std::vector<double> semiancho;
+    EstimacionRegion estimacion;
+};
+
+// Evalúa la regla en n regiones: los puntos de la región r ocupan las
+// posiciones [r * puntos, (r + 1) * puntos) de valores y se evalúan en lotes
+// de a lo sumo TAMANO_LOTE, el máximo de evaluar_lote (y de plugin_abi.h),
+// aunque una sola región tenga más puntos (d >= 8)
+template <int D, class F>
+void evaluar_regiones(const F& func, const ReglaCubatura& regla, const Region* regiones, std::size_t n,
+                      EstimacionRegion* estimaciones, std::vector<double>& soa, std::vector<double>& valores) {
+    const std::size_t d = std::size_t(regla.dimensiones);
+    const std::size_t P = std::size_t(regla.puntos);
+    const std::size_t m = n * P;
+    soa.resize(m * d);
+    valores.resize(m);
+
+    for (std::size_t inicio = 0; inicio < m; inicio += TAMANO_LOTE) {
+        const std::size_t lote = std::min(TAMANO_LOTE, m - inicio);
+        double* bloque = soa.data() + inicio * d;
+        for (std::size_t k = 0; k < d; k++) {
+            double* columna = bloque + k * lote;
+            for (std::size_t i = 0; i < lote; i++) {
+                const std::size_t r = (inicio + i) / P, j = (inicio + i) % P;
+                columna[i] = regiones[r].centro[k] + regiones[r].semiancho[k] * regla.nodos[j * d + k];
+            }
+        }
+        evaluar_soa<D>(func, bloque, lote, d, valores.data() + inicio);
+    }
+
+    for (std::size_t r = 0; r < n; r++) {
+        const double* f = valores.data() + r * P;
+        const Region& region = regiones[r];
+        double alta = 0.0, baja = 0.0, volumen = 1.0;
+        for (std::size_t j = 0; j < P; j++) {
+            alta += regla.pesos[j] * f[j];
+            baja += regla.pesos_bajos[j] * f[j];
+        }
+        for (std::size_t k = 0; k < d; k++) volumen *= 2.0 * region.semiancho[k];
+
+        // Corte por la mayor diferencia cuarta; si empatan, por la más ancha
+        int corte = 0;
+        double mayor = -1.0;
+        for (std::size_t k = 0; k < regla.ejes.size() / 4; k++) {
+            const int* e = regla.ejes.data() + 4 * k;
+            const double diferencia = std::fabs(f[e[0]] + f[e[1]] - 2.0 * f[0] -
+                                                regla.cociente * (f[e[2]] + f[e[3]] - 2.0 * f[0]));
+            if (diferencia > mayor || (diferencia == mayor && region.semiancho[k] > region.semiancho[corte])) {
+                mayor = diferencia;
+                corte = int(k);
+            }
+        }
+        estimaciones[r] = {volumen * alta, volumen * std::fabs(alta - baja), corte};
+    }
+}
+
+// Resultado de la cubatura: en resultado.muestras, las evaluaciones de f
+struct ResultadoCubatura {
+    Resultado resultado;
+    long long regiones = 0;
+    long long rondas = 0;
+    double tolerancia = 0.0;
+    bool convergida = false;
+};
+
+// Error que se pide: el de --target-abs / --target-rel o TOLERANCIA_CUBATURA relativa
+inline double tolerancia_cubatura(const Parametros& p, double integral) {
+    if (p.objetivo_abs <= 0.0 && p.objetivo_rel <= 0.0) return TOLERANCIA_CUBATURA * std::fabs(integral);
+    return std::fmax(p.objetivo_abs, p.objetivo_rel * std::fabs(integral));
+}
+
+// Cubatura adaptativa. repartir(trozos) da el rango de trozos de la ronda que
+// evalúa este proceso, reunir(estimaciones, por_trozo) completa las de los
+// demás y acordar(vencido) decide entre todos si se agotó --max-time: todos
+// los procesos llevan el mismo montículo y tienen que bisecar lo mismo.
+template <class F, class Repartir, class Reunir, class Acordar>
+ResultadoCubatura cubatura(const F& func, const Dominio& dominio, const Parametros& p, Repartir repartir,
+                           Reunir reunir, Acordar acordar) {
+    const int d = dominio.dimensiones;
+    const ReglaCubatura regla = regla_cubatura(d);
+    const long long P = regla.puntos;
+    const std::size_t por_trozo = std::max<std::size_t>(1, TAMANO_LOTE / std::size_t(P));
+    if (p.N < P) {
+        std::cerr << "--method cubature: --n tiene que alcanzar para las " << P << " evaluaciones de una región"
+                  << std::endl;
+        exit(1);
+    }
+    const double inicio_tiempo = tiempo();
+
+    // Montículo de regiones por error y las hijas de la ronda en curso
+    auto menor_error = [](const Region& a, const Region& b) { return a.estimacion.error < b.estimacion.error; };
+    std::vector<Region> regiones;
+    std::vector<Region> hijas(1);
+    hijas[0].centro.assign(d, 0.5 * (dominio.lim_inf + dominio.lim_sup));
+    hijas[0].semiancho.assign(d, 0.5 * dominio.ancho());
+    std::vector<EstimacionRegion> estimaciones;
+
+    ResultadoCubatura r;
+    double integral = 0.0, compensacion_integral = 0.0;
+    double error = 0.0, compensacion_error = 0.0;
+    long long evaluaciones = 0;
+
+    despachar_evaluacion<F>(d, [&](auto D) {
+        constexpr int DIM = decltype(D)::value;
+
+        // Evalúa las hijas (cada proceso sus trozos, con todos sus hilos) y las
+        // pasa al montículo
+        auto evaluar_ronda = [&]() {
+            const long long trozos = ((long long)hijas.size() + por_trozo - 1) / por_trozo;
+            const Rango local = repartir(trozos);
+            estimaciones.assign(hijas.size(), EstimacionRegion());
+
+            MONTECARLO_OMP(parallel)
+            {
+                fijar_hilo();
+                std::vector<double> soa, valores;
+                MONTECARLO_OMP(for schedule(dynamic))
+                for (long long t = local.inicio; t < local.fin; t++) {
+                    const std::size_t inicio = std::size_t(t) * por_trozo;
+                    const std::size_t fin = std::min(inicio + por_trozo, hijas.size());
+                    TramoInstrumentado tramo(Fase::BLOQUE, (long long)(fin - inicio) * P);
+                    evaluar_regiones<DIM>(func, regla, hijas.data() + inicio, fin - inicio,
+                                          estimaciones.data() + inicio, soa, valores);
+                }
+            }
+            {
+                TramoInstrumentado tramo(Fase::REDUCCION);
+                reunir(estimaciones, por_trozo);
+
+                for (std::size_t i = 0; i < hijas.size(); i++) {
+                    hijas[i].estimacion = estimaciones[i];
+                    sumar_compensado(integral, compensacion_integral, estimaciones[i].integral);
+                    sumar_compensado(error, compensacion_error, estimaciones[i].error);
+                    regiones.push_back(std::move(hijas[i]));
+                    std::push_heap(regiones.begin(), regiones.end(), menor_error);
+                }
+            }
+            evaluaciones += (long long)hijas.size() * P;
+            hijas.clear();
+            r.rondas++;
+        };
+
+        evaluar_ronda();
+        while (true) {
+            r.tolerancia = tolerancia_cubatura(p, integral + compensacion_integral);
+            if (error + compensacion_error <= r.tolerancia) {
+                r.convergida = true;
+                break;
+            }
+            if (p.tiempo_maximo > 0.0 && acordar(tiempo() - inicio_tiempo > p.tiempo_maximo)) break;
+
+            // Biseca las de más error hasta que el resto quepa en la tolerancia,
+            // o hasta el máximo de la ronda o de evaluaciones
+            while (!regiones.empty() && hijas.size() < 2 * REGIONES_POR_RONDA &&
+                   evaluaciones + ((long long)hijas.size() + 2) * P <= p.N) {
+                if (!hijas.empty() && error + compensacion_error <= r.tolerancia) break;
+                std::pop_heap(regiones.begin(), regiones.end(), menor_error);
+                Region region = std::move(regiones.back());
+                regiones.pop_back();
+                sumar_compensado(integral, compensacion_integral, -region.estimacion.integral);
+                sumar_compensado(error, compensacion_error, -region.estimacion.error);
+
+                const int k = region.estimacion.corte;
+                region.semiancho[k] *= 0.5;
+                Region otra = region;
+                region.centro[k] -= region.semiancho[k];
+                otra.centro[k] += otra.semiancho[k];
+                hijas.push_back(std::move(region));
+                hijas.push_back(std::move(otra));
+            }
+            if (hijas.empty()) break;  // no alcanzan las evaluaciones para otra ronda
+            evaluar_ronda();
+        }
+        return 0;
+    });
+
+    // Suma final en el orden del montículo, sin los restos de las restas
+    integral = compensacion_integral = error = compensacion_error = 0.0;
+    for (const Region& region : regiones) {
+        sumar_compensado(integral, compensacion_integral, region.estimacion.integral);
+        sumar_compensado(error, compensacion_error, region.estimacion.error);
+    }
+    r.resultado.integral = integral + compensacion_integral;
+    r.resultado.error = error + compensacion_error;
+    r.resultado.muestras = evaluaciones;
+    r.regiones = (long long)regiones.size();
+    return r;
+}
+
+// Cubatura con memoria compartida: todas las regiones en este proceso
+template <class F>
+ResultadoCubatura cubatura(const F& func, const Dominio& dominio, const Parametros& p) {
+    return cubatura(func, dominio, p,
+                    [](long long trozos) { return Rango{0, trozos}; },
+                    [](std::vector<EstimacionRegion>&, std::size_t) {},
+                    [](bool vencido) { return vencido; });
+}
+
+} // namespace montecarlo
@@ -0,0 +1,732 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <mpi.h>
+
+#include "cache.hpp"
+#include "cubatura.hpp"
+#include "ejecucion.hpp"
+#include "instrumentacion.hpp"
+#include "momentos.hpp"
+#include "nucleo.hpp"
+#include "objetivo.hpp"
+#include "parametros.hpp"
+#include "punto_control.hpp"
+#include "reduccion_varianza.hpp"
+#include "reporte.hpp"
+#include "templado.hpp"
+#include "vectorial.hpp"
+#include "vegas.hpp"
+
+namespace montecarlo {
+
+// Tipo MPI de Momentos: la cantidad (64 bits) y los cuatro doubles que la siguen
+inline MPI_Datatype tipo_momentos() {
+    static_assert(offsetof(Momentos, compensacion_m2) == offsetof(Momentos, media) + 3 * sizeof(double),
+                  "los doubles de Momentos deben ser contiguos");
+    static MPI_Datatype tipo = [] {
+        int largos[2] = {1, 4};
+        MPI_Aint desplazamientos[2] = {offsetof(Momentos, n), offsetof(Momentos, media)};
+        MPI_Datatype tipos[2] = {MPI_LONG_LONG, MPI_DOUBLE};
+        MPI_Datatype t, redimensionado;
+        MPI_Type_create_struct(2, largos, desplazamientos, tipos, &t);
+        // Extensión sizeof(Momentos), para reducir vectores de Momentos
+        MPI_Type_create_resized(t, 0, sizeof(Momentos), &redimensionado);
+        MPI_Type_free(&t);
+        MPI_Type_commit(&redimensionado);
+        return redimensionado;
+    }();
+    return tipo;
+}
+
+// salida[i] = entrada[i] + salida[i] con la combinación de Chan de Momentos
+inline void combinar_momentos(void* entrada, void* salida, int* cantidad, MPI_Datatype*) {
+    const Momentos* a = static_cast<const Momentos*>(entrada);
+    Momentos* b = static_cast<Momentos*>(salida);
+    for (int i = 0; i < *cantidad; i++) {
+        Momentos m = a[i];
+        m += b[i];
+        b[i] = m;
+    }
+}
+
+// Operación MPI de combinación de Momentos. Se declara no conmutativa para que
+// MPI combine siempre en orden de rango y el resultado sea determinista.
+inline MPI_Op operacion_momentos() {
+    static MPI_Op op = [] {
+        MPI_Op o;
+        MPI_Op_create(&combinar_momentos, 0, &o);
+        return o;
+    }();
+    return op;
+}
+
+// Con --profile, una barrera antes de reducir separa la espera por el proceso
+// más lento (desbalance entre procesos) del costo de la reducción
+inline void esperar_instrumentado(MPI_Comm comm) {
+    if (!instrumentacion_activa) return;
+    TramoInstrumentado espera(Fase::ESPERA);
+    MPI_Barrier(comm);
+}
+
+// Reducción de los momentos locales a momentos globales en el proceso raíz:
+// una sola MPI_Reduce de la estructura completa (cantidad, media, m2 y su
+// compensación), en árbol, sin que la raíz reciba un mensaje por proceso
+inline Momentos reducir(const Momentos& local, int raiz, MPI_Comm comm) {
+    esperar_instrumentado(comm);
+    TramoInstrumentado tramo(Fase::REDUCCION);
+    Momentos global;
+    MPI_Reduce(&local, &global, 1, tipo_momentos(), operacion_momentos(), raiz, comm);
+    return global;
+}
+
+// Todas las réplicas en la misma reducción
+inline Replicas reducir(const Replicas& local, int raiz, MPI_Comm comm) {
+    esperar_instrumentado(comm);
+    TramoInstrumentado tramo(Fase::REDUCCION);
+    Replicas global(local.size());
+    MPI_Reduce(local.data(), global.data(), int(local.size()), tipo_momentos(), operacion_momentos(), raiz, comm);
+    return global;
+}
+
+// Contador de bloques compartido, alojado en el proceso 0 y accedido con RMA
+// pasivo: cada proceso toma bloques con MPI_Fetch_and_op sin que el proceso 0
+// tenga que atender pedidos
+class ContadorBloques {
+public:
+    explicit ContadorBloques(MPI_Comm comm) {
+        int rank;
+        MPI_Comm_rank(comm, &rank);
+        MPI_Aint tamano = rank == 0 ? sizeof(long long) : 0;
+        MPI_Win_allocate(tamano, sizeof(long long), MPI_INFO_NULL, comm, &valor, &ventana);
+        MPI_Win_lock_all(0, ventana);
+        if (rank == 0) {
+            *valor = 0;
+            MPI_Win_sync(ventana);
+        }
+        MPI_Barrier(comm);
+    }
+
+    ~ContadorBloques() {
+        MPI_Win_unlock_all(ventana);
+        MPI_Win_free(&ventana);
+    }
+
+    ContadorBloques(const ContadorBloques&) = delete;
+    ContadorBloques& operator=(const ContadorBloques&) = delete;
+
+    // Suma cantidad al contador y devuelve el valor anterior (operación atómica)
+    long long tomar(long long cantidad) {
+        long long anterior;
+        MPI_Fetch_and_op(&cantidad, &anterior, MPI_LONG_LONG, 0, 0, MPI_SUM, ventana);
+        MPI_Win_flush(0, ventana);
+        return anterior;
+    }
+
+private:
+    long long* valor = nullptr;
+    MPI_Win ventana;
+};
+
+// Reparto dinámico de las muestras [0, N) entre procesos: cada proceso pide
+// tramos de bloques al contador compartido hasta agotarlos, así que los nodos
+// rápidos hacen más trabajo. El tamaño del tramo es guiado: una fracción
+// 1 / (2 size) de lo que queda, nunca menos de un bloque. Llama a tramo(rango)
+// con cada tramo que toma este proceso.
+template <class Tramo>
+void repartir_dinamico(long long N, MPI_Comm comm, Tramo&& tramo) {
+    int size;
+    MPI_Comm_size(comm, &size);
+
+    const long long ultimo = (N + TAMANO_BLOQUE - 1) / TAMANO_BLOQUE;
+    ContadorBloques contador(comm);
+
+    long long visto = 0;
+    while (true) {
+        long long pedido = std::max(1LL, (ultimo - visto) / (2LL * size));
+        long long primero = contador.tomar(pedido);
+        if (primero >= ultimo) break;
+        visto = primero + pedido;
+        tramo(Rango{primero * TAMANO_BLOQUE, std::min(visto * TAMANO_BLOQUE, N)});
+    }
+}
+
+// Integración con reparto dinámico. Los tramos son rangos de índices de
+// muestra, de modo que el resultado es el mismo que con el reparto estático.
+template <class Flujo, class F>
+Momentos integrar_dinamico(const F& func, const Dominio& dominio, long long N, unsigned long long seed,
+                           MPI_Comm comm) {
+    Momentos local;
+    repartir_dinamico(N, comm, [&](Rango rango) { local += integrar<Flujo>(func, dominio, rango, seed); });
+    return local;
+}
+
+// Igual que integrar(func, dominio, rango, p), con reparto dinámico entre
+// procesos: un contador por réplica
+template <class F>
+Replicas integrar_dinamico(const F& func, const Dominio& dominio, const Parametros& p, MPI_Comm comm) {
+    Replicas replicas;
+    for (int r = 0; r < p.replicas; r++) {
+        replicas.push_back(despachar_flujo(p, [&](auto tipo) {
+            using Flujo = typename decltype(tipo)::type;
+            return integrar_dinamico<Flujo>(func, dominio, p.puntos_por_replica(), derivar_semilla(p.seed, r), comm);
+        }));
+    }
+    return replicas;
+}
+
+// Integrando vectorial con N muestras repartidas entre procesos (estático o
+// dinámico, como el escalar); cada proceso devuelve los momentos de sus muestras
+template <class F>
+MomentosVectoriales integrar_vectorial(const F& func, const Dominio& dominio, long long N, const Parametros& p,
+                                       MPI_Comm comm) {
+    int size, rank;
+    MPI_Comm_size(comm, &size);
+    MPI_Comm_rank(comm, &rank);
+
+    return despachar_flujo(p, [&](auto tipo) {
+        using Flujo = typename decltype(tipo)::type;
+        if (!p.reparto_dinamico) return integrar_vectorial<Flujo>(func, dominio, repartir_bloques(N, size, rank), p.seed);
+        MomentosVectoriales local(func.salidas());
+        repartir_dinamico(N, comm, [&](Rango rango) { local += integrar_vectorial<Flujo>(func, dominio, rango, p.seed); });
+        return local;
+    });
+}
+
+template <class F>
+MomentosVectoriales integrar_vectorial(const F& func, const Dominio& dominio, const Parametros& p, MPI_Comm comm) {
+    return integrar_vectorial(func, dominio, p.N, p, comm);
+}
+
+// Variables antitéticas o de control repartidas entre procesos. Cada proceso
+// devuelve sus momentos y co-momentos; el coeficiente de control se estima
+// después de reducirlos, con los momentos globales.
+template <class F>
+MomentosVectoriales integrar_con_reduccion(const F& func, const Dominio& dominio, const Parametros& p, MPI_Comm comm) {
+    return despachar_reduccion(func, dominio, p, [&](const auto& reducido) {
+        return integrar_vectorial(reducido, dominio, p.muestras_reduccion(), p, comm);
+    });
+}
+
+// MomentosVectoriales como bloque de bytes: K, los K Momentos y los
+// co-momentos seguidos de su compensación
+inline std::size_t tamano_serializado(int K) {
+    std::size_t pares = std::size_t(K) * (K - 1) / 2;
+    return sizeof(long long) + std::size_t(K) * sizeof(Momentos) + 2 * pares * sizeof(double);
+}
+
+inline void serializar(const MomentosVectoriales& m, char* datos) {
+    long long K = m.K;
+    std::memcpy(datos, &K, sizeof(K));
+    datos += sizeof(K);
+    std::memcpy(datos, m.componentes.data(), m.componentes.size() * sizeof(Momentos));
+    datos += m.componentes.size() * sizeof(Momentos);
+    std::memcpy(datos, m.comomentos.data(), m.comomentos.size() * sizeof(double));
+    datos += m.comomentos.size() * sizeof(double);
+    std::memcpy(datos, m.compensacion.data(), m.compensacion.size() * sizeof(double));
+}
+
+inline MomentosVectoriales deserializar(const char* datos) {
+    long long K;
+    std::memcpy(&K, datos, sizeof(K));
+    datos += sizeof(K);
+    MomentosVectoriales m(static_cast<int>(K));
+    std::memcpy(m.componentes.data(), datos, m.componentes.size() * sizeof(Momentos));
+    datos += m.componentes.size() * sizeof(Momentos);
+    std::memcpy(m.comomentos.data(), datos, m.comomentos.size() * sizeof(double));
+    datos += m.comomentos.size() * sizeof(double);
+    std::memcpy(m.compensacion.data(), datos, m.compensacion.size() * sizeof(double));
+    return m;
+}
+
+// salida[i] = entrada[i] + salida[i] para MomentosVectoriales serializados;
+// cada elemento es un bloque de tamano_serializado(K) bytes
+inline void combinar_vectoriales(void* entrada, void* salida, int* cantidad, MPI_Datatype* tipo) {
+    int tamano;
+    MPI_Type_size(*tipo, &tamano);
+    for (int i = 0; i < *cantidad; i++) {
+        char* b = static_cast<char*>(salida) + std::size_t(i) * tamano;
+        MomentosVectoriales m = deserializar(static_cast<const char*>(entrada) + std::size_t(i) * tamano);
+        m += deserializar(b);
+        serializar(m, b);
+    }
+}
+
+// No conmutativa, como operacion_momentos
+inline MPI_Op operacion_vectoriales() {
+    static MPI_Op op = [] {
+        MPI_Op o;
+        MPI_Op_create(&combinar_vectoriales, 0, &o);
+        return o;
+    }();
+    return op;
+}
+
+// Las K componentes y sus co-momentos en una sola MPI_Reduce, con un tipo de
+// bytes del tamaño de la estructura serializada
+inline MomentosVectoriales reducir(const MomentosVectoriales& local, int raiz, MPI_Comm comm) {
+    esperar_instrumentado(comm);
+    TramoInstrumentado tramo(Fase::REDUCCION);
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    const std::size_t tamano = tamano_serializado(local.K);
+    std::vector<char> envio(tamano), recibido(tamano);
+    serializar(local, envio.data());
+
+    MPI_Datatype tipo;
+    MPI_Type_contiguous(int(tamano), MPI_BYTE, &tipo);
+    MPI_Type_commit(&tipo);
+    MPI_Reduce(envio.data(), recibido.data(), 1, tipo, operacion_vectoriales(), raiz, comm);
+    MPI_Type_free(&tipo);
+
+    return rank == raiz ? deserializar(recibido.data()) : MomentosVectoriales(local.K);
+}
+
+// Puntos de control con MPI: cada proceso escribe p.punto_control.<rango>. Al
+// reanudar, todos leen los archivos de la corrida anterior (que pudo usar otro
+// número de procesos) y omiten la unión de sus rangos; los momentos del archivo
+// k los hereda el proceso k % size, así que cada muestra se cuenta una vez.
+template <class F>
+Momentos integrar_con_punto_control(const F& func, const Dominio& dominio, const Parametros& p, MPI_Comm comm) {
+    int size, rank;
+    MPI_Comm_size(comm, &size);
+    MPI_Comm_rank(comm, &rank);
+
+    auto ruta = [&](int proceso) { return p.punto_control + "." + std::to_string(proceso); };
+    auto abortar = [&](const std::string& mensaje) {
+        std::cerr << mensaje << std::endl;
+        MPI_Abort(comm, 1);
+    };
+
+    EstadoPuntoControl estado = estado_inicial(p, size, rank);
+    Intervalos excluidos;
+    if (p.reanudar) {
+        EstadoPuntoControl primero;
+        if (!cargar_punto_control(ruta(0), primero)) abortar("No se pudo leer el punto de control " + ruta(0));
+        for (int k = 0; k < primero.procesos; k++) {
+            EstadoPuntoControl anterior;
+            if (!cargar_punto_control(ruta(k), anterior) || anterior.procesos != primero.procesos) {
+                abortar("No se pudo leer el punto de control " + ruta(k));
+            }
+            std::string error = validar_punto_control(p, anterior);
+            if (!error.empty()) abortar(error);
+
+            excluidos.agregar(anterior.hechos);
+            if (k % size == rank) {
+                estado.momentos += anterior.momentos;
+                estado.hechos.agregar(anterior.hechos);
+            }
+        }
+        // Nadie reescribe un archivo que otro proceso todavía está leyendo
+        MPI_Barrier(comm);
+    }
+
+    PuntoControl control(ruta(rank), p.intervalo_punto_control, std::move(estado), std::move(excluidos));
+    despachar_flujo(p, [&](auto tipo) {
+        using Flujo = typename decltype(tipo)::type;
+        if (!p.reparto_dinamico) {
+            control.integrar<Flujo>(func, dominio, repartir_bloques(p.N, size, rank), p.seed);
+            return 0;
+        }
+        // Mismos tramos guiados que integrar_dinamico
+        repartir_dinamico(p.N, comm, [&](Rango rango) { control.integrar<Flujo>(func, dominio, rango, p.seed); });
+        return 0;
+    });
+    control.guardar();
+    return control.momentos();
+}
+
+// Caché con MPI: solo el proceso 0 lee y escribe la entrada (y toma el
+// cerrojo); difunde la primera muestra que falta y los procesos se reparten
+// [desde, N) en bloques. El resultado (válido en el proceso 0) combina lo
+// reutilizado con la reducción de lo integrado.
+template <class F>
+ResultadoCache integrar_con_cache(const F& func, const Dominio& dominio, const Parametros& p, MPI_Comm comm) {
+    int size, rank;
+    MPI_Comm_size(comm, &size);
+    MPI_Comm_rank(comm, &rank);
+
+    const long long N = p.puntos_por_replica();
+    ResultadoCache resultado;
+    for (int r = 0; r < p.replicas; r++) {
+        const unsigned long long seed = derivar_semilla(p.seed, r);
+        std::unique_ptr<ConsultaCache> consulta;
+        long long desde = 0;
+        if (rank == 0) {
+            consulta.reset(new ConsultaCache(p.cache, clave_cache(p, seed), N));
+            desde = consulta->faltante().inicio;
+        }
+        MPI_Bcast(&desde, 1, MPI_LONG_LONG, 0, comm);
+
+        // Bloques absolutos, los mismos que en una corrida sin caché
+        const Rango parte = repartir_bloques(Rango{desde, N}, size, rank);
+        Momentos local;
+        if (parte.tamano() > 0) {
+            local = despachar_flujo(p, [&](auto tipo) {
+                using Flujo = typename decltype(tipo)::type;
+                return integrar<Flujo>(func, dominio, parte, seed);
+            });
+        }
+        Momentos nuevos = reducir(local, 0, comm);
+        if (rank == 0) {
+            resultado.reutilizadas += desde;
+            resultado.momentos.push_back(consulta->completar(nuevos));
+        }
+    }
+    return resultado;
+}
+
+// Reducción de una iteración de VEGAS en todos los procesos: cada uno recibe los
+// parciales de los demás y los combina en orden de rango, así que todos refinan
+// exactamente la misma rejilla
+inline IteracionVegas reducir_todos(const IteracionVegas& local, MPI_Comm comm) {
+    int size;
+    MPI_Comm_size(comm, &size);
+
+    const std::size_t celdas = local.histograma.size();
+    // La cantidad viaja como double: es exacta hasta 2^53 muestras por iteración
+    const std::size_t largo = 5 + 2 * celdas;
+    std::vector<double> envio(largo);
+    envio[0] = double(local.momentos.n);
+    envio[1] = local.momentos.media;
+    envio[2] = local.momentos.m2;
+    envio[3] = local.momentos.compensacion_media;
+    envio[4] = local.momentos.compensacion_m2;
+    std::copy(local.histograma.begin(), local.histograma.end(), envio.begin() + 5);
+    std::copy(local.compensacion.begin(), local.compensacion.end(), envio.begin() + 5 + celdas);
+
+    std::vector<double> recibidos(largo * size);
+    MPI_Allgather(envio.data(), int(largo), MPI_DOUBLE, recibidos.data(), int(largo), MPI_DOUBLE, comm);
+
+    IteracionVegas global(int(celdas / RejillaVegas::INTERVALOS));
+    IteracionVegas parcial(int(celdas / RejillaVegas::INTERVALOS));
+    for (int r = 0; r < size; r++) {
+        const double* datos = recibidos.data() + r * largo;
+        parcial.momentos.n = (long long)datos[0];
+        parcial.momentos.media = datos[1];
+        parcial.momentos.m2 = datos[2];
+        parcial.momentos.compensacion_media = datos[3];
+        parcial.momentos.compensacion_m2 = datos[4];
+        std::copy(datos + 5, datos + 5 + celdas, parcial.histograma.begin());
+        std::copy(datos + 5 + celdas, datos + largo, parcial.compensacion.begin());
+        global += parcial;
+    }
+    return global;
+}
+
+// VEGAS con memoria distribuida: cada iteración se reparte en bloques entre los
+// procesos y se reduce en todos antes de refinar la rejilla
+template <class F>
+Resultado vegas(const F& func, const Dominio& dominio, const Parametros& p, MPI_Comm comm) {
+    int size, rank;
+    MPI_Comm_size(comm, &size);
+    MPI_Comm_rank(comm, &rank);
+    return vegas(func, dominio, p,
+                 [&](long long n) { return repartir_bloques(n, size, rank); },
+                 [&](const IteracionVegas& iteracion) { return reducir_todos(iteracion, comm); });
+}
+
+// Cubatura adaptativa con memoria distribuida: cada proceso evalúa un tramo
+// contiguo de los trozos de cada ronda y todos reciben las estimaciones de
+// todos, así que llevan el mismo montículo. El proceso 0 decide si se agotó
+// --max-time.
+template <class F>
+ResultadoCubatura cubatura(const F& func, const Dominio& dominio, const Parametros& p, MPI_Comm comm) {
+    static_assert(std::is_trivially_copyable<EstimacionRegion>::value, "EstimacionRegion viaja como bytes");
+    int size, rank;
+    MPI_Comm_size(comm, &size);
+    MPI_Comm_rank(comm, &rank);
+
+    auto reunir = [&](std::vector<EstimacionRegion>& estimaciones, std::size_t por_trozo) {
+        const long long trozos = ((long long)estimaciones.size() + por_trozo - 1) / por_trozo;
+        std::vector<int> cantidades(size), desplazamientos(size);
+        for (int r = 0; r < size; r++) {
+            const Rango tramo = repartir(trozos, size, r);
+            const std::size_t inicio = std::min(std::size_t(tramo.inicio) * por_trozo, estimaciones.size());
+            const std::size_t fin = std::min(std::size_t(tramo.fin) * por_trozo, estimaciones.size());
+            cantidades[r] = int((fin - inicio) * sizeof(EstimacionRegion));
+            desplazamientos[r] = int(inicio * sizeof(EstimacionRegion));
+        }
+        esperar_instrumentado(comm);
+        MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, estimaciones.data(), cantidades.data(),
+                       desplazamientos.data(), MPI_BYTE, comm);
+    };
+    auto acordar = [&](bool vencido) {
+        int decision = vencido ? 1 : 0;
+        MPI_Bcast(&decision, 1, MPI_INT, 0, comm);
+        return decision != 0;
+    };
+    return cubatura(func, dominio, p, [&](long long trozos) { return repartir(trozos, size, rank); }, reunir,
+                    acordar);
+}
+
+// Templado paralelo con memoria distribuida: cada proceso corre un tramo
+// contiguo de grupos de escaleras y el proceso 0 reúne las estadísticas de
+// todas las escaleras, en orden, para estimar como con memoria compartida. El
+// resultado solo es válido en el proceso 0.
+template <class F>
+ResultadoTemplado templado(const F& func, const Dominio& dominio, const Parametros& p, MPI_Comm comm) {
+    static_assert(std::is_trivially_copyable<EstadisticaTemperatura>::value,
+                  "EstadisticaTemperatura viaja como bytes");
+    int size, rank;
+    MPI_Comm_size(comm, &size);
+    MPI_Comm_rank(comm, &rank);
+
+    const long long grupos = grupos_templado(p);
+    std::vector<EstadisticaTemperatura> local = templar(func, dominio, repartir(grupos, size, rank), p);
+
+    // Bytes de cada proceso: sus grupos de escaleras por T temperaturas
+    const long long por_grupo = (long long)sizeof(EstadisticaTemperatura) * CADENAS_POR_GRUPO * p.temperaturas;
+    std::vector<int> cantidades(size), desplazamientos(size);
+    for (int r = 0; r < size; r++) {
+        const Rango tramo = repartir(grupos, size, r);
+        cantidades[r] = int(tramo.tamano() * por_grupo);
+        desplazamientos[r] = int(tramo.inicio * por_grupo);
+    }
+    std::vector<EstadisticaTemperatura> escaleras(rank == 0 ? std::size_t(grupos) * CADENAS_POR_GRUPO * p.temperaturas : 0);
+
+    esperar_instrumentado(comm);
+    MPI_Gatherv(local.data(), cantidades[rank], MPI_BYTE, escaleras.data(), cantidades.data(), desplazamientos.data(),
+                MPI_BYTE, 0, comm);
+    if (rank != 0) return ResultadoTemplado();
+    return estimar_templado(escaleras, p, dominio.volumen());
+}
+
+// Crecimiento de los tramos de la precisión objetivo: cada ronda integra entre
+// todos los procesos 1 / FRACCION_RONDA_OBJETIVO de lo ya integrado
+constexpr long long FRACCION_RONDA_OBJETIVO = 8;
+
+// Bloques por proceso en la ronda que empieza en el bloque primero de [0, ultimo):
+// al principio uno por hilo y después una fracción de lo ya integrado, así que la
+// parada, que llega una ronda tarde, se pasa a lo sumo en una fracción acotada de
+// las muestras. Guiado como repartir_dinamico, nunca más que lo que queda.
+inline long long bloques_ronda_objetivo(long long primero, long long ultimo, int size, int hilos) {
+    const long long restantes = (ultimo - primero + size - 1) / size;
+    return std::min(restantes, std::max<long long>(hilos, primero / (FRACCION_RONDA_OBJETIVO * size)));
+}
+
+// Precisión objetivo con memoria distribuida. En cada ronda el proceso r integra
+// el r-ésimo tramo de bloques_ronda_objetivo bloques y, mientras calcula, una
+// reducción no bloqueante (MPI_Iallreduce) combina las instantáneas de todos. Al completarse, cada proceso
+// evalúa el criterio sobre los mismos momentos, así que todos se detienen en la misma
+// ronda sin esperar a nadie; solo quien ya no tiene tramos espera la reducción.
+// El resultado final (válido en el proceso 0) incluye todo lo integrado.
+template <class Flujo, class F>
+ResultadoObjetivo integrar_hasta_objetivo(const F& func, const Dominio& dominio, const Parametros& p, MPI_Comm comm) {
+    int size, rank;
+    MPI_Comm_size(comm, &size);
+    MPI_Comm_rank(comm, &rank);
+
+    const double volumen = dominio.volumen();
+    const long long ultimo = (p.N + TAMANO_BLOQUE - 1) / TAMANO_BLOQUE;
+    const double inicio_tiempo = MPI_Wtime();
+
+    // Todos los procesos tienen que calcular las mismas rondas
+    int hilos = hilos_disponibles();
+    MPI_Allreduce(MPI_IN_PLACE, &hilos, 1, MPI_INT, MPI_MAX, comm);
+
+    Momentos local;
+    bool sin_tramos = false;
+    bool alcanzado = false;
+
+    // Instantánea: los momentos de todos (con la operación de Chan) y, en una
+    // segunda reducción, procesos sin tramos y tiempo transcurrido en el proceso 0.
+    // Los buffers de envío no cambian mientras las reducciones están en curso.
+    Momentos enviados, instantanea;
+    double envio[2], suma[2];
+    MPI_Request pedidos[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+
+    for (long long ronda = 0;;) {
+        if (!sin_tramos) {
+            if (ronda >= ultimo) {
+                sin_tramos = true;
+            } else {
+                const long long bloques = bloques_ronda_objetivo(ronda, ultimo, size, hilos);
+                const long long primero = std::min(ronda + rank * bloques, ultimo);
+                const long long fin = std::min(primero + bloques, ultimo);
+                ronda += size * bloques;
+                if (primero < fin) {
+                    Rango rango{primero * TAMANO_BLOQUE, std::min(fin * TAMANO_BLOQUE, p.N)};
+                    local += integrar<Flujo>(func, dominio, rango, p.seed);
+                }
+            }
+        }
+
+        if (pedidos[0] != MPI_REQUEST_NULL) {
+            int completo = 0;
+            if (sin_tramos) {
+                MPI_Waitall(2, pedidos, MPI_STATUSES_IGNORE);
+                completo = 1;
+            } else {
+                MPI_Testall(2, pedidos, &completo, MPI_STATUSES_IGNORE);
+            }
+            if (!completo) continue;
+
+            alcanzado = objetivo_cumplido(p, instantanea, volumen);
+            if (alcanzado || suma[0] >= size || (p.tiempo_maximo > 0.0 && suma[1] > p.tiempo_maximo)) break;
+        }
+
+        enviados = local;
+        envio[0] = sin_tramos ? 1.0 : 0.0;
+        envio[1] = rank == 0 ? MPI_Wtime() - inicio_tiempo : 0.0;
+        MPI_Iallreduce(&enviados, &instantanea, 1, tipo_momentos(), operacion_momentos(), comm, &pedidos[0]);
+        MPI_Iallreduce(envio, suma, 2, MPI_DOUBLE, MPI_SUM, comm, &pedidos[1]);
+    }
+
+    // Reducción final de todo lo integrado: los momentos llevan su cantidad de
+    // muestras, así que basta la misma reducción de reducir
+    Momentos global = reducir(local, 0, comm);
+    if (rank != 0) return ResultadoObjetivo{};
+    ResultadoObjetivo r;
+    r.resultado = estimar(global, global.n, volumen);
+    r.tolerancia = tolerancia_objetivo(p, r.resultado.integral);
+    r.alcanzado = alcanzado;
+    return r;
+}
+
+// Igual que la anterior, con el motor y la semilla de la línea de comando
+template <class F>
+ResultadoObjetivo integrar_hasta_objetivo(const F& func, const Dominio& dominio, const Parametros& p, MPI_Comm comm) {
+    return despachar_motor(p.motor, [&](auto tipo) {
+        using Flujo = typename decltype(tipo)::type;
+        return integrar_hasta_objetivo<Flujo>(func, dominio, p, comm);
+    });
+}
+
+// Textos de todos los procesos en la raíz, en orden de rango
+inline std::vector<std::string> reunir_textos(const std::string& texto, int raiz, MPI_Comm comm) {
+    int size, rank;
+    MPI_Comm_size(comm, &size);
+    MPI_Comm_rank(comm, &rank);
+
+    int largo = int(texto.size());
+    std::vector<int> largos(size), desplazamientos(size);
+    MPI_Gather(&largo, 1, MPI_INT, largos.data(), 1, MPI_INT, raiz, comm);
+
+    int total = 0;
+    for (int i = 0; i < size; i++) {
+        desplazamientos[i] = total;
+        total += largos[i];
+    }
+    std::vector<char> todo(rank == raiz ? total : 0);
+    MPI_Gatherv(texto.data(), largo, MPI_CHAR, todo.data(), largos.data(), desplazamientos.data(), MPI_CHAR, raiz,
+                comm);
+
+    std::vector<std::string> textos;
+    if (rank == raiz) {
+        for (int i = 0; i < size; i++) textos.emplace_back(todo.data() + desplazamientos[i], largos[i]);
+    }
+    return textos;
+}
+
+// Corrida completa con MPI: los procesos se reparten las muestras (o las
+// regiones, o las cadenas) de cada método y el resultado queda en el proceso 0.
+// El mismo --seed da el mismo resultado con cualquier cantidad de procesos.
+inline Ejecucion ejecutar(const Parametros& p, MPI_Comm comm) {
+    int size, rank;
+    MPI_Comm_size(comm, &size);
+    MPI_Comm_rank(comm, &rank);
+
+    // MISER reparte su árbol de regiones entre hilos, no entre procesos
+    if (p.miser) {
+        if (rank == 0) std::cerr << "--miser solo está disponible con memoria compartida" << std::endl;
+        MPI_Finalize();
+        exit(1);
+    }
+
+    Dominio dominio{p.lim_inf, p.lim_sup, p.dimensiones};
+
+    // Con --store, cada proceso guarda sus bloques en su propio archivo
+    CapturaMuestras captura(p, rank, size);
+
+    // Varias --expr: las K integrales sobre un único flujo de puntos
+    if (p.vectorial()) {
+        Expresion func = compilar_expresiones(p);
+        MomentosVectoriales global = reducir(integrar_vectorial(func, dominio, p, comm), 0, comm);
+        if (rank != 0) return ResultadoVectorial{};
+        return estimar(global, p.N, dominio.volumen());
+    }
+
+    // Integrando: la gaussiana, la expresión de --expr o el plugin de --plugin
+    return despachar_integrando(p, [&](const auto& func) -> Ejecucion {
+        if (p.templado()) {
+            // Cada proceso corre sus escaleras de cadenas y el 0 combina las
+            // estadísticas por temperatura
+            return templado(func, dominio, p, comm);
+        }
+        if (p.cubatura()) {
+            // Los procesos se reparten las regiones de cada ronda
+            return cubatura(func, dominio, p, comm);
+        }
+        if (p.iteraciones_vegas > 0) {
+            // Cada iteración se reparte entre procesos y se reduce en todos
+            return vegas(func, dominio, p, comm);
+        }
+        if (p.modo_objetivo()) {
+            // Muestreo hasta la precisión pedida, con reducciones no bloqueantes
+            return integrar_hasta_objetivo(func, dominio, p, comm);
+        }
+        if (p.reduccion_varianza()) {
+            // Se reducen momentos y co-momentos, y el coeficiente óptimo se
+            // estima con los globales
+            MomentosVectoriales global = reducir(integrar_con_reduccion(func, dominio, p, comm), 0, comm);
+            if (rank != 0) return Resultado{};
+            return estimar_con_reduccion(global, p, dominio);
+        }
+        if (!p.punto_control.empty()) {
+            // Puntos de control por proceso; con --resume se omite lo ya integrado
+            Momentos global = reducir(integrar_con_punto_control(func, dominio, p, comm), 0, comm);
+            if (rank != 0) return Resultado{};
+            return estimar(global, p.N, dominio.volumen());
+        }
+        if (!p.cache.empty()) {
+            // El proceso 0 consulta --cache y todos integran solo las muestras que faltan
+            ResultadoCache cache = integrar_con_cache(func, dominio, p, comm);
+            if (rank != 0) return Resultado{};
+            Resultado resultado = estimar(cache.momentos, p.puntos_por_replica(), dominio.volumen());
+            resultado.muestras_cache = cache.reutilizadas;
+            return resultado;
+        }
+
+        // Misma semilla en todos los procesos: cada uno genera exactamente los
+        // puntos de su rango alineado a bloques, o de los tramos que pide a un
+        // contador compartido con --schedule dynamic
+        Replicas local = p.reparto_dinamico
+            ? integrar_dinamico(func, dominio, p, comm)
+            : integrar(func, dominio, repartir_bloques(p.puntos_por_replica(), size, rank), p);
+
+        // Reducción de los momentos locales a momentos globales
+        Replicas global = reducir(local, 0, comm);
+        if (rank != 0) return Resultado{};
+        return estimar(global, p.puntos_por_replica(), dominio.volumen());
+    });
+}
+
+// Con --profile, el proceso 0 imprime la tabla de cada proceso y escribe una
+// sola traza con un pid por proceso
+inline void reportar_instrumentacion(const Parametros& p, MPI_Comm comm) {
+    if (!instrumentacion_activa) return;
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    std::vector<std::string> resumenes = reunir_textos(instrumentacion().resumen(rank), 0, comm);
+    std::vector<std::string> eventos = reunir_textos(instrumentacion().eventos_json(rank), 0, comm);
+    if (rank == 0) {
+        for (const std::string& resumen : resumenes) std::cout << resumen;
+        std::string todos;
+        for (const std::string& e : eventos) todos += (todos.empty() ? "" : ",\n") + e;
+        escribir_traza(p.perfil, todos);
+    }
+}
+
+} // namespace montecarlo
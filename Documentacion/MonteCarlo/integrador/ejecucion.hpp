@@ -0,0 +1,83 @@
+#pragma once
+
+#include <variant>
+
+#include "cache.hpp"
+#include "cubatura.hpp"
+#include "expresion.hpp"
+#include "miser.hpp"
+#include "momentos.hpp"
+#include "muestras.hpp"
+#include "nucleo.hpp"
+#include "objetivo.hpp"
+#include "parametros.hpp"
+#include "plugin.hpp"
+#include "punto_control.hpp"
+#include "reduccion_varianza.hpp"
+#include "reporte.hpp"
+#include "templado.hpp"
+#include "vectorial.hpp"
+#include "vegas.hpp"
+
+namespace montecarlo {
+
+// Resultado de una corrida: cada método devuelve su propio tipo
+using Ejecucion = std::variant<Resultado, ResultadoVectorial, ResultadoObjetivo, ResultadoTemplado, ResultadoCubatura>;
+
+// Corrida completa en memoria compartida con el método y el integrando que
+// pide p. Los hilos se reparten bloques de muestras de flujos indexados, así
+// que el resultado no depende de la cantidad de hilos.
+inline Ejecucion ejecutar(const Parametros& p) {
+    Dominio dominio{p.lim_inf, p.lim_sup, p.dimensiones};
+
+    // Con --store, guarda los puntos y los valores de f de cada bloque
+    CapturaMuestras captura(p);
+
+    // Varias --expr: las K integrales sobre un único flujo de puntos
+    if (p.vectorial()) {
+        Expresion func = compilar_expresiones(p);
+        MomentosVectoriales momentos = integrar_vectorial(func, dominio, {0, p.N}, p);
+        return estimar(momentos, p.N, dominio.volumen());
+    }
+
+    // Integrando: la gaussiana, la expresión de --expr o el plugin de --plugin
+    return despachar_integrando(p, [&](const auto& func) -> Ejecucion {
+        if (p.templado()) {
+            // Cadenas de Markov en una escalera de temperaturas
+            return templado(func, dominio, p);
+        }
+        if (p.cubatura()) {
+            // Dimensión baja: cubatura adaptativa determinista en lugar de muestreo
+            return cubatura(func, dominio, p);
+        }
+        if (p.iteraciones_vegas > 0) return vegas(func, dominio, p);
+        if (p.miser) return miser(func, dominio, p);
+        if (p.modo_objetivo()) return integrar_hasta_objetivo(func, dominio, p);
+        if (p.reduccion_varianza()) {
+            // Pares antitéticos o variable de control, con el coeficiente óptimo
+            MomentosVectoriales momentos = integrar_con_reduccion(func, dominio, {0, p.muestras_reduccion()}, p);
+            return estimar_con_reduccion(momentos, p, dominio);
+        }
+        if (!p.punto_control.empty()) {
+            // Corrida larga con puntos de control periódicos (y --resume)
+            Momentos momentos = integrar_con_punto_control(func, dominio, p);
+            return estimar(momentos, p.N, dominio.volumen());
+        }
+        if (!p.cache.empty()) {
+            // Momentos guardados en --cache: solo se integran las muestras que faltan
+            ResultadoCache cache = integrar_con_cache(func, dominio, p);
+            Resultado resultado = estimar(cache.momentos, p.puntos_por_replica(), dominio.volumen());
+            resultado.muestras_cache = cache.reutilizadas;
+            return resultado;
+        }
+        Replicas momentos = integrar(func, dominio, {0, p.puntos_por_replica()}, p);
+        return estimar(momentos, p.puntos_por_replica(), dominio.volumen());
+    });
+}
+
+// Reporte del resultado de ejecutar(), según el método
+inline void imprimir_resultados(const Parametros& p, const Ejecucion& ejecucion) {
+    std::visit([&](const auto& resultado) { imprimir_resultados(p, resultado); }, ejecucion);
+}
+
+} // namespace montecarlo
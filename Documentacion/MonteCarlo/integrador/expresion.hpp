@@ -0,0 +1,719 @@
+#pragma once
+
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "lotes.hpp"
+#include "simd.hpp"
+
+namespace montecarlo {
+
+// Integrandos escritos en la línea de comando (--expr "exp(-sum(x_i^2))").
+// El texto se analiza una vez, se reduce a un grafo sin subexpresiones repetidas
+// (plegado de constantes y simplificaciones exactas al construirlo) y se traduce
+// a código de registros que recorre los bloques SoA del motor por lotes: cada
+// instrucción es un bucle sobre las m muestras del lote, así que el costo de
+// interpretar se paga una vez por lote y no por punto.
+
+// Operaciones de los nodos del grafo y de las instrucciones
+enum class Operacion : std::uint8_t {
+    CONSTANTE, COORDENADA, COPIAR, SUMAR_PRODUCTO,
+    SUMAR, RESTAR, MULTIPLICAR, DIVIDIR, POTENCIA, MINIMO, MAXIMO,
+    NEGAR, EXP, LOG, RAIZ, SENO, COSENO, TANGENTE, ABSOLUTO
+};
+
+inline bool es_binaria(Operacion op) {
+    return op >= Operacion::SUMAR && op <= Operacion::MAXIMO;
+}
+
+// Valor escalar de una operación (plegado de constantes y respaldo punto a punto)
+inline double aplicar(Operacion op, double x, double y = 0.0) {
+    switch (op) {
+        case Operacion::SUMAR: return x + y;
+        case Operacion::RESTAR: return x - y;
+        case Operacion::MULTIPLICAR: return x * y;
+        case Operacion::DIVIDIR: return x / y;
+        case Operacion::POTENCIA: return std::pow(x, y);
+        case Operacion::MINIMO: return x < y ? x : y;
+        case Operacion::MAXIMO: return x > y ? x : y;
+        case Operacion::NEGAR: return -x;
+        case Operacion::EXP: return std::exp(x);
+        case Operacion::LOG: return std::log(x);
+        case Operacion::RAIZ: return std::sqrt(x);
+        case Operacion::SENO: return std::sin(x);
+        case Operacion::COSENO: return std::cos(x);
+        case Operacion::TANGENTE: return std::tan(x);
+        case Operacion::ABSOLUTO: return std::fabs(x);
+        default: return x;
+    }
+}
+
+// Instrucción de la máquina de registros. a, b, c y destino son filas: [0, d)
+// las coordenadas del lote, [d, d + registros) los registros y d + registros la
+// salida. Un operando -1 es la constante de la instrucción. Solo SUMAR_PRODUCTO
+// (a + b * c) usa c.
+struct Instruccion {
+    Operacion op;
+    int destino;
+    int a;
+    int b;
+    int c;
+    double constante;
+};
+
+namespace detalle {
+
+// Nodo del árbol sintáctico; las sumas y productos sobre i se expanden al
+// bajar al grafo, cuando se conoce d
+struct Sintaxis {
+    enum Tipo { NUMERO, COORDENADA, COORDENADA_INDICE, INDICE, DIMENSION, OPERACION, SUMA, PRODUCTO };
+    Tipo tipo;
+    Operacion op = Operacion::CONSTANTE;
+    int a = -1;
+    int b = -1;
+    double valor = 0.0;
+};
+
+// Descenso recursivo sobre
+//   expresion := termino (('+' | '-') termino)*
+//   termino   := unario (('*' | '/') unario)*
+//   unario    := ('-' | '+') unario | potencia
+//   potencia  := primario (('^' | '**') unario)?
+//   primario  := numero | nombre | funcion '(' argumentos ')' | '(' expresion ')'
+// Cada regla devuelve el índice del nodo o -1 con el motivo en error.
+class Analizador {
+public:
+    Analizador(const std::string& texto, int dimensiones) : texto(texto), dimensiones(dimensiones) {}
+
+    int analizar() {
+        int raiz = expresion();
+        if (raiz < 0) return -1;
+        espacios();
+        if (pos < texto.size()) return fallar(std::string("carácter inesperado '") + texto[pos] + "'");
+        return raiz;
+    }
+
+    std::vector<Sintaxis> nodos;
+    std::string error;
+
+private:
+    int nodo(Sintaxis s) {
+        nodos.push_back(s);
+        return int(nodos.size()) - 1;
+    }
+
+    int operacion(Operacion op, int a, int b = -1) {
+        Sintaxis s{Sintaxis::OPERACION};
+        s.op = op;
+        s.a = a;
+        s.b = b;
+        return nodo(s);
+    }
+
+    int fallar(const std::string& motivo) {
+        if (error.empty()) error = motivo + " (posición " + std::to_string(pos + 1) + ")";
+        return -1;
+    }
+
+    void espacios() {
+        while (pos < texto.size() && std::isspace((unsigned char)texto[pos])) pos++;
+    }
+
+    bool aceptar(const char* simbolo) {
+        espacios();
+        std::size_t largo = std::strlen(simbolo);
+        if (texto.compare(pos, largo, simbolo) != 0) return false;
+        pos += largo;
+        return true;
+    }
+
+    int expresion() {
+        int a = termino();
+        while (a >= 0) {
+            if (aceptar("+")) a = binaria(Operacion::SUMAR, a, termino());
+            else if (aceptar("-")) a = binaria(Operacion::RESTAR, a, termino());
+            else break;
+        }
+        return a;
+    }
+
+    int termino() {
+        int a = unario();
+        while (a >= 0) {
+            espacios();
+            if (texto.compare(pos, 2, "**") == 0) break;
+            if (aceptar("*")) a = binaria(Operacion::MULTIPLICAR, a, unario());
+            else if (aceptar("/")) a = binaria(Operacion::DIVIDIR, a, unario());
+            else break;
+        }
+        return a;
+    }
+
+    int unario() {
+        if (aceptar("-")) {
+            int a = unario();
+            return a < 0 ? -1 : operacion(Operacion::NEGAR, a);
+        }
+        if (aceptar("+")) return unario();
+        return potencia();
+    }
+
+    int potencia() {
+        int a = primario();
+        if (a >= 0 && (aceptar("^") || aceptar("**"))) a = binaria(Operacion::POTENCIA, a, unario());
+        return a;
+    }
+
+    int binaria(Operacion op, int a, int b) {
+        return b < 0 ? -1 : operacion(op, a, b);
+    }
+
+    int primario() {
+        espacios();
+        if (pos >= texto.size()) return fallar("fin inesperado de la expresión");
+
+        char c = texto[pos];
+        if (std::isdigit((unsigned char)c) || c == '.') {
+            const char* inicio = texto.c_str() + pos;
+            char* fin;
+            double valor = std::strtod(inicio, &fin);
+            if (fin == inicio) return fallar("número inválido");
+            pos += fin - inicio;
+            Sintaxis s{Sintaxis::NUMERO};
+            s.valor = valor;
+            return nodo(s);
+        }
+
+        if (aceptar("(")) {
+            int a = expresion();
+            if (a < 0) return -1;
+            if (!aceptar(")")) return fallar("se esperaba ')'");
+            return a;
+        }
+
+        if (!std::isalpha((unsigned char)c)) return fallar(std::string("carácter inesperado '") + c + "'");
+        std::size_t inicio = pos;
+        while (pos < texto.size() && (std::isalnum((unsigned char)texto[pos]) || texto[pos] == '_')) pos++;
+        std::string nombre = texto.substr(inicio, pos - inicio);
+
+        espacios();
+        if (pos < texto.size() && texto[pos] == '(') {
+            pos = inicio;
+            return funcion(nombre);
+        }
+        return variable(nombre, inicio);
+    }
+
+    // x_k o xk (coordenada k, desde 1), x_i (coordenada del índice de sum/prod),
+    // i, d, pi y e
+    int variable(const std::string& nombre, std::size_t inicio) {
+        if (nombre == "pi" || nombre == "e") {
+            Sintaxis s{Sintaxis::NUMERO};
+            s.valor = nombre == "pi" ? 3.14159265358979323846 : 2.71828182845904523536;
+            return nodo(s);
+        }
+        if (nombre == "d") return nodo(Sintaxis{Sintaxis::DIMENSION});
+        if (nombre == "i" || nombre == "x_i") {
+            if (!dentro_de_suma) {
+                pos = inicio;
+                return fallar(nombre + " solo puede usarse dentro de sum(...) o prod(...)");
+            }
+            return nodo(Sintaxis{nombre == "i" ? Sintaxis::INDICE : Sintaxis::COORDENADA_INDICE});
+        }
+        if (nombre[0] == 'x') {
+            std::size_t digitos = nombre.size() > 1 && nombre[1] == '_' ? 2 : 1;
+            if (digitos < nombre.size() &&
+                nombre.find_first_not_of("0123456789", digitos) == std::string::npos) {
+                long k = std::strtol(nombre.c_str() + digitos, nullptr, 10);
+                if (k < 1 || k > dimensiones) {
+                    pos = inicio;
+                    return fallar("la coordenada " + nombre + " no existe con d = " + std::to_string(dimensiones));
+                }
+                Sintaxis s{Sintaxis::COORDENADA};
+                s.valor = double(k);
+                return nodo(s);
+            }
+        }
+        pos = inicio;
+        return fallar("nombre desconocido '" + nombre + "'");
+    }
+
+    int funcion(const std::string& nombre) {
+        static const std::map<std::string, Operacion> unarias = {
+            {"exp", Operacion::EXP}, {"log", Operacion::LOG}, {"sqrt", Operacion::RAIZ},
+            {"sin", Operacion::SENO}, {"cos", Operacion::COSENO}, {"tan", Operacion::TANGENTE},
+            {"abs", Operacion::ABSOLUTO}};
+        static const std::map<std::string, Operacion> binarias = {
+            {"pow", Operacion::POTENCIA}, {"min", Operacion::MINIMO}, {"max", Operacion::MAXIMO}};
+
+        std::size_t inicio = pos;
+        pos += nombre.size();
+        aceptar("(");
+
+        int a = -1, b = -1;
+        if (nombre == "sum" || nombre == "prod") {
+            if (dentro_de_suma) {
+                pos = inicio;
+                return fallar("sum y prod no se pueden anidar");
+            }
+            dentro_de_suma = true;
+            a = expresion();
+            dentro_de_suma = false;
+        } else if (unarias.count(nombre) || binarias.count(nombre)) {
+            a = expresion();
+            if (a >= 0 && binarias.count(nombre)) {
+                if (!aceptar(",")) return fallar(nombre + " recibe dos argumentos");
+                b = expresion();
+            }
+        } else {
+            pos = inicio;
+            return fallar("función desconocida '" + nombre + "'");
+        }
+        if (a < 0 || (binarias.count(nombre) && b < 0)) return -1;
+        if (!aceptar(")")) return fallar("se esperaba ')'");
+
+        if (nombre == "sum" || nombre == "prod") {
+            Sintaxis s{nombre == "sum" ? Sintaxis::SUMA : Sintaxis::PRODUCTO};
+            s.a = a;
+            return nodo(s);
+        }
+        if (unarias.count(nombre)) return operacion(unarias.at(nombre), a);
+        return operacion(binarias.at(nombre), a, b);
+    }
+
+    const std::string& texto;
+    int dimensiones;
+    std::size_t pos = 0;
+    bool dentro_de_suma = false;
+};
+
+// Nodo del grafo: a y b son nodos anteriores (COORDENADA guarda k en a), así
+// que el orden de creación ya es un orden topológico
+struct Nodo {
+    Operacion op;
+    int a;
+    int b;
+    double valor;
+};
+
+// Grafo con consolidación de nodos: crear devuelve el nodo existente si ya hay
+// uno igual (eliminación de subexpresiones comunes) y aplica el plegado de
+// constantes y las identidades exactas x + 0, x * 1, x^1, --x, etc.
+class Grafo {
+public:
+    std::vector<Nodo> nodos;
+
+    int constante(double valor) { return buscar({Operacion::CONSTANTE, -1, -1, valor}); }
+    int coordenada(int k) { return buscar({Operacion::COORDENADA, k, -1, 0.0}); }
+
+    bool es_constante(int n) const { return nodos[n].op == Operacion::CONSTANTE; }
+    bool es_constante(int n, double valor) const { return es_constante(n) && nodos[n].valor == valor; }
+
+    int crear(Operacion op, int a, int b = -1) {
+        const bool binaria = es_binaria(op);
+        if (es_constante(a) && (!binaria || es_constante(b))) {
+            return constante(aplicar(op, nodos[a].valor, binaria ? nodos[b].valor : 0.0));
+        }
+
+        switch (op) {
+            case Operacion::SUMAR:
+                if (es_constante(a, 0.0)) return b;
+                if (es_constante(b, 0.0)) return a;
+                break;
+            case Operacion::RESTAR:
+                if (es_constante(b, 0.0)) return a;
+                if (es_constante(a, 0.0)) return crear(Operacion::NEGAR, b);
+                break;
+            case Operacion::MULTIPLICAR:
+                if (es_constante(a, 1.0)) return b;
+                if (es_constante(b, 1.0)) return a;
+                if (es_constante(a, -1.0)) return crear(Operacion::NEGAR, b);
+                if (es_constante(b, -1.0)) return crear(Operacion::NEGAR, a);
+                break;
+            case Operacion::DIVIDIR:
+                if (es_constante(b, 1.0)) return a;
+                break;
+            case Operacion::POTENCIA:
+                if (es_constante(b)) return potencia_constante(a, nodos[b].valor);
+                // c^x = e^(x ln c)
+                if (es_constante(a) && nodos[a].valor > 0.0) {
+                    return crear(Operacion::EXP, crear(Operacion::MULTIPLICAR, b, constante(std::log(nodos[a].valor))));
+                }
+                break;
+            case Operacion::NEGAR:
+                if (nodos[a].op == Operacion::NEGAR) return nodos[a].a;
+                break;
+            case Operacion::ABSOLUTO:
+                if (nodos[a].op == Operacion::NEGAR) return crear(Operacion::ABSOLUTO, nodos[a].a);
+                if (nodos[a].op == Operacion::ABSOLUTO) return a;
+                break;
+            default:
+                break;
+        }
+
+        // Orden canónico de los operandos de las operaciones conmutativas
+        if ((op == Operacion::SUMAR || op == Operacion::MULTIPLICAR || op == Operacion::MINIMO ||
+             op == Operacion::MAXIMO) && a > b) {
+            std::swap(a, b);
+        }
+        return buscar({op, a, b, 0.0});
+    }
+
+private:
+    // x^c: potencias enteras por cuadrados sucesivos (x^2 es x*x), x^0.5 es sqrt
+    int potencia_constante(int x, double c) {
+        if (c == 0.0) return constante(1.0);
+        if (c == 1.0) return x;
+        if (c == 0.5) return crear(Operacion::RAIZ, x);
+        if (c == -0.5) return crear(Operacion::DIVIDIR, constante(1.0), crear(Operacion::RAIZ, x));
+        if (c == std::floor(c) && std::fabs(c) <= 64.0) {
+            long e = long(std::fabs(c));
+            int resultado = -1, factor = x;
+            while (e > 0) {
+                if (e & 1) resultado = resultado < 0 ? factor : crear(Operacion::MULTIPLICAR, resultado, factor);
+                e >>= 1;
+                if (e > 0) factor = crear(Operacion::MULTIPLICAR, factor, factor);
+            }
+            return c > 0.0 ? resultado : crear(Operacion::DIVIDIR, constante(1.0), resultado);
+        }
+        return buscar({Operacion::POTENCIA, x, constante(c), 0.0});
+    }
+
+    int buscar(const Nodo& n) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &n.valor, sizeof(bits));
+        auto clave = std::make_tuple(int(n.op), n.a, n.b, bits);
+        auto encontrado = indice.find(clave);
+        if (encontrado != indice.end()) return encontrado->second;
+        nodos.push_back(n);
+        indice[clave] = int(nodos.size()) - 1;
+        return int(nodos.size()) - 1;
+    }
+
+    std::map<std::tuple<int, int, int, std::uint64_t>, int> indice;
+};
+
+// Árbol sintáctico -> grafo, con sum/prod expandidos para i = 1..d
+inline int bajar(const std::vector<Sintaxis>& arbol, int n, int indice, int dimensiones, Grafo& grafo) {
+    const Sintaxis& s = arbol[n];
+    switch (s.tipo) {
+        case Sintaxis::NUMERO: return grafo.constante(s.valor);
+        case Sintaxis::DIMENSION: return grafo.constante(double(dimensiones));
+        case Sintaxis::INDICE: return grafo.constante(double(indice));
+        case Sintaxis::COORDENADA: return grafo.coordenada(int(s.valor) - 1);
+        case Sintaxis::COORDENADA_INDICE: return grafo.coordenada(indice - 1);
+        case Sintaxis::SUMA:
+        case Sintaxis::PRODUCTO: {
+            Operacion op = s.tipo == Sintaxis::SUMA ? Operacion::SUMAR : Operacion::MULTIPLICAR;
+            int acumulado = bajar(arbol, s.a, 1, dimensiones, grafo);
+            for (int i = 2; i <= dimensiones; i++) {
+                acumulado = grafo.crear(op, acumulado, bajar(arbol, s.a, i, dimensiones, grafo));
+            }
+            return acumulado;
+        }
+        default: {
+            int a = bajar(arbol, s.a, indice, dimensiones, grafo);
+            int b = s.b >= 0 ? bajar(arbol, s.b, indice, dimensiones, grafo) : -1;
+            return grafo.crear(s.op, a, b);
+        }
+    }
+}
+
+// Bucles de la máquina, en double o en float (precisión mixta); destino puede
+// coincidir con un operando
+template <class T, class Op>
+inline void ejecutar_binaria(const Instruccion& ins, T* const* filas, std::size_t m, Op op) {
+    T* r = filas[ins.destino];
+    const T c = T(ins.constante);
+    if (ins.a < 0) {
+        const T* y = filas[ins.b];
+        for (std::size_t i = 0; i < m; i++) r[i] = op(c, y[i]);
+    } else if (ins.b < 0) {
+        const T* x = filas[ins.a];
+        for (std::size_t i = 0; i < m; i++) r[i] = op(x[i], c);
+    } else {
+        const T* x = filas[ins.a];
+        const T* y = filas[ins.b];
+        for (std::size_t i = 0; i < m; i++) r[i] = op(x[i], y[i]);
+    }
+}
+
+template <class T, class Op>
+inline void ejecutar_unaria(const Instruccion& ins, T* const* filas, std::size_t m, Op op) {
+    T* r = filas[ins.destino];
+    const T* x = filas[ins.a];
+    for (std::size_t i = 0; i < m; i++) r[i] = op(x[i]);
+}
+
+// a + b * c; la constante, si hay, está en a o en c
+template <class T>
+inline void ejecutar_suma_producto(const Instruccion& ins, T* const* filas, std::size_t m) {
+    T* r = filas[ins.destino];
+    const T k = T(ins.constante);
+    const T* y = filas[ins.b];
+    if (ins.a < 0) {
+        const T* z = filas[ins.c];
+        for (std::size_t i = 0; i < m; i++) r[i] = k + y[i] * z[i];
+    } else if (ins.c < 0) {
+        const T* x = filas[ins.a];
+        for (std::size_t i = 0; i < m; i++) r[i] = x[i] + y[i] * k;
+    } else {
+        const T* x = filas[ins.a];
+        const T* z = filas[ins.c];
+        for (std::size_t i = 0; i < m; i++) r[i] = x[i] + y[i] * z[i];
+    }
+}
+
+template <class T>
+inline void ejecutar(const Instruccion& ins, T* const* filas, std::size_t m) {
+    switch (ins.op) {
+        case Operacion::SUMAR_PRODUCTO: ejecutar_suma_producto(ins, filas, m); break;
+        case Operacion::CONSTANTE:
+            for (std::size_t i = 0; i < m; i++) filas[ins.destino][i] = T(ins.constante);
+            break;
+        case Operacion::COPIAR:
+            std::memcpy(filas[ins.destino], filas[ins.a], m * sizeof(T));
+            break;
+        case Operacion::SUMAR: ejecutar_binaria(ins, filas, m, [](T x, T y) { return x + y; }); break;
+        case Operacion::RESTAR: ejecutar_binaria(ins, filas, m, [](T x, T y) { return x - y; }); break;
+        case Operacion::MULTIPLICAR: ejecutar_binaria(ins, filas, m, [](T x, T y) { return x * y; }); break;
+        case Operacion::DIVIDIR: ejecutar_binaria(ins, filas, m, [](T x, T y) { return x / y; }); break;
+        case Operacion::POTENCIA: ejecutar_binaria(ins, filas, m, [](T x, T y) { return std::pow(x, y); }); break;
+        case Operacion::MINIMO: ejecutar_binaria(ins, filas, m, [](T x, T y) { return x < y ? x : y; }); break;
+        case Operacion::MAXIMO: ejecutar_binaria(ins, filas, m, [](T x, T y) { return x > y ? x : y; }); break;
+        case Operacion::NEGAR: ejecutar_unaria(ins, filas, m, [](T x) { return -x; }); break;
+        case Operacion::EXP: simd::exponencial(filas[ins.a], m, filas[ins.destino]); break;
+        case Operacion::LOG: ejecutar_unaria(ins, filas, m, [](T x) { return std::log(x); }); break;
+        case Operacion::RAIZ: ejecutar_unaria(ins, filas, m, [](T x) { return std::sqrt(x); }); break;
+        case Operacion::SENO: ejecutar_unaria(ins, filas, m, [](T x) { return std::sin(x); }); break;
+        case Operacion::COSENO: ejecutar_unaria(ins, filas, m, [](T x) { return std::cos(x); }); break;
+        case Operacion::TANGENTE: ejecutar_unaria(ins, filas, m, [](T x) { return std::tan(x); }); break;
+        case Operacion::ABSOLUTO: ejecutar_unaria(ins, filas, m, [](T x) { return std::fabs(x); }); break;
+        default: break;
+    }
+}
+
+} // namespace detalle
+
+// Integrando compilado desde texto para una dimensión fija. Con varias
+// expresiones (integrando vectorial) todas comparten un programa, así que sus
+// subexpresiones comunes se calculan una vez; la salida j del punto i va en
+// out[j*n + i].
+class Expresion {
+public:
+    // Evaluación de un bloque SoA: cada instrucción recorre hasta TAMANO_LOTE
+    // muestras; los registros son buffers del hilo reutilizados entre llamadas
+    void evaluar_lote(const double* soa, std::size_t n, std::size_t, double* out) const { evaluar(soa, n, out); }
+
+    // El mismo programa en float (--precision mixed)
+    void evaluar_lote(const float* soa, std::size_t n, std::size_t, float* out) const { evaluar(soa, n, out); }
+
+    // Punto a punto (solo la primera salida)
+    template <class Punto>
+    double operator()(const Punto& punto) const {
+        thread_local std::vector<double> columna, valores;
+        columna.resize(std::size_t(dimensiones_));
+        valores.resize(std::size_t(salidas()));
+        for (int k = 0; k < dimensiones_; k++) columna[k] = punto[k];
+        evaluar_lote(columna.data(), 1, std::size_t(dimensiones_), valores.data());
+        return valores[0];
+    }
+
+    const std::string& texto(int j = 0) const { return textos[j]; }
+    int salidas() const { return int(textos.size()); }
+    const std::vector<Instruccion>& instrucciones() const { return codigo; }
+    int registros() const { return registros_; }
+
+private:
+    template <class T>
+    void evaluar(const T* soa, std::size_t n, T* out) const {
+        thread_local std::vector<T> memoria;
+        thread_local std::vector<T*> filas;
+        if (memoria.size() < std::size_t(registros_) * TAMANO_LOTE) memoria.resize(std::size_t(registros_) * TAMANO_LOTE);
+        filas.resize(std::size_t(dimensiones_ + registros_ + salidas()));
+        for (int r = 0; r < registros_; r++) filas[dimensiones_ + r] = memoria.data() + std::size_t(r) * TAMANO_LOTE;
+
+        for (std::size_t inicio = 0; inicio < n; inicio += TAMANO_LOTE) {
+            std::size_t m = n - inicio < TAMANO_LOTE ? n - inicio : TAMANO_LOTE;
+            for (int k = 0; k < dimensiones_; k++) filas[k] = const_cast<T*>(soa + std::size_t(k) * n + inicio);
+            for (int j = 0; j < salidas(); j++) filas[dimensiones_ + registros_ + j] = out + std::size_t(j) * n + inicio;
+            for (const Instruccion& ins : codigo) detalle::ejecutar(ins, filas.data(), m);
+        }
+    }
+
+    friend bool compilar_expresiones(const std::vector<std::string>& textos, int dimensiones, Expresion& expresion,
+                                     std::string& error);
+
+    std::vector<std::string> textos;
+    int dimensiones_ = 0;
+    int registros_ = 0;
+    std::vector<Instruccion> codigo;
+};
+
+// Compila las expresiones para d dimensiones en un solo programa con una salida
+// por expresión. Devuelve false con el motivo en error si alguna no es válida.
+inline bool compilar_expresiones(const std::vector<std::string>& textos, int dimensiones, Expresion& expresion,
+                                 std::string& error) {
+    detalle::Grafo grafo;
+    std::vector<int> raices;
+    for (std::size_t j = 0; j < textos.size(); j++) {
+        detalle::Analizador analizador(textos[j], dimensiones);
+        int arbol = analizador.analizar();
+        if (arbol < 0) {
+            error = textos.size() > 1 ? "expresión " + std::to_string(j + 1) + ": " + analizador.error : analizador.error;
+            return false;
+        }
+        raices.push_back(detalle::bajar(analizador.nodos, arbol, 1, dimensiones, grafo));
+    }
+    const std::vector<detalle::Nodo>& nodos = grafo.nodos;
+    int ultimo = 0;
+    for (int raiz : raices) ultimo = raiz > ultimo ? raiz : ultimo;
+
+    // Nodos que llegan a alguna raíz y cuántos nodos vivos (o salidas) leen cada uno
+    std::vector<char> vivo(nodos.size(), 0);
+    std::vector<int> usos(nodos.size(), 0);
+    for (int raiz : raices) {
+        vivo[raiz] = 1;
+        usos[raiz]++;
+    }
+    for (int n = ultimo; n >= 0; n--) {
+        if (!vivo[n] || nodos[n].op == Operacion::CONSTANTE || nodos[n].op == Operacion::COORDENADA) continue;
+        for (int operando : {nodos[n].a, nodos[n].b}) {
+            if (operando < 0) continue;
+            vivo[operando] = 1;
+            usos[operando]++;
+        }
+    }
+
+    // Operandos de cada instrucción: a + x * y se emite como un solo SUMAR_PRODUCTO
+    // (una pasada por el lote en vez de dos) si el producto no tiene otros usos y
+    // entre los tres operandos hay a lo sumo una constante
+    auto es_constante = [&](int n) { return nodos[n].op == Operacion::CONSTANTE; };
+    std::vector<Operacion> op(nodos.size());
+    std::vector<std::array<int, 3>> operandos(nodos.size(), {-1, -1, -1});
+    std::vector<char> emitir(nodos.size(), 0);
+    for (int n = 0; n <= ultimo; n++) {
+        if (!vivo[n] || es_constante(n) || nodos[n].op == Operacion::COORDENADA) continue;
+        op[n] = nodos[n].op;
+        operandos[n] = {nodos[n].a, nodos[n].b, -1};
+        emitir[n] = 1;
+        if (op[n] != Operacion::SUMAR) continue;
+        for (int lado = 1; lado >= 0; lado--) {
+            int producto = operandos[n][lado], otro = operandos[n][1 - lado];
+            if (nodos[producto].op != Operacion::MULTIPLICAR || usos[producto] != 1) continue;
+            int x = nodos[producto].a, y = nodos[producto].b;
+            if (es_constante(otro) + es_constante(x) + es_constante(y) > 1) continue;
+            if (es_constante(x)) std::swap(x, y);
+            op[n] = Operacion::SUMAR_PRODUCTO;
+            operandos[n] = {otro, x, y};
+            emitir[producto] = 0;
+            break;
+        }
+    }
+
+    // Última instrucción que lee cada nodo
+    std::vector<int> ultimo_uso(nodos.size(), -1);
+    for (int n = ultimo; n >= 0; n--) {
+        if (!emitir[n]) continue;
+        for (int operando : operandos[n]) {
+            if (operando >= 0 && ultimo_uso[operando] < 0) ultimo_uso[operando] = n;
+        }
+    }
+
+    // Asignación lineal de registros: el registro de un operando se libera en
+    // su último uso y puede ser el destino de esa misma instrucción. Cada raíz
+    // se calcula directamente en la fila de su (primera) salida, que se marca
+    // como SALIDA - j hasta conocer el número de registros.
+    const int SALIDA = -2;
+    std::vector<int> fila(nodos.size(), -1);
+    std::vector<int> libres;
+    int registros = 0;
+    std::vector<Instruccion> codigo;
+
+    auto operando = [&](int n, double& constante) {
+        if (n < 0) return -1;
+        if (es_constante(n)) {
+            constante = nodos[n].valor;
+            return -1;
+        }
+        return nodos[n].op == Operacion::COORDENADA ? nodos[n].a : fila[n];
+    };
+
+    for (int n = 0; n <= ultimo; n++) {
+        if (!emitir[n]) continue;
+
+        Instruccion ins{op[n], 0, -1, -1, -1, 0.0};
+        ins.a = operando(operandos[n][0], ins.constante);
+        ins.b = operando(operandos[n][1], ins.constante);
+        ins.c = operando(operandos[n][2], ins.constante);
+
+        for (int usado : operandos[n]) {
+            if (usado >= 0 && ultimo_uso[usado] == n && fila[usado] >= dimensiones) {
+                libres.push_back(fila[usado]);
+                fila[usado] = -1;
+            }
+        }
+        int salida = -1;
+        for (std::size_t j = 0; j < raices.size() && salida < 0; j++) {
+            if (raices[j] == n) salida = int(j);
+        }
+        if (salida >= 0) {
+            ins.destino = SALIDA - salida;
+        } else if (!libres.empty()) {
+            ins.destino = libres.back();
+            libres.pop_back();
+        } else {
+            ins.destino = dimensiones + registros++;
+        }
+        fila[n] = ins.destino;
+        codigo.push_back(ins);
+    }
+
+    // Salidas constantes, coordenadas o repetidas: se escriben al final
+    for (std::size_t j = 0; j < raices.size(); j++) {
+        const int n = raices[j];
+        if (es_constante(n)) {
+            codigo.push_back({Operacion::CONSTANTE, SALIDA - int(j), -1, -1, -1, nodos[n].valor});
+        } else if (nodos[n].op == Operacion::COORDENADA || fila[n] != SALIDA - int(j)) {
+            double sin_constante;
+            codigo.push_back({Operacion::COPIAR, SALIDA - int(j), operando(n, sin_constante), -1, -1, 0.0});
+        }
+    }
+    auto resolver = [&](int& f) {
+        if (f <= SALIDA) f = dimensiones + registros + (SALIDA - f);
+    };
+    for (Instruccion& ins : codigo) {
+        resolver(ins.destino);
+        resolver(ins.a);
+        resolver(ins.b);
+        resolver(ins.c);
+    }
+
+    expresion.textos = textos;
+    expresion.dimensiones_ = dimensiones;
+    expresion.registros_ = registros;
+    expresion.codigo = std::move(codigo);
+    return true;
+}
+
+// Una sola expresión
+inline bool compilar_expresion(const std::string& texto, int dimensiones, Expresion& expresion, std::string& error) {
+    return compilar_expresiones({texto}, dimensiones, expresion, error);
+}
+
+// Las expresiones usan solo el camino dinámico (D = 0) de los motores
+template <>
+struct dimension_dinamica<Expresion> : std::true_type {};
+
+} // namespace montecarlo
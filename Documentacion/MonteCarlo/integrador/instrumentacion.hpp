@@ -0,0 +1,258 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace montecarlo {
+
+// Fases medidas con --profile. GENERACION y EVALUACION se miden por lote dentro
+// de cada bloque; BLOQUE es el bloque completo (incluye ambas y la suma), ESPERA
+// el tiempo en barreras (desbalance de carga) y REDUCCION la combinación de parciales.
+enum class Fase { GENERACION, EVALUACION, REDUCCION, ESPERA, BLOQUE };
+constexpr int FASES = 5;
+
+inline const char* nombre(Fase fase) {
+    switch (fase) {
+        case Fase::GENERACION: return "generacion";
+        case Fase::EVALUACION: return "evaluacion";
+        case Fase::REDUCCION: return "reduccion";
+        case Fase::ESPERA: return "espera";
+        default: return "bloque";
+    }
+}
+
+// Reloj monótono en segundos
+inline double reloj_instrumentacion() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Contadores de hardware del hilo que los abre (perf_event_open, solo espacio
+// de usuario): ciclos, instrucciones y fallos de caché. Si el núcleo no los
+// permite (perf_event_paranoid, contenedores) quedan como no disponibles.
+class ContadoresHardware {
+public:
+    static constexpr int CONTADORES = 3;
+
+    ContadoresHardware() = default;
+    ContadoresHardware(const ContadoresHardware&) = delete;
+    ContadoresHardware& operator=(const ContadoresHardware&) = delete;
+
+    ~ContadoresHardware() {
+#ifdef __linux__
+        for (int fd : descriptores) {
+            if (fd >= 0) close(fd);
+        }
+#endif
+    }
+
+    void abrir() {
+#ifdef __linux__
+        const std::uint64_t eventos[CONTADORES] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                   PERF_COUNT_HW_CACHE_MISSES};
+        for (int i = 0; i < CONTADORES; i++) {
+            perf_event_attr atributos;
+            std::memset(&atributos, 0, sizeof(atributos));
+            atributos.size = sizeof(atributos);
+            atributos.type = PERF_TYPE_HARDWARE;
+            atributos.config = eventos[i];
+            atributos.exclude_kernel = 1;
+            atributos.exclude_hv = 1;
+            descriptores[i] = int(syscall(SYS_perf_event_open, &atributos, 0, -1, -1, 0));
+        }
+#endif
+    }
+
+    // Valor de cada contador desde que se abrió (-1 si no está disponible)
+    std::array<long long, CONTADORES> leer() const {
+        std::array<long long, CONTADORES> valores;
+        valores.fill(-1);
+#ifdef __linux__
+        for (int i = 0; i < CONTADORES; i++) {
+            std::uint64_t valor;
+            if (descriptores[i] >= 0 && read(descriptores[i], &valor, sizeof(valor)) == sizeof(valor)) {
+                valores[i] = (long long)valor;
+            }
+        }
+#endif
+        return valores;
+    }
+
+private:
+    int descriptores[CONTADORES] = {-1, -1, -1};
+};
+
+// Evento de la línea de tiempo (formato de traza de Chrome)
+struct EventoTraza {
+    Fase fase;
+    double inicio;
+    double duracion;
+    long long muestras;
+};
+
+// Eventos guardados por hilo como máximo: acota la memoria en corridas largas
+constexpr std::size_t EVENTOS_MAXIMOS_POR_HILO = 1 << 16;
+
+// Lo que mide cada hilo; alineado a línea de caché para que los hilos no
+// compartan líneas al acumular
+struct alignas(64) RegistroHilo {
+    double tiempo[FASES] = {};
+    long long muestras = 0;
+    long long bloques = 0;
+    bool iniciado = false;
+    std::vector<EventoTraza> eventos;
+    ContadoresHardware contadores;
+};
+
+// Estado global de la instrumentación. Apagada, el costo en el camino caliente
+// es una lectura de instrumentacion_activa por bloque y por lote.
+inline bool instrumentacion_activa = false;
+
+class Instrumentacion {
+public:
+    void activar() {
+#ifdef _OPENMP
+        hilos = omp_get_max_threads();
+#endif
+        registros.reset(new RegistroHilo[hilos]);
+        origen = reloj_instrumentacion();
+        instrumentacion_activa = true;
+    }
+
+    // Registro del hilo actual; sus contadores se abren la primera vez
+    RegistroHilo* registro() {
+        int hilo = 0;
+#ifdef _OPENMP
+        hilo = omp_get_thread_num();
+#endif
+        if (!registros || hilo >= hilos) return nullptr;
+        RegistroHilo& r = registros[hilo];
+        if (!r.iniciado) {
+            r.iniciado = true;
+            r.eventos.reserve(1024);
+            r.contadores.abrir();
+        }
+        return &r;
+    }
+
+    // Suma un tramo [inicio, fin) a la fase; los tramos que no son del lote
+    // van también a la línea de tiempo
+    void registrar(RegistroHilo& r, Fase fase, double inicio, double fin, long long muestras = 0) {
+        r.tiempo[int(fase)] += fin - inicio;
+        if (fase == Fase::BLOQUE) {
+            r.muestras += muestras;
+            r.bloques++;
+        }
+        if (fase != Fase::GENERACION && fase != Fase::EVALUACION && r.eventos.size() < EVENTOS_MAXIMOS_POR_HILO) {
+            r.eventos.push_back({fase, inicio - origen, fin - inicio, muestras});
+        }
+    }
+
+    // Tabla por hilo de este proceso
+    std::string resumen(int proceso) const {
+        std::ostringstream s;
+        s << "Instrumentación, proceso " << proceso << " (tiempos en s)" << std::endl;
+        s << std::setw(5) << "hilo" << std::setw(13) << "muestras" << std::setw(9) << "bloques";
+        for (int f = 0; f < FASES; f++) s << std::setw(12) << nombre(Fase(f));
+        s << std::setw(15) << "ciclos" << std::setw(15) << "instrucciones" << std::setw(6) << "IPC"
+          << std::setw(13) << "fallos_cache" << std::endl;
+
+        for (int h = 0; h < hilos; h++) {
+            const RegistroHilo& r = registros[h];
+            if (!r.iniciado) continue;
+            s << std::setw(5) << h << std::setw(13) << r.muestras << std::setw(9) << r.bloques;
+            s << std::fixed << std::setprecision(4);
+            for (int f = 0; f < FASES; f++) s << std::setw(12) << r.tiempo[f];
+            s.unsetf(std::ios::floatfield);
+
+            std::array<long long, ContadoresHardware::CONTADORES> c = r.contadores.leer();
+            for (int i = 0; i < 2; i++) {
+                if (c[i] >= 0) s << std::setw(15) << c[i];
+                else s << std::setw(15) << "n/d";
+            }
+            if (c[0] > 0 && c[1] >= 0) s << std::setw(6) << std::setprecision(3) << double(c[1]) / c[0];
+            else s << std::setw(6) << "n/d";
+            if (c[2] >= 0) s << std::setw(13) << c[2];
+            else s << std::setw(13) << "n/d";
+            s << std::endl;
+        }
+        return s.str();
+    }
+
+    // Eventos de la traza de Chrome de este proceso (pid = proceso, tid = hilo),
+    // separados por comas, con tiempos en microsegundos
+    std::string eventos_json(int proceso) const {
+        std::ostringstream s;
+        s << std::fixed << std::setprecision(3);
+        s << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << proceso << ",\"args\":{\"name\":\"proceso "
+          << proceso << "\"}}";
+        for (int h = 0; h < hilos; h++) {
+            const RegistroHilo& r = registros[h];
+            if (!r.iniciado) continue;
+            s << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << proceso << ",\"tid\":" << h
+              << ",\"args\":{\"name\":\"hilo " << h << "\"}}";
+            for (const EventoTraza& e : r.eventos) {
+                s << ",\n{\"name\":\"" << nombre(e.fase) << "\",\"ph\":\"X\",\"pid\":" << proceso << ",\"tid\":" << h
+                  << ",\"ts\":" << e.inicio * 1e6 << ",\"dur\":" << e.duracion * 1e6;
+                if (e.muestras > 0) s << ",\"args\":{\"muestras\":" << e.muestras << "}";
+                s << "}";
+            }
+        }
+        return s.str();
+    }
+
+private:
+    int hilos = 1;
+    std::unique_ptr<RegistroHilo[]> registros;
+    double origen = 0.0;
+};
+
+inline Instrumentacion& instrumentacion() {
+    static Instrumentacion global;
+    return global;
+}
+
+// Mide el tramo entre su construcción y su destrucción en el hilo actual; no
+// hace nada si la instrumentación está apagada
+class TramoInstrumentado {
+public:
+    explicit TramoInstrumentado(Fase fase, long long muestras = 0) : fase(fase), muestras(muestras) {
+        if (instrumentacion_activa) {
+            registro = instrumentacion().registro();
+            inicio = reloj_instrumentacion();
+        }
+    }
+
+    ~TramoInstrumentado() {
+        if (registro) instrumentacion().registrar(*registro, fase, inicio, reloj_instrumentacion(), muestras);
+    }
+
+    TramoInstrumentado(const TramoInstrumentado&) = delete;
+    TramoInstrumentado& operator=(const TramoInstrumentado&) = delete;
+
+private:
+    Fase fase;
+    long long muestras;
+    RegistroHilo* registro = nullptr;
+    double inicio = 0.0;
+};
+
+} // namespace montecarlo
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#include "simd.hpp"
+
+namespace montecarlo {
+
+// Función a integrar: e^(-(x1^2 + x2^2 + ...))
+// Es una plantilla sobre el tipo de punto: con std::array el bucle se desenrolla
+// en tiempo de compilación, con la versión dinámica recorre un buffer reutilizado.
+struct Gaussiana {
+    template <class Punto>
+    double operator()(const Punto& punto) const {
+        double suma = 0.0;
+        for (std::size_t i = 0; i < punto.size(); ++i) {
+            double coordenada = punto[i];
+            suma += coordenada * coordenada;
+        }
+        return std::exp(-suma);
+    }
+
+    // Evaluación de un bloque SoA completo con el kernel vectorial de la CPU
+    void evaluar_lote(const double* soa, std::size_t n, std::size_t d, double* out) const {
+        simd::gaussiana(soa, n, d, out);
+    }
+
+    // En float para la precisión mixta: 16 carriles con AVX-512 en lugar de 8
+    void evaluar_lote(const float* soa, std::size_t n, std::size_t d, float* out) const {
+        simd::gaussiana(soa, n, d, out);
+    }
+};
+
+} // namespace montecarlo
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "instrumentacion.hpp"
+#include "momentos.hpp"
+#include "nucleo.hpp"
+#include "simd.hpp"
+
+namespace montecarlo {
+
+// Muestras por bloque SoA: d * 256 doubles caben en L1 hasta d ~ 16
+constexpr std::size_t TAMANO_LOTE = 256;
+
+// Detecta si el integrando ofrece evaluar_lote(soa, n, d, out)
+template <class F, class = void>
+struct tiene_evaluar_lote : std::false_type {};
+
+template <class F>
+struct tiene_evaluar_lote<F, std::void_t<decltype(std::declval<const F&>().evaluar_lote(
+    std::declval<const double*>(), std::size_t(), std::size_t(), std::declval<double*>()))>>
+    : std::true_type {};
+
+// Detecta si el integrando ofrece evaluar_lote(soa, n, d, out) en float
+template <class F, class = void>
+struct tiene_evaluar_lote_float : std::false_type {};
+
+template <class F>
+struct tiene_evaluar_lote_float<F, std::void_t<decltype(std::declval<const F&>().evaluar_lote(
+    std::declval<const float*>(), std::size_t(), std::size_t(), std::declval<float*>()))>>
+    : std::true_type {};
+
+// Detecta si el generador ofrece llenado masivo llenar(destino, n)
+template <class U, class = void>
+struct tiene_llenar : std::false_type {};
+
+template <class U>
+struct tiene_llenar<U, std::void_t<decltype(std::declval<U&>().llenar(
+    std::declval<double*>(), std::size_t()))>> : std::true_type {};
+
+// Detecta si el generador tiene un flujo float propio llenar(float*, n)
+template <class U, class = void>
+struct tiene_llenar_float : std::false_type {};
+
+template <class U>
+struct tiene_llenar_float<U, std::void_t<decltype(std::declval<U&>().llenar(
+    std::declval<float*>(), std::size_t()))>> : std::true_type {};
+
+// Buffers del motor por lotes; cada hilo reserva el suyo una sola vez
+struct EspacioLote {
+    std::vector<double> soa;
+    std::vector<double> valores;
+    std::vector<double> sorteos;
+
+    // Precisión mixta: se reservan la primera vez que se usan
+    std::vector<float> soa_float;
+    std::vector<float> valores_float;
+    std::vector<float> sorteos_float;
+
+    // Con --store: columnas del bloque en curso (la k empieza en
+    // captura + k * filas_captura, los valores en la d) donde se copia cada
+    // lote; nullptr si no se guardan muestras
+    double* captura = nullptr;
+    std::size_t filas_captura = 0;
+
+    explicit EspacioLote(int dimensiones)
+        : soa(std::size_t(dimensiones) * TAMANO_LOTE),
+          valores(TAMANO_LOTE),
+          sorteos(std::size_t(dimensiones) * TAMANO_LOTE) {}
+};
+
+// Copia un lote SoA de m puntos y sus valores a las columnas de la captura,
+// desde la fila desplazamiento
+template <class T>
+void capturar_lote(EspacioLote& espacio, const T* soa, const T* valores, std::size_t m, std::size_t d,
+                   std::size_t desplazamiento) {
+    for (std::size_t k = 0; k <= d; k++) {
+        const T* origen = k < d ? soa + k * m : valores;
+        double* destino = espacio.captura + k * espacio.filas_captura + desplazamiento;
+        for (std::size_t i = 0; i < m; i++) destino[i] = origen[i];
+    }
+}
+
+// Llena un bloque SoA de m puntos: soa[k*m + i] es la coordenada k del punto i.
+// Los números se consumen punto por punto, en el mismo orden que acumular<D>.
+template <int D, class Uniforme>
+void llenar_lote(double* soa, std::size_t m, const Dominio& dominio, Uniforme& uniforme,
+                 double* sorteos) {
+    const std::size_t d = D > 0 ? std::size_t(D) : std::size_t(dominio.dimensiones);
+    const double lim_inf = dominio.lim_inf;
+    const double ancho = dominio.ancho();
+
+    if constexpr (tiene_llenar<Uniforme>::value) {
+        // Sorteos consecutivos en orden de punto y luego transposición a SoA
+        uniforme.llenar(sorteos, m * d);
+        for (std::size_t k = 0; k < d; k++) {
+            for (std::size_t i = 0; i < m; i++) {
+                soa[k * m + i] = lim_inf + ancho * sorteos[i * d + k];
+            }
+        }
+    } else {
+        for (std::size_t i = 0; i < m; i++) {
+            for (std::size_t k = 0; k < d; k++) {
+                soa[k * m + i] = lim_inf + ancho * uniforme();
+            }
+        }
+    }
+}
+
+// Como llenar_lote, en float. Con un flujo float propio (Philox) cada sorteo
+// usa 32 bits en lugar de 64; con los demás generadores se convierten los
+// sorteos double, así que los puntos son los de la precisión double redondeados.
+template <class Uniforme>
+void llenar_lote_float(float* soa, std::size_t m, const Dominio& dominio, Uniforme& uniforme,
+                       EspacioLote& espacio) {
+    const std::size_t d = std::size_t(dominio.dimensiones);
+    const float lim_inf = float(dominio.lim_inf);
+    const float ancho = float(dominio.ancho());
+
+    if constexpr (tiene_llenar_float<Uniforme>::value) {
+        float* sorteos = espacio.sorteos_float.data();
+        uniforme.llenar(sorteos, m * d);
+        for (std::size_t k = 0; k < d; k++) {
+            for (std::size_t i = 0; i < m; i++) soa[k * m + i] = lim_inf + ancho * sorteos[i * d + k];
+        }
+    } else if constexpr (tiene_llenar<Uniforme>::value) {
+        double* sorteos = espacio.sorteos.data();
+        uniforme.llenar(sorteos, m * d);
+        for (std::size_t k = 0; k < d; k++) {
+            for (std::size_t i = 0; i < m; i++) soa[k * m + i] = float(dominio.lim_inf + dominio.ancho() * sorteos[i * d + k]);
+        }
+    } else {
+        for (std::size_t i = 0; i < m; i++) {
+            for (std::size_t k = 0; k < d; k++) soa[k * m + i] = float(dominio.lim_inf + dominio.ancho() * uniforme());
+        }
+    }
+}
+
+// Evalúa m puntos en formato SoA, de una vez si el integrando ofrece
+// evaluar_lote o punto por punto en caso contrario
+template <int D, class F>
+void evaluar_soa(const F& func, const double* soa, std::size_t m, std::size_t d, double* valores) {
+    if constexpr (tiene_evaluar_lote<F>::value) {
+        func.evaluar_lote(soa, m, d, valores);
+    } else {
+        Punto<D> punto(static_cast<int>(d));
+        for (std::size_t i = 0; i < m; i++) {
+            for (std::size_t k = 0; k < d; k++) punto[k] = soa[k * m + i];
+            valores[i] = func(punto);
+        }
+    }
+}
+
+// Como despachar_dimension, para los motores que solo usan D al evaluar punto a
+// punto (VEGAS, MISER): con un integrando por lotes basta el camino dinámico y
+// se evita instanciar el motor para cada dimensión
+template <class F, class Funcion>
+decltype(auto) despachar_evaluacion(int dimensiones, Funcion&& funcion) {
+    if constexpr (tiene_evaluar_lote<F>::value) {
+        return funcion(std::integral_constant<int, 0>{});
+    } else {
+        return despachar_dimension(dimensiones, funcion);
+    }
+}
+
+// Integrandos que los motores instancian solo con el camino dinámico (D = 0),
+// como las expresiones compiladas en tiempo de ejecución: fijar D no acelera su
+// evaluación y cada dimensión sería otra copia de todos los motores
+template <class F>
+struct dimension_dinamica : std::false_type {};
+
+// despachar_dimension salvo para los integrandos con dimension_dinamica
+template <class F, class Funcion>
+decltype(auto) despachar_muestreo(int dimensiones, Funcion&& funcion) {
+    if constexpr (dimension_dinamica<F>::value) {
+        return funcion(std::integral_constant<int, 0>{});
+    } else {
+        return despachar_dimension(dimensiones, funcion);
+    }
+}
+
+// Motor por lotes: genera bloques SoA, los evalúa de una vez y suma los
+// valores con los kernels vectoriales. Con --profile mide por separado la
+// generación y la evaluación de cada lote.
+template <int D, class F, class Uniforme>
+Momentos acumular_lotes(const F& func, const Dominio& dominio, Uniforme& uniforme, long long n,
+                        EspacioLote& espacio) {
+    const std::size_t d = dominio.dimensiones;
+    RegistroHilo* registro = instrumentacion_activa ? instrumentacion().registro() : nullptr;
+
+    Momentos momentos;
+    for (long long hechos = 0; hechos < n; hechos += TAMANO_LOTE) {
+        std::size_t m = n - hechos < (long long)TAMANO_LOTE ? std::size_t(n - hechos) : TAMANO_LOTE;
+        double t0 = registro ? reloj_instrumentacion() : 0.0;
+        llenar_lote<D>(espacio.soa.data(), m, dominio, uniforme, espacio.sorteos.data());
+        double t1 = registro ? reloj_instrumentacion() : 0.0;
+        func.evaluar_lote(espacio.soa.data(), m, d, espacio.valores.data());
+        momentos += simd::sumar(espacio.valores.data(), m);
+        if (registro) {
+            double t2 = reloj_instrumentacion();
+            registro->tiempo[int(Fase::GENERACION)] += t1 - t0;
+            registro->tiempo[int(Fase::EVALUACION)] += t2 - t1;
+        }
+        if (espacio.captura) capturar_lote(espacio, espacio.soa.data(), espacio.valores.data(), m, d, hechos);
+    }
+    return momentos;
+}
+
+// Integrando con evaluación float (--precision mixed). Los motores por lotes
+// generan y evalúan en float y suman en double (acumular_lotes_float); los
+// demás (VEGAS, MISER, integrandos vectoriales) le pasan puntos double, que se
+// redondean a float para evaluar.
+template <class F>
+class PrecisionMixta {
+public:
+    explicit PrecisionMixta(const F& func) : func(func) {}
+
+    const F& integrando() const { return func; }
+
+    void evaluar_lote(const float* soa, std::size_t n, std::size_t d, float* out) const {
+        func.evaluar_lote(soa, n, d, out);
+    }
+
+    void evaluar_lote(const double* soa, std::size_t n, std::size_t d, double* out) const {
+        thread_local std::vector<float> coordenadas, valores;
+        coordenadas.resize(n * d);
+        valores.resize(n);
+        for (std::size_t i = 0; i < n * d; i++) coordenadas[i] = float(soa[i]);
+        func.evaluar_lote(coordenadas.data(), n, d, valores.data());
+        for (std::size_t i = 0; i < n; i++) out[i] = valores[i];
+    }
+
+    template <class Punto>
+    double operator()(const Punto& punto) const {
+        thread_local std::vector<float> columna;
+        columna.resize(punto.size());
+        for (std::size_t k = 0; k < punto.size(); k++) columna[k] = float(punto[k]);
+        float valor;
+        func.evaluar_lote(columna.data(), 1, columna.size(), &valor);
+        return valor;
+    }
+
+private:
+    F func;
+};
+
+template <class F>
+struct es_precision_mixta : std::false_type {};
+
+template <class F>
+struct es_precision_mixta<PrecisionMixta<F>> : std::true_type {};
+
+// Fijar D no acelera el camino float, que ya es por lotes
+template <class F>
+struct dimension_dinamica<PrecisionMixta<F>> : std::true_type {};
+
+// Motor por lotes en precisión mixta: puntos y valores en float (el doble de
+// carriles por registro), momentos en double como en acumular_lotes
+template <class F, class Uniforme>
+Momentos acumular_lotes_float(const PrecisionMixta<F>& func, const Dominio& dominio, Uniforme& uniforme, long long n,
+                              EspacioLote& espacio) {
+    const std::size_t d = dominio.dimensiones;
+    RegistroHilo* registro = instrumentacion_activa ? instrumentacion().registro() : nullptr;
+    if (espacio.soa_float.empty()) {
+        espacio.soa_float.resize(d * TAMANO_LOTE);
+        espacio.valores_float.resize(TAMANO_LOTE);
+        espacio.sorteos_float.resize(d * TAMANO_LOTE);
+    }
+
+    Momentos momentos;
+    for (long long hechos = 0; hechos < n; hechos += TAMANO_LOTE) {
+        std::size_t m = n - hechos < (long long)TAMANO_LOTE ? std::size_t(n - hechos) : TAMANO_LOTE;
+        double t0 = registro ? reloj_instrumentacion() : 0.0;
+        llenar_lote_float(espacio.soa_float.data(), m, dominio, uniforme, espacio);
+        double t1 = registro ? reloj_instrumentacion() : 0.0;
+        func.evaluar_lote(espacio.soa_float.data(), m, d, espacio.valores_float.data());
+        momentos += simd::sumar(espacio.valores_float.data(), m);
+        if (registro) {
+            double t2 = reloj_instrumentacion();
+            registro->tiempo[int(Fase::GENERACION)] += t1 - t0;
+            registro->tiempo[int(Fase::EVALUACION)] += t2 - t1;
+        }
+        if (espacio.captura) capturar_lote(espacio, espacio.soa_float.data(), espacio.valores_float.data(), m, d, hechos);
+    }
+    return momentos;
+}
+
+// Elige el motor por lotes si el integrando lo soporta, o el bucle punto a punto
+template <int D, class F, class Uniforme>
+Momentos muestrear(const F& func, const Dominio& dominio, Uniforme& uniforme, long long n,
+                   EspacioLote& espacio) {
+    if constexpr (es_precision_mixta<F>::value) {
+        return acumular_lotes_float(func, dominio, uniforme, n, espacio);
+    } else if constexpr (tiene_evaluar_lote<F>::value) {
+        return acumular_lotes<D>(func, dominio, uniforme, n, espacio);
+    } else {
+        return acumular<D>(func, dominio, uniforme, n);
+    }
+}
+
+} // namespace montecarlo
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "instrumentacion.hpp"
+#include "lotes.hpp"
+#include "momentos.hpp"
+#include "motores.hpp"
+#include "nucleo.hpp"
+#include "openmp.hpp"
+#include "paralelo.hpp"
+#include "parametros.hpp"
+#include "philox.hpp"
+#include "simd.hpp"
+
+namespace montecarlo {
+
+// Región rectangular [inf[k], sup[k]) de la recursión de MISER
+struct Caja {
+    std::vector<double> inf;
+    std::vector<double> sup;
+
+    double volumen() const {
+        double v = 1.0;
+        for (std::size_t k = 0; k < inf.size(); k++) v *= sup[k] - inf[k];
+        return v;
+    }
+};
+
+// Promedio de f en una región y varianza de ese promedio
+struct EstimacionMiser {
+    double promedio = 0.0;
+    double varianza = 0.0;
+};
+
+// Constantes de Press y Farrar (1990): puntos mínimos por región, por bisección
+// y fracción de los puntos usada para explorar; el punto de corte se desplaza
+// al azar hasta DESPLAZAMIENTO_MISER del centro para no alinearse con el integrando
+constexpr int PUNTOS_MINIMOS_MISER = 16;
+constexpr int FACTOR_BISECCION_MISER = 32;
+constexpr double FRACCION_EXPLORACION_MISER = 0.1;
+constexpr double DESPLAZAMIENTO_MISER = 0.05;
+
+// Regiones con menos puntos se resuelven en la tarea actual
+constexpr long long UMBRAL_TAREA_MISER = 1 << 12;
+
+// Genera m puntos uniformes de la caja desde el flujo y los evalúa en espacio.valores
+template <int D, class Flujo, class F>
+void evaluar_caja(const F& func, const Caja& caja, Flujo& flujo, std::size_t m, EspacioLote& espacio) {
+    const std::size_t d = caja.inf.size();
+    flujo.llenar(espacio.sorteos.data(), m * d);
+    for (std::size_t k = 0; k < d; k++) {
+        const double inf = caja.inf[k];
+        const double ancho = caja.sup[k] - caja.inf[k];
+        for (std::size_t i = 0; i < m; i++) {
+            espacio.soa[k * m + i] = inf + ancho * espacio.sorteos[i * d + k];
+        }
+    }
+    evaluar_soa<D>(func, espacio.soa.data(), m, d, espacio.valores.data());
+}
+
+// Momentos de f en cada mitad de cada dimensión durante la exploración
+struct ExploracionMiser {
+    std::vector<Momentos> izquierda, derecha;
+
+    explicit ExploracionMiser(int dimensiones) : izquierda(dimensiones), derecha(dimensiones) {}
+
+    ExploracionMiser& operator+=(const ExploracionMiser& otra) {
+        for (std::size_t k = 0; k < izquierda.size(); k++) {
+            izquierda[k] += otra.izquierda[k];
+            derecha[k] += otra.derecha[k];
+        }
+        return *this;
+    }
+};
+
+// Explora la caja con n puntos de índice [0, n) del flujo de la región. Las
+// exploraciones grandes se reparten en tareas de TAMANO_BLOQUE puntos y se
+// combinan en orden, así que el resultado no depende de qué hilo las ejecuta.
+template <int D, class Flujo, class F>
+ExploracionMiser explorar_caja(const F& func, const Caja& caja, const std::vector<double>& cortes,
+                               long long n, unsigned long long semilla) {
+    const int d = int(caja.inf.size());
+    const long long trozos = (n + TAMANO_BLOQUE - 1) / TAMANO_BLOQUE;
+    std::vector<ExploracionMiser> parciales(trozos, ExploracionMiser(d));
+
+    MONTECARLO_OMP(taskloop shared(func, caja, cortes, parciales) if (trozos > 1))
+    for (long long t = 0; t < trozos; t++) {
+        const long long inicio = t * TAMANO_BLOQUE;
+        const long long fin = std::min(n, inicio + TAMANO_BLOQUE);
+        TramoInstrumentado tramo(Fase::BLOQUE, fin - inicio);
+        Flujo flujo(semilla, d);
+        flujo.saltar_a_muestra(inicio);
+        EspacioLote espacio(d);
+        ExploracionMiser& parcial = parciales[t];
+
+        for (long long hechos = inicio; hechos < fin; hechos += TAMANO_LOTE) {
+            std::size_t m = std::min<long long>(fin - hechos, TAMANO_LOTE);
+            evaluar_caja<D>(func, caja, flujo, m, espacio);
+            for (int k = 0; k < d; k++) {
+                Momentos izquierda, derecha;
+                for (std::size_t i = 0; i < m; i++) {
+                    double valor = espacio.valores[i];
+                    if (espacio.soa[k * m + i] < cortes[k]) {
+                        izquierda.agregar(valor);
+                    } else {
+                        derecha.agregar(valor);
+                    }
+                }
+                parcial.izquierda[k] += izquierda;
+                parcial.derecha[k] += derecha;
+            }
+        }
+    }
+
+    TramoInstrumentado tramo(Fase::REDUCCION);
+    ExploracionMiser total(d);
+    for (const ExploracionMiser& parcial : parciales) total += parcial;
+    return total;
+}
+
+// Desviación estándar muestral de f a partir de sus momentos
+inline double desviacion(const Momentos& m) {
+    if (m.n < 2) return -1.0;
+    return std::sqrt(m.varianza());
+}
+
+// MISER (Press y Farrar, 1990) sobre la caja con n puntos. Cada región tiene su
+// propia semilla, derivada de la de su padre, y los resultados se combinan en
+// el orden del árbol: el valor no depende del número de hilos ni del orden en
+// que se ejecutan las tareas.
+template <int D, class Flujo, class F>
+EstimacionMiser miser_region(const F& func, const Caja& caja, long long n, unsigned long long semilla) {
+    const int d = int(caja.inf.size());
+    const long long minimo = (long long)PUNTOS_MINIMOS_MISER * d;
+    EstimacionMiser e;
+
+    // Hoja: Monte Carlo simple en la caja
+    if (n < FACTOR_BISECCION_MISER * minimo) {
+        TramoInstrumentado tramo(Fase::BLOQUE, n);
+        Flujo flujo(semilla, d);
+        flujo.saltar_a_muestra(0);
+        EspacioLote espacio(d);
+        Momentos m;
+        for (long long hechos = 0; hechos < n; hechos += TAMANO_LOTE) {
+            std::size_t lote = std::min<long long>(n - hechos, TAMANO_LOTE);
+            evaluar_caja<D>(func, caja, flujo, lote, espacio);
+            m += simd::sumar(espacio.valores.data(), lote);
+        }
+        e.promedio = m.promedio();
+        e.varianza = m.varianza() / n;
+        return e;
+    }
+
+    // Puntos de corte desplazados al azar alrededor del centro de cada dimensión
+    SplitMix64 sm;
+    sm.sembrar(semilla);
+    std::vector<double> cortes(d), fracciones(d);
+    for (int k = 0; k < d; k++) {
+        fracciones[k] = 0.5 + DESPLAZAMIENTO_MISER * (2.0 * a_unidad(sm()) - 1.0);
+        cortes[k] = caja.inf[k] + fracciones[k] * (caja.sup[k] - caja.inf[k]);
+    }
+
+    const long long explorados = std::max(minimo, (long long)(FRACCION_EXPLORACION_MISER * n));
+    ExploracionMiser exploracion = explorar_caja<D, Flujo>(func, caja, cortes, explorados, semilla);
+
+    // Bisección que más reduce la varianza: con asignación óptima, la varianza
+    // del promedio estratificado es proporcional a (f_izq s_izq + f_der s_der)^2
+    int mejor = -1;
+    double mejor_suma = 0.0, mejor_izquierda = 0.0, mejor_derecha = 0.0;
+    for (int k = 0; k < d; k++) {
+        double s_izquierda = desviacion(exploracion.izquierda[k]);
+        double s_derecha = desviacion(exploracion.derecha[k]);
+        if (s_izquierda < 0.0 || s_derecha < 0.0) continue;
+        double izquierda = fracciones[k] * s_izquierda;
+        double derecha = (1.0 - fracciones[k]) * s_derecha;
+        if (mejor < 0 || izquierda + derecha < mejor_suma) {
+            mejor = k;
+            mejor_suma = izquierda + derecha;
+            mejor_izquierda = izquierda;
+            mejor_derecha = derecha;
+        }
+    }
+    if (mejor < 0) mejor = 0;
+
+    // Reparto de los puntos restantes proporcional a la dispersión de cada mitad
+    // (por volumen si f es constante en ambas)
+    const long long resto = n - explorados;
+    double fraccion = mejor_suma > 0.0 ? mejor_izquierda / (mejor_izquierda + mejor_derecha) : fracciones[mejor];
+    long long n_izquierda = (long long)(fraccion * resto);
+    n_izquierda = std::min(std::max(n_izquierda, minimo), resto - minimo);
+    long long n_derecha = resto - n_izquierda;
+
+    Caja izquierda = caja, derecha = caja;
+    izquierda.sup[mejor] = cortes[mejor];
+    derecha.inf[mejor] = cortes[mejor];
+
+    EstimacionMiser e_izquierda, e_derecha;
+    MONTECARLO_OMP(task shared(e_izquierda, func, izquierda) if (n_izquierda >= UMBRAL_TAREA_MISER))
+    e_izquierda = miser_region<D, Flujo>(func, izquierda, n_izquierda, derivar_semilla(semilla, 1));
+    e_derecha = miser_region<D, Flujo>(func, derecha, n_derecha, derivar_semilla(semilla, 2));
+    MONTECARLO_OMP(taskwait)
+
+    const double f = fracciones[mejor];
+    e.promedio = f * e_izquierda.promedio + (1.0 - f) * e_derecha.promedio;
+    e.varianza = f * f * e_izquierda.varianza + (1.0 - f) * (1.0 - f) * e_derecha.varianza;
+    return e;
+}
+
+// MISER sobre el hipercubo completo con todos los hilos: la raíz la lanza un
+// hilo y las subregiones se reparten como tareas de OpenMP
+template <class Flujo, class F>
+Resultado miser(const F& func, const Dominio& dominio, long long N, unsigned long long seed) {
+    Caja caja{std::vector<double>(dominio.dimensiones, dominio.lim_inf),
+              std::vector<double>(dominio.dimensiones, dominio.lim_sup)};
+
+    EstimacionMiser e;
+    despachar_evaluacion<F>(dominio.dimensiones, [&](auto D) {
+        constexpr int DIM = decltype(D)::value;
+        MONTECARLO_OMP(parallel)
+        {
+            fijar_hilo();
+            MONTECARLO_OMP(single)
+            e = miser_region<DIM, Flujo>(func, caja, N, seed);
+        }
+        return 0;
+    });
+
+    // La varianza de f se informa como la varianza efectiva que daría el mismo
+    // error con muestreo uniforme
+    const double volumen = dominio.volumen();
+    Resultado r;
+    r.integral = volumen * e.promedio;
+    r.error = volumen * std::sqrt(e.varianza);
+    r.varianza = e.varianza * N;
+    r.muestras = N;
+    return r;
+}
+
+// Igual que la anterior, con el flujo y la semilla de la línea de comando
+template <class F>
+Resultado miser(const F& func, const Dominio& dominio, const Parametros& p) {
+    return despachar_flujo(p, [&](auto tipo) {
+        using Flujo = typename decltype(tipo)::type;
+        return miser<Flujo>(func, dominio, p.N, p.seed);
+    });
+}
+
+} // namespace montecarlo
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "openmp.hpp"
+
+namespace montecarlo {
+
+// Suma de Knuth (TwoSum): suma x a "suma" y acumula el error de redondeo exacto
+// en "compensacion". Requiere aritmética IEEE estricta (no usar -ffast-math).
+inline void sumar_compensado(double& suma, double& compensacion, double x) {
+    double s = suma + x;
+    double b = s - suma;
+    compensacion += (suma - (s - b)) + (x - b);
+    suma = s;
+}
+
+// Momentos de una muestra: cantidad de valores, media y m2 = sum (x - media)^2.
+// La varianza sale de m2 sin restar dos cantidades grandes y casi iguales
+// (<f^2> - <f>^2), así que no se pierde aunque f sea casi constante, y la
+// cantidad de 64 bits admite corridas de más de 2^31 muestras.
+struct Momentos {
+    long long n = 0;
+    double media = 0.0;
+    double m2 = 0.0;
+
+    // Error de redondeo acumulado al combinar momentos parciales
+    double compensacion_media = 0.0;
+    double compensacion_m2 = 0.0;
+
+    // Welford: acumulación directa de un valor dentro de un bloque
+    void agregar(double valor) {
+        n++;
+        double delta = valor - media;
+        media += delta / double(n);
+        m2 += delta * (valor - media);
+    }
+
+    // Chan et al.: combinación de dos muestras disjuntas, con la media y m2
+    // sumados en forma compensada. El total no depende (salvo empates de
+    // redondeo) del orden en que hilos y procesos combinan sus bloques.
+    Momentos& operator+=(const Momentos& otro) {
+        if (otro.n == 0) return *this;
+        if (n == 0) return *this = otro;
+
+        const long long total = n + otro.n;
+        const double peso = double(otro.n) / double(total);
+        // Diferencia de las medias, con la parte compensada de cada una
+        const double delta = (otro.media - media) + (otro.compensacion_media - compensacion_media);
+
+        sumar_compensado(media, compensacion_media, delta * peso);
+        sumar_compensado(m2, compensacion_m2, otro.m2);
+        sumar_compensado(m2, compensacion_m2, delta * delta * double(n) * peso);
+        compensacion_m2 += otro.compensacion_m2;
+        n = total;
+        return *this;
+    }
+
+    double promedio() const { return media + compensacion_media; }
+
+    // Varianza de la muestra (dividida por n, como el estimador de la integral)
+    double varianza() const {
+        double v = n > 0 ? (m2 + compensacion_m2) / double(n) : 0.0;
+        return v > 0.0 ? v : 0.0;
+    }
+};
+
+// Reducción de OpenMP: reduction(+ : momentos) combina los parciales de cada
+// hilo con el operator+= anterior
+MONTECARLO_OMP(declare reduction(+ : Momentos : omp_out += omp_in))
+
+// Estimación final de la integral y su error
+struct Resultado {
+    double integral = 0.0;
+    double error = 0.0;
+    double varianza = 0.0;
+
+    // Puntos evaluados
+    long long muestras = 0;
+
+    // Solo VEGAS: chi^2 por grado de libertad entre iteraciones
+    double chi2_dof = 0.0;
+
+    // Con variables antitéticas o de control: varianza de f sobre la varianza
+    // efectiva por evaluación (los mismos puntos sin reducción tendrían un
+    // error sqrt(reduccion_varianza) veces mayor) y coeficiente de la variable
+    double reduccion_varianza = 0.0;
+    double coeficiente_control = 0.0;
+
+    // La varianza efectiva quedó en cero (f lineal con pares antitéticos, h
+    // perfectamente correlacionada con f, f constante): no hay cociente finito
+    bool varianza_eliminada = false;
+
+    // Con --cache: muestras que salieron de la caché en lugar de integrarse
+    long long muestras_cache = 0;
+};
+
+// Cálculos finales a partir de los momentos globales de N muestras
+inline Resultado estimar(const Momentos& m, long long N, double volumen) {
+    Resultado r;
+    r.varianza = m.varianza();
+    r.integral = m.promedio() * volumen;
+    r.error = volumen * std::sqrt(r.varianza / N);
+    r.muestras = N;
+    return r;
+}
+
+// Momentos de cada réplica independiente (p. ej. cada aleatorización de Owen en
+// RQMC). Con una sola réplica el error es el estadístico usual.
+using Replicas = std::vector<Momentos>;
+
+// Con R > 1 réplicas de n puntos, la integral es el promedio de las R
+// estimaciones y el error su desviación estándar entre réplicas / sqrt(R):
+// es un error honesto también para QMC, donde la fórmula V*sqrt(var/N) no aplica
+inline Resultado estimar(const Replicas& replicas, long long n, double volumen) {
+    const int R = int(replicas.size());
+    if (R == 1) return estimar(replicas[0], n, volumen);
+
+    Momentos total, integrales;
+    for (const Momentos& m : replicas) {
+        integrales.agregar(volumen * m.promedio());
+        total += m;
+    }
+
+    Resultado r = estimar(total, n * R, volumen);
+    r.integral = integrales.promedio();
+    r.error = std::sqrt(integrales.m2 / (R - 1) / R);
+    return r;
+}
+
+// Momentos de K integrandos evaluados sobre los mismos puntos: los de cada f_j
+// y los co-momentos sum (f_j - media_j)(f_l - media_l) con j < l, en el orden
+// (0,1), (0,2), ..., (1,2), ... Se combinan como Momentos (Chan), con la
+// corrección delta_j delta_l n_a n_b / n de los co-momentos.
+struct MomentosVectoriales {
+    int K = 0;
+    std::vector<Momentos> componentes;
+    std::vector<double> comomentos;
+    std::vector<double> compensacion;  // de los co-momentos
+
+    MomentosVectoriales() = default;
+    explicit MomentosVectoriales(int K)
+        : K(K), componentes(K), comomentos(std::size_t(K) * (K - 1) / 2), compensacion(comomentos.size()) {}
+
+    // Posición del co-momento de f_j y f_l, j < l
+    std::size_t cruzado(int j, int l) const {
+        return std::size_t(j) * (2 * K - j - 1) / 2 + std::size_t(l - j - 1);
+    }
+
+    long long muestras() const { return componentes.empty() ? 0 : componentes[0].n; }
+
+    // cov(f_j, f_l) de la muestra, dividida por n como la varianza
+    double covarianza(int j, int l) const {
+        std::size_t c = cruzado(j, l);
+        return muestras() > 0 ? (comomentos[c] + compensacion[c]) / double(muestras()) : 0.0;
+    }
+
+    MomentosVectoriales& operator+=(const MomentosVectoriales& otro) {
+        if (otro.muestras() == 0) return *this;
+        if (muestras() == 0) return *this = otro;
+
+        const double peso = double(otro.muestras()) / double(muestras() + otro.muestras());
+        const double factor = double(muestras()) * peso;
+        for (int j = 0; j < K; j++) {
+            double delta_j = otro.componentes[j].promedio() - componentes[j].promedio();
+            for (int l = j + 1; l < K; l++) {
+                double delta_l = otro.componentes[l].promedio() - componentes[l].promedio();
+                std::size_t c = cruzado(j, l);
+                sumar_compensado(comomentos[c], compensacion[c], otro.comomentos[c]);
+                sumar_compensado(comomentos[c], compensacion[c], delta_j * delta_l * factor);
+                compensacion[c] += otro.compensacion[c];
+            }
+        }
+        for (int j = 0; j < K; j++) componentes[j] += otro.componentes[j];
+        return *this;
+    }
+};
+
+// Estimación de las K integrales: cada componente con su error y la matriz de
+// covarianza de las estimaciones (K x K, por filas; su diagonal es error^2)
+struct ResultadoVectorial {
+    std::vector<Resultado> componentes;
+    std::vector<double> covarianza;
+    long long muestras = 0;
+};
+
+inline ResultadoVectorial estimar(const MomentosVectoriales& m, long long N, double volumen) {
+    const int K = m.K;
+    ResultadoVectorial r;
+    r.muestras = N;
+    r.covarianza.assign(std::size_t(K) * K, 0.0);
+    for (int j = 0; j < K; j++) {
+        r.componentes.push_back(estimar(m.componentes[j], N, volumen));
+        r.covarianza[std::size_t(j) * K + j] = r.componentes[j].error * r.componentes[j].error;
+    }
+    // cov(I_j, I_l) = V^2 cov(f_j, f_l) / N
+    for (int j = 0; j < K; j++) {
+        for (int l = j + 1; l < K; l++) {
+            double c = volumen * volumen * m.covarianza(j, l) / N;
+            r.covarianza[std::size_t(j) * K + l] = r.covarianza[std::size_t(l) * K + j] = c;
+        }
+    }
+    return r;
+}
+
+// Varianza efectiva que no se distingue del redondeo de la varianza de f
+constexpr double VARIANZA_RESIDUAL_NULA = 1024 * std::numeric_limits<double>::epsilon();
+
+// Cociente varianza / residual en r, o varianza_eliminada si la residual es
+// nula o del orden del redondeo (el cociente saldría inf, o NaN si f es constante)
+inline void asignar_reduccion(Resultado& r, double varianza, double residual) {
+    if (residual <= VARIANZA_RESIDUAL_NULA * varianza) {
+        r.varianza_eliminada = true;
+        r.reduccion_varianza = 0.0;
+    } else {
+        r.reduccion_varianza = varianza / residual;
+    }
+}
+
+// Variables antitéticas: m tiene los momentos de f(x) (componente 0), de f(x')
+// (componente 1) y su co-momento, para P pares. Cada par es una muestra de
+// (f(x) + f(x')) / 2; la reducción compara su varianza con la de dos
+// evaluaciones independientes, var(f) / 2.
+inline Resultado estimar_antitetico(const MomentosVectoriales& m, long long P, double volumen) {
+    // Las 2P evaluaciones de f juntas
+    Momentos f = m.componentes[0];
+    f += m.componentes[1];
+
+    double varianza_par =
+        (m.componentes[0].varianza() + m.componentes[1].varianza() + 2.0 * m.covarianza(0, 1)) / 4.0;
+    if (varianza_par < 0.0) varianza_par = 0.0;
+
+    Resultado r;
+    r.varianza = f.varianza();
+    r.integral = f.promedio() * volumen;
+    r.error = volumen * std::sqrt(varianza_par / P);
+    r.muestras = 2 * P;
+    asignar_reduccion(r, r.varianza, 2.0 * varianza_par);
+    return r;
+}
+
+// Variable de control: m tiene los momentos de f (componente 0), de h
+// (componente 1) y su co-momento, para N puntos; integral_control es la
+// integral exacta de h. El coeficiente óptimo beta = cov(f, h) / var(h) se
+// calcula con los momentos ya combinados entre hilos y procesos, así que es el
+// mismo que con una sola corrida secuencial. I = V (<f> - beta (<h> - <h>_exacto)),
+// con varianza var(f) - cov(f, h)^2 / var(h) = var(f) (1 - rho^2).
+inline Resultado estimar_con_control(const MomentosVectoriales& m, long long N, double volumen,
+                                     double integral_control) {
+    const Momentos& f = m.componentes[0];
+    const Momentos& h = m.componentes[1];
+    double varianza_f = f.varianza();
+    double varianza_h = h.varianza();
+    double covarianza = m.covarianza(0, 1);
+
+    double beta = varianza_h > 0.0 ? covarianza / varianza_h : 0.0;
+    double varianza_residual = varianza_f - beta * covarianza;
+    if (varianza_residual < 0.0) varianza_residual = 0.0;
+
+    Resultado r;
+    r.varianza = varianza_f;
+    r.integral = volumen * (f.promedio() - beta * (h.promedio() - integral_control / volumen));
+    r.error = volumen * std::sqrt(varianza_residual / N);
+    r.muestras = N;
+    asignar_reduccion(r, varianza_f, varianza_residual);
+    r.coeficiente_control = beta;
+    return r;
+}
+
+} // namespace montecarlo
@@ -0,0 +1,29 @@
+#pragma once
+
+// Biblioteca de integración Monte Carlo (solo cabeceras).
+// La parte MPI vive aparte en distribuido.hpp para no exigir mpi.h
+// a los ejecutables secuenciales y de memoria compartida.
+
+#include "cache.hpp"
+#include "cubatura.hpp"
+#include "ejecucion.hpp"
+#include "expresion.hpp"
+#include "integrando.hpp"
+#include "lotes.hpp"
+#include "miser.hpp"
+#include "momentos.hpp"
+#include "motores.hpp"
+#include "muestras.hpp"
+#include "nucleo.hpp"
+#include "objetivo.hpp"
+#include "paralelo.hpp"
+#include "parametros.hpp"
+#include "philox.hpp"
+#include "plugin.hpp"
+#include "punto_control.hpp"
+#include "qmc.hpp"
+#include "reduccion_varianza.hpp"
+#include "reporte.hpp"
+#include "templado.hpp"
+#include "vectorial.hpp"
+#include "vegas.hpp"
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+#include "nucleo.hpp"
+#include "philox.hpp"
+
+namespace montecarlo {
+
+// Mezclador SplitMix64 (Steele, Lea y Flood, OOPSLA'14)
+inline std::uint64_t mezclar64(std::uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Semilla de la réplica o iteración i: la 0 usa la semilla tal cual
+inline std::uint64_t derivar_semilla(std::uint64_t semilla, std::uint64_t i) {
+    return i == 0 ? semilla : mezclar64(semilla + 0x9E3779B97F4A7C15ULL * i);
+}
+
+inline std::uint64_t rotl64(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+inline std::uint64_t rotr64(std::uint64_t x, int k) { return (x >> k) | (x << ((64 - k) & 63)); }
+
+// ---------------------------------------------------------------------------
+// Motores secuenciales de 64 bits. Todos ofrecen sembrar(semilla), avanzar(n)
+// y operator()() que devuelve 64 bits aleatorios.
+// ---------------------------------------------------------------------------
+
+// SplitMix64: un contador con paso fijo; avanzar es O(1)
+class SplitMix64 {
+public:
+    static constexpr const char* nombre = "splitmix64";
+
+    void sembrar(std::uint64_t semilla) { estado = semilla; }
+    void avanzar(std::uint64_t n) { estado += n * GAMMA; }
+
+    std::uint64_t operator()() {
+        estado += GAMMA;
+        return mezclar64(estado);
+    }
+
+private:
+    static constexpr std::uint64_t GAMMA = 0x9E3779B97F4A7C15ULL;
+    std::uint64_t estado = 0;
+};
+
+// xoshiro256++ (Blackman y Vigna, 2019)
+class Xoshiro256pp {
+public:
+    static constexpr const char* nombre = "xoshiro256++";
+
+    void sembrar(std::uint64_t semilla) {
+        SplitMix64 sm;
+        sm.sembrar(semilla);
+        for (auto& palabra : s) palabra = sm();
+    }
+
+    void avanzar(std::uint64_t n) {
+        while (n--) (*this)();
+    }
+
+    std::uint64_t operator()() {
+        const std::uint64_t resultado = rotl64(s[0] + s[3], 23) + s[0];
+        const std::uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl64(s[3], 45);
+        return resultado;
+    }
+
+private:
+    std::uint64_t s[4] = {0, 0, 0, 0};
+};
+
+// PCG64 (O'Neill, 2014): LCG de 128 bits con salida XSL-RR; avanzar es O(log n)
+class PCG64 {
+public:
+    static constexpr const char* nombre = "pcg64";
+
+    void sembrar(std::uint64_t semilla) {
+        estado = 0;
+        (*this)();
+        estado += (u128(mezclar64(semilla)) << 64) | mezclar64(semilla + 1);
+        (*this)();
+    }
+
+    // Salto del LCG: se componen las potencias de (a, c) según los bits de n
+    void avanzar(std::uint64_t n) {
+        u128 a = MULTIPLICADOR, c = INCREMENTO;
+        u128 a_total = 1, c_total = 0;
+        while (n > 0) {
+            if (n & 1) {
+                a_total *= a;
+                c_total = c_total * a + c;
+            }
+            c = (a + 1) * c;
+            a *= a;
+            n >>= 1;
+        }
+        estado = a_total * estado + c_total;
+    }
+
+    std::uint64_t operator()() {
+        estado = estado * MULTIPLICADOR + INCREMENTO;
+        return rotr64(std::uint64_t(estado >> 64) ^ std::uint64_t(estado), int(estado >> 122));
+    }
+
+private:
+    using u128 = unsigned __int128;
+    static constexpr u128 MULTIPLICADOR = (u128(0x2360ED051FC65DA4ULL) << 64) | 0x4385DF649FCCF645ULL;
+    static constexpr u128 INCREMENTO = (u128(0x5851F42D4C957F2DULL) << 64) | 0x14057B7EF767814FULL;
+    u128 estado = 0;
+};
+
+// Mersenne Twister de 64 bits de la biblioteca estándar
+class MT19937_64 {
+public:
+    static constexpr const char* nombre = "mt19937_64";
+
+    void sembrar(std::uint64_t semilla) { generador.seed(semilla); }
+    void avanzar(std::uint64_t n) { generador.discard(n); }
+    std::uint64_t operator()() { return generador(); }
+
+private:
+    std::mt19937_64 generador;
+};
+
+// ---------------------------------------------------------------------------
+// Flujo indexado sobre un motor secuencial
+// ---------------------------------------------------------------------------
+
+// Misma interfaz que FlujoPhilox. El motor se vuelve a sembrar al inicio de
+// cada bloque de TAMANO_BLOQUE muestras con una semilla derivada de (seed,
+// bloque), así que el resultado sigue sin depender de hilos ni procesos; un
+// salto dentro del bloque cuesta motor.avanzar().
+template <class Motor>
+class FlujoMotor {
+public:
+    FlujoMotor(std::uint64_t seed, int dimensiones)
+        : seed(seed), sorteos_por_bloque(std::uint64_t(TAMANO_BLOQUE) * std::uint64_t(dimensiones)),
+          d(std::uint64_t(dimensiones)) {}
+
+    void saltar_a_muestra(std::uint64_t i) { posicionar(i * d); }
+
+    void posicionar(std::uint64_t j) {
+        std::uint64_t bloque = j / sorteos_por_bloque;
+        if (bloque != bloque_actual || j < sorteo) {
+            motor.sembrar(mezclar64(seed ^ mezclar64(bloque + 0x632BE59BD9B4E019ULL)));
+            bloque_actual = bloque;
+            sorteo = bloque * sorteos_por_bloque;
+            limite = sorteo + sorteos_por_bloque;
+        }
+        motor.avanzar(j - sorteo);
+        sorteo = j;
+    }
+
+    double operator()() {
+        if (sorteo == limite) posicionar(sorteo);
+        sorteo++;
+        return a_unidad(motor());
+    }
+
+    // Llenado masivo: sin ramas por sorteo dentro de un bloque
+    void llenar(double* destino, std::size_t n) {
+        std::size_t hechos = 0;
+        while (hechos < n) {
+            if (sorteo == limite) posicionar(sorteo);
+            std::uint64_t quedan = limite - sorteo;
+            std::size_t tramo = n - hechos < quedan ? n - hechos : std::size_t(quedan);
+            for (std::size_t t = 0; t < tramo; t++) destino[hechos + t] = a_unidad(motor());
+            hechos += tramo;
+            sorteo += tramo;
+        }
+    }
+
+private:
+    Motor motor;
+    std::uint64_t seed;
+    std::uint64_t sorteos_por_bloque;
+    std::uint64_t d;
+    std::uint64_t bloque_actual = ~std::uint64_t(0);
+    std::uint64_t sorteo = 0;
+    std::uint64_t limite = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Selección del motor en tiempo de ejecución
+// ---------------------------------------------------------------------------
+
+enum class Motor { PHILOX, XOSHIRO, PCG64, SPLITMIX, MT64 };
+
+inline const char* nombre(Motor motor) {
+    switch (motor) {
+        case Motor::XOSHIRO: return Xoshiro256pp::nombre;
+        case Motor::PCG64: return PCG64::nombre;
+        case Motor::SPLITMIX: return SplitMix64::nombre;
+        case Motor::MT64: return MT19937_64::nombre;
+        default: return "philox";
+    }
+}
+
+// Interpreta el nombre de --motor; devuelve false si no se reconoce
+inline bool leer_motor(const char* texto, Motor& motor) {
+    const Motor todos[] = {Motor::PHILOX, Motor::XOSHIRO, Motor::PCG64, Motor::SPLITMIX, Motor::MT64};
+    for (Motor m : todos) {
+        if (std::strcmp(texto, nombre(m)) == 0) {
+            motor = m;
+            return true;
+        }
+    }
+    if (std::strcmp(texto, "xoshiro") == 0) { motor = Motor::XOSHIRO; return true; }
+    if (std::strcmp(texto, "splitmix") == 0) { motor = Motor::SPLITMIX; return true; }
+    if (std::strcmp(texto, "mt") == 0) { motor = Motor::MT64; return true; }
+    return false;
+}
+
+// Etiqueta de tipo para pasar un tipo de flujo a una lambda genérica
+template <class T>
+struct Tipo {
+    using type = T;
+};
+
+// Llama a funcion(Tipo<Flujo>{}) con el flujo correspondiente al motor elegido
+template <class Funcion>
+decltype(auto) despachar_motor(Motor motor, Funcion&& funcion) {
+    switch (motor) {
+        case Motor::XOSHIRO: return funcion(Tipo<FlujoMotor<Xoshiro256pp>>{});
+        case Motor::PCG64: return funcion(Tipo<FlujoMotor<PCG64>>{});
+        case Motor::SPLITMIX: return funcion(Tipo<FlujoMotor<SplitMix64>>{});
+        case Motor::MT64: return funcion(Tipo<FlujoMotor<MT19937_64>>{});
+        default: return funcion(Tipo<FlujoPhilox>{});
+    }
+}
+
+} // namespace montecarlo
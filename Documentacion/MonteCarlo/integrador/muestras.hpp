@@ -0,0 +1,380 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "momentos.hpp"
+#include "motores.hpp"
+#include "nucleo.hpp"
+#include "openmp.hpp"
+#include "parametros.hpp"
+#include "simd.hpp"
+#include "topologia.hpp"
+
+namespace montecarlo {
+
+// Almacén de muestras (--store archivo): los puntos y los valores de f de cada
+// bloque integrado, para volver a usarlos sin evaluar f otra vez.
+//
+// Formato: una cabecera fija y registros de bloque en el orden en que se
+// terminan. Cada registro es (inicio, n) seguido de d + 1 columnas de n
+// doubles: las d coordenadas y los valores, es decir, el bloque SoA que
+// evaluar_lote recibe. Todo está alineado a 8 bytes, así que un lector que
+// mapea el archivo usa las columnas en su lugar. Un corte a mitad de escritura
+// solo pierde el último registro.
+
+constexpr char FIRMA_MUESTRAS[8] = {'M', 'C', 'M', 'U', '0', '0', '0', '1'};
+
+struct CabeceraMuestras {
+    char firma[8];
+    std::int32_t dimensiones = 0;
+    std::int32_t motor = 0;
+    std::int32_t muestreo = 0;
+    std::int32_t precision_mixta = 0;
+    double lim_inf = 0.0;
+    double lim_sup = 0.0;
+    std::uint64_t seed = 0;
+    std::int64_t N = 0;
+
+    // Procesos de la corrida y proceso escritor (con MPI, un archivo por proceso)
+    std::int32_t procesos = 1;
+    std::int32_t proceso = 0;
+};
+
+struct RegistroMuestras {
+    std::int64_t inicio;
+    std::int64_t n;
+};
+
+// Columnas de un bloque en memoria: la k empieza en datos + k * n y los
+// valores en datos + d * n
+struct BloqueMuestras {
+    long long inicio = 0;
+    long long n = 0;
+    std::vector<double> datos;
+};
+
+// Escritura en segundo plano. Los hilos de muestreo toman un búfer libre,
+// lo llenan con un bloque y lo entregan; un hilo escritor los graba en orden
+// de llegada y los devuelve. Hay dos búferes por hilo de muestreo: mientras
+// uno se escribe, el hilo llena el otro. Solo si el disco no da abasto un hilo
+// espera un búfer libre (el tiempo de espera se informa al cerrar).
+class EscritorMuestras {
+public:
+    EscritorMuestras(const std::string& ruta, const CabeceraMuestras& cabecera, int hilos)
+        : ruta(ruta), d(std::size_t(cabecera.dimensiones)), limite(2 * std::size_t(hilos)) {
+        archivo = std::fopen(ruta.c_str(), "wb");
+        if (!archivo) return;
+        ok = std::fwrite(&cabecera, sizeof(cabecera), 1, archivo) == 1;
+        escritor = std::thread([this] { atender(); });
+    }
+
+    ~EscritorMuestras() { cerrar(); }
+
+    EscritorMuestras(const EscritorMuestras&) = delete;
+    EscritorMuestras& operator=(const EscritorMuestras&) = delete;
+
+    bool abierto() const { return archivo != nullptr; }
+
+    // Búfer libre para el bloque [inicio, inicio + n). Los búferes se crean a
+    // pedido, así que cada uno se toca primero desde el hilo que lo llena.
+    BloqueMuestras* tomar(long long inicio, long long n) {
+        BloqueMuestras* bloque;
+        {
+            std::unique_lock<std::mutex> cerrojo(mutex);
+            if (libres.empty() && creados < limite) {
+                creados++;
+                bloques.emplace_back(new BloqueMuestras);
+                bloque = bloques.back().get();
+            } else {
+                if (libres.empty()) {
+                    const double t0 = tiempo_pared();
+                    aviso_libre.wait(cerrojo, [this] { return !libres.empty(); });
+                    espera += tiempo_pared() - t0;
+                }
+                bloque = libres.back();
+                libres.pop_back();
+            }
+        }
+        bloque->inicio = inicio;
+        bloque->n = n;
+        bloque->datos.resize((d + 1) * std::size_t(n));
+        return bloque;
+    }
+
+    void entregar(BloqueMuestras* bloque) {
+        {
+            std::lock_guard<std::mutex> cerrojo(mutex);
+            pendientes.push_back(bloque);
+        }
+        aviso_pendiente.notify_one();
+    }
+
+    // Espera a que se escriba todo lo entregado y cierra el archivo; devuelve
+    // false si alguna escritura falló
+    bool cerrar() {
+        if (!archivo) return ok;
+        {
+            std::lock_guard<std::mutex> cerrojo(mutex);
+            terminar = true;
+        }
+        aviso_pendiente.notify_one();
+        escritor.join();
+        ok = (std::fclose(archivo) == 0) && ok;
+        archivo = nullptr;
+        return ok;
+    }
+
+    long long muestras() const { return escritas; }
+    double segundos_espera() const { return espera; }
+    const std::string& nombre() const { return ruta; }
+
+private:
+    static double tiempo_pared() {
+        using namespace std::chrono;
+        return duration<double>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    void atender() {
+        std::unique_lock<std::mutex> cerrojo(mutex);
+        while (true) {
+            aviso_pendiente.wait(cerrojo, [this] { return !pendientes.empty() || terminar; });
+            if (pendientes.empty()) return;
+            BloqueMuestras* bloque = pendientes.front();
+            pendientes.pop_front();
+            cerrojo.unlock();
+
+            const RegistroMuestras registro{bloque->inicio, bloque->n};
+            ok = ok && std::fwrite(&registro, sizeof(registro), 1, archivo) == 1;
+            ok = ok && std::fwrite(bloque->datos.data(), sizeof(double), bloque->datos.size(), archivo) ==
+                           bloque->datos.size();
+            escritas += bloque->n;
+
+            cerrojo.lock();
+            libres.push_back(bloque);
+            aviso_libre.notify_one();
+        }
+    }
+
+    std::string ruta;
+    std::size_t d;
+    std::size_t limite;
+    std::FILE* archivo = nullptr;
+    bool ok = false;
+
+    std::mutex mutex;
+    std::condition_variable aviso_pendiente, aviso_libre;
+    std::vector<std::unique_ptr<BloqueMuestras>> bloques;
+    std::vector<BloqueMuestras*> libres;
+    std::deque<BloqueMuestras*> pendientes;
+    std::size_t creados = 0;
+    bool terminar = false;
+
+    long long escritas = 0;
+    double espera = 0.0;
+    std::thread escritor;
+};
+
+// Escritor activo: integrar le entrega cada bloque (nullptr: no se guardan muestras)
+inline EscritorMuestras* escritor_muestras = nullptr;
+
+// Con --store, activa la captura de muestras mientras existe. Con MPI cada
+// proceso escribe archivo.<proceso>. Al destruirse espera al escritor e
+// informa lo guardado.
+class CapturaMuestras {
+public:
+    explicit CapturaMuestras(const Parametros& p, int proceso = -1, int procesos = 1) {
+        if (p.almacen.empty()) return;
+        CabeceraMuestras cabecera;
+        std::memcpy(cabecera.firma, FIRMA_MUESTRAS, sizeof(cabecera.firma));
+        cabecera.dimensiones = p.dimensiones;
+        cabecera.motor = int(p.motor);
+        cabecera.muestreo = int(p.muestreo);
+        cabecera.precision_mixta = p.precision_mixta;
+        cabecera.lim_inf = p.lim_inf;
+        cabecera.lim_sup = p.lim_sup;
+        cabecera.seed = p.seed;
+        cabecera.N = p.N;
+        cabecera.procesos = procesos;
+        cabecera.proceso = proceso < 0 ? 0 : proceso;
+
+        const std::string ruta = proceso < 0 ? p.almacen : p.almacen + "." + std::to_string(proceso);
+        escritor.reset(new EscritorMuestras(ruta, cabecera, hilos_disponibles()));
+        if (!escritor->abierto()) {
+            std::cerr << "No se pudo abrir el almacén de muestras " << ruta << std::endl;
+            exit(1);
+        }
+        escritor_muestras = escritor.get();
+    }
+
+    ~CapturaMuestras() {
+        if (!escritor) return;
+        escritor_muestras = nullptr;
+        if (!escritor->cerrar()) {
+            std::cerr << "No se pudo escribir el almacén de muestras " << escritor->nombre() << std::endl;
+            return;
+        }
+        std::cout << "Muestras guardadas: " << escritor->muestras() << " en " << escritor->nombre()
+                  << " (espera por el disco: " << escritor->segundos_espera() << " s)" << std::endl;
+    }
+
+    CapturaMuestras(const CapturaMuestras&) = delete;
+    CapturaMuestras& operator=(const CapturaMuestras&) = delete;
+
+private:
+    std::unique_ptr<EscritorMuestras> escritor;
+};
+
+// Bloque de un archivo mapeado: columnas en su lugar, sin copia
+struct BloqueMapeado {
+    long long inicio;
+    long long n;
+    const double* columnas;  // la k en columnas + k * n, los valores en columnas + d * n
+
+    const double* valores(int d) const { return columnas + std::size_t(d) * std::size_t(n); }
+};
+
+// Lectura de un almacén con mmap. Solo recorre las cabeceras de los registros
+// para indexarlos; los datos se leen cuando se usan.
+class LectorMuestras {
+public:
+    LectorMuestras() = default;
+    ~LectorMuestras() {
+        if (mapa) munmap(mapa, tamano);
+    }
+
+    LectorMuestras(const LectorMuestras&) = delete;
+    LectorMuestras& operator=(const LectorMuestras&) = delete;
+
+    // Devuelve false con el motivo en error si el archivo no es un almacén
+    bool abrir(const std::string& ruta, std::string& error) {
+        const int descriptor = open(ruta.c_str(), O_RDONLY | O_CLOEXEC);
+        if (descriptor < 0) {
+            error = "no se pudo abrir " + ruta;
+            return false;
+        }
+        struct stat datos;
+        if (fstat(descriptor, &datos) != 0 || std::size_t(datos.st_size) < sizeof(CabeceraMuestras)) {
+            close(descriptor);
+            error = ruta + " no es un almacén de muestras";
+            return false;
+        }
+        tamano = std::size_t(datos.st_size);
+        void* direccion = mmap(nullptr, tamano, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        close(descriptor);
+        if (direccion == MAP_FAILED) {
+            error = "no se pudo mapear " + ruta;
+            return false;
+        }
+        mapa = direccion;
+        madvise(mapa, tamano, MADV_SEQUENTIAL);
+
+        const char* base = static_cast<const char*>(mapa);
+        std::memcpy(&cabecera_, base, sizeof(cabecera_));
+        if (std::memcmp(cabecera_.firma, FIRMA_MUESTRAS, sizeof(cabecera_.firma)) != 0 || cabecera_.dimensiones <= 0) {
+            error = ruta + " no es un almacén de muestras";
+            return false;
+        }
+
+        // Registros completos; uno truncado (corrida interrumpida) se descarta
+        const std::size_t columnas = std::size_t(cabecera_.dimensiones) + 1;
+        std::size_t posicion = sizeof(CabeceraMuestras);
+        while (posicion + sizeof(RegistroMuestras) <= tamano) {
+            RegistroMuestras registro;
+            std::memcpy(&registro, base + posicion, sizeof(registro));
+            const std::size_t bytes = columnas * std::size_t(registro.n) * sizeof(double);
+            if (registro.n <= 0 || posicion + sizeof(registro) + bytes > tamano) break;
+            bloques_.push_back({registro.inicio, registro.n,
+                                reinterpret_cast<const double*>(base + posicion + sizeof(registro))});
+            muestras_ += registro.n;
+            posicion += sizeof(registro) + bytes;
+        }
+        return true;
+    }
+
+    const CabeceraMuestras& cabecera() const { return cabecera_; }
+    const std::vector<BloqueMapeado>& bloques() const { return bloques_; }
+    long long muestras() const { return muestras_; }
+
+private:
+    void* mapa = nullptr;
+    std::size_t tamano = 0;
+    CabeceraMuestras cabecera_;
+    std::vector<BloqueMapeado> bloques_;
+    long long muestras_ = 0;
+};
+
+// Momentos de g(x) f(x) por bloque, con g = peso(x) * 1[x en el subcubo
+// [sub_inf, sub_sup]^d] (sin peso, g = 1; sin subcubo, todo el dominio). Las
+// muestras son uniformes en el dominio de volumen V, así que V * media es la
+// integral de g f sobre el dominio. El peso se evalúa sobre las columnas
+// mapeadas, sin copiarlas.
+template <class Peso>
+std::vector<Momentos> momentos_por_bloque(const std::vector<const LectorMuestras*>& lectores, const Peso* peso,
+                                          double sub_inf, double sub_sup) {
+    struct Tarea {
+        const BloqueMapeado* bloque;
+        int d;
+    };
+    std::vector<Tarea> tareas;
+    for (const LectorMuestras* lector : lectores) {
+        for (const BloqueMapeado& b : lector->bloques()) tareas.push_back({&b, lector->cabecera().dimensiones});
+    }
+
+    std::vector<Momentos> momentos(tareas.size());
+    MONTECARLO_OMP(parallel)
+    {
+        std::vector<double> pesos;
+        MONTECARLO_OMP(for schedule(dynamic))
+        for (long long t = 0; t < (long long)tareas.size(); t++) {
+            const BloqueMapeado& b = *tareas[t].bloque;
+            const std::size_t n = std::size_t(b.n), d = std::size_t(tareas[t].d);
+            pesos.assign(n, 1.0);
+            if (peso) peso->evaluar_lote(b.columnas, n, d, pesos.data());
+            for (std::size_t k = 0; k < d; k++) {
+                const double* x = b.columnas + k * n;
+                for (std::size_t i = 0; i < n; i++) {
+                    if (x[i] < sub_inf || x[i] > sub_sup) pesos[i] = 0.0;
+                }
+            }
+            const double* f = b.valores(tareas[t].d);
+            for (std::size_t i = 0; i < n; i++) pesos[i] *= f[i];
+            momentos[t] = simd::sumar(pesos.data(), n);
+        }
+    }
+    return momentos;
+}
+
+// Error bootstrap de V * media: B remuestreos de los bloques con reemplazo
+// (los bloques son independientes; dentro de uno las muestras también, salvo
+// con Sobol o Halton, y remuestrear bloques enteros respeta esa estructura)
+inline double error_bootstrap(const std::vector<Momentos>& bloques, double volumen, int B, unsigned long long seed) {
+    if (bloques.size() < 2 || B < 2) return 0.0;
+    SplitMix64 uniforme;
+    uniforme.sembrar(seed);
+    Momentos estimaciones;
+    for (int r = 0; r < B; r++) {
+        Momentos m;
+        for (std::size_t i = 0; i < bloques.size(); i++) m += bloques[uniforme() % bloques.size()];
+        estimaciones.agregar(volumen * m.promedio());
+    }
+    return std::sqrt(estimaciones.m2 / (B - 1));
+}
+
+} // namespace montecarlo
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "momentos.hpp"
+
+namespace montecarlo {
+
+// Hipercubo [lim_inf, lim_sup]^d sobre el que se integra
+struct Dominio {
+    double lim_inf;
+    double lim_sup;
+    int dimensiones;
+
+    double ancho() const { return lim_sup - lim_inf; }
+
+    // Volumen del hipercubo
+    double volumen() const {
+        double volumen = 1.0;
+        for (int d = 0; d < dimensiones; d++) {
+            volumen *= ancho();
+        }
+        return volumen;
+    }
+};
+
+// Dimensiones con camino especializado en tiempo de compilación
+constexpr int DIMENSION_MAXIMA_FIJA = 16;
+
+// Dimensión máxima de una integral: cada hilo reserva lotes de d * TAMANO_LOTE
+// doubles (unos 24 MB por hilo en la máxima), así que una d absurda se rechaza
+// antes de reservar
+constexpr int DIMENSION_MAXIMA = 4096;
+
+// Punto multidimensional de tamaño fijo: vive en la pila, sin malloc por muestra
+template <int D>
+struct Punto {
+    std::array<double, D> coordenadas;
+
+    explicit Punto(int) {}
+    static constexpr std::size_t size() { return D; }
+    double& operator[](std::size_t i) { return coordenadas[i]; }
+    const double& operator[](std::size_t i) const { return coordenadas[i]; }
+};
+
+// Punto dinámico (D == 0): un único buffer reservado antes del bucle
+template <>
+struct Punto<0> {
+    std::vector<double> coordenadas;
+
+    explicit Punto(int dimensiones) : coordenadas(dimensiones) {}
+    std::size_t size() const { return coordenadas.size(); }
+    double& operator[](std::size_t i) { return coordenadas[i]; }
+    const double& operator[](std::size_t i) const { return coordenadas[i]; }
+};
+
+// Subrango [inicio, fin) de las N muestras asignado a un hilo o proceso
+struct Rango {
+    long long inicio;
+    long long fin;
+
+    long long tamano() const { return fin - inicio; }
+};
+
+// Subdivisión del rango de trabajo: si N no es múltiplo de partes,
+// se suma 1 a las partes de índice menor
+inline Rango repartir(long long N, int partes, int indice) {
+    long long nlocal = N / partes;
+    long long rest = N % partes;
+
+    long long inicio = nlocal * indice + (indice < rest ? indice : rest);
+    if (indice < rest) nlocal++;
+
+    return {inicio, inicio + nlocal};
+}
+
+// Muestras por bloque reproducible. Los bloques están alineados a índices
+// absolutos (el bloque b cubre [b*TAMANO_BLOQUE, (b+1)*TAMANO_BLOQUE)) y siempre
+// se suman de forma secuencial, de modo que sus momentos no dependen de quién
+// los calcula.
+constexpr long long TAMANO_BLOQUE = 1 << 14;
+
+// Igual que repartir, pero sobre las muestras [muestras.inicio, muestras.fin) y
+// con cortes en fronteras de bloque absolutas: el primer y el último bloque
+// pueden quedar recortados, como en integrar
+inline Rango repartir_bloques(Rango muestras, int partes, int indice) {
+    long long primero = muestras.inicio / TAMANO_BLOQUE;
+    long long ultimo = (muestras.fin + TAMANO_BLOQUE - 1) / TAMANO_BLOQUE;
+    Rango r = repartir(ultimo - primero, partes, indice);
+    long long inicio = (primero + r.inicio) * TAMANO_BLOQUE;
+    long long fin = (primero + r.fin) * TAMANO_BLOQUE;
+    if (inicio < muestras.inicio) inicio = muestras.inicio;
+    if (fin > muestras.fin) fin = muestras.fin;
+    return {inicio < fin ? inicio : fin, fin};
+}
+
+inline Rango repartir_bloques(long long N, int partes, int indice) {
+    return repartir_bloques(Rango{0, N}, partes, indice);
+}
+
+// Bucle principal de Monte Carlo para una dimensión D fija (o dinámica si D == 0)
+template <int D, class F, class Uniforme>
+Momentos acumular(const F& func, const Dominio& dominio, Uniforme& uniforme, long long n) {
+    Punto<D> punto(dominio.dimensiones);
+    const double lim_inf = dominio.lim_inf;
+    const double ancho = dominio.ancho();
+
+    Momentos momentos;
+    for (long long i = 0; i < n; i++) {
+        // Generar punto multidimensional y escalarlo al hipercubo
+        for (std::size_t d = 0; d < punto.size(); d++) {
+            punto[d] = lim_inf + ancho * uniforme();
+        }
+
+        // Evaluar función y acumular
+        momentos.agregar(func(punto));
+    }
+    return momentos;
+}
+
+namespace detalle {
+
+template <int D, class Funcion>
+decltype(auto) despachar_dimension(int dimensiones, Funcion& funcion) {
+    if constexpr (D > DIMENSION_MAXIMA_FIJA) {
+        return funcion(std::integral_constant<int, 0>{});
+    } else {
+        if (dimensiones == D) return funcion(std::integral_constant<int, D>{});
+        return despachar_dimension<D + 1>(dimensiones, funcion);
+    }
+}
+
+} // namespace detalle
+
+// Llama a funcion(std::integral_constant<int, D>) con D = dimensiones si
+// 1 <= dimensiones <= DIMENSION_MAXIMA_FIJA, o con D = 0 (camino dinámico) si no
+template <class Funcion>
+decltype(auto) despachar_dimension(int dimensiones, Funcion&& funcion) {
+    return detalle::despachar_dimension<1>(dimensiones, funcion);
+}
+
+} // namespace montecarlo
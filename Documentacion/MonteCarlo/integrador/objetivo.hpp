@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cmath>
+
+#include "instrumentacion.hpp"
+#include "lotes.hpp"
+#include "momentos.hpp"
+#include "nucleo.hpp"
+#include "openmp.hpp"
+#include "paralelo.hpp"
+#include "parametros.hpp"
+
+namespace montecarlo {
+
+// Muestras mínimas antes de evaluar el criterio: con pocas muestras la varianza
+// estimada es poco confiable y detenerse temprano sesga el resultado
+constexpr long long MUESTRAS_MINIMAS_OBJETIVO = 4 * TAMANO_BLOQUE;
+
+// Error pedido para una integral estimada: max(objetivo_abs, objetivo_rel * |I|)
+inline double tolerancia_objetivo(const Parametros& p, double integral) {
+    return std::fmax(p.objetivo_abs, p.objetivo_rel * std::fabs(integral));
+}
+
+// ¿El error V*sqrt(var/n) alcanza la tolerancia pedida?
+inline bool objetivo_cumplido(const Parametros& p, const Momentos& m, double volumen) {
+    if (m.n < MUESTRAS_MINIMAS_OBJETIVO || (p.objetivo_abs <= 0.0 && p.objetivo_rel <= 0.0)) return false;
+    double error = volumen * std::sqrt(m.varianza() / double(m.n));
+    return error <= tolerancia_objetivo(p, volumen * m.promedio());
+}
+
+// Resultado de la precisión objetivo y si se alcanzó antes de agotar --n o
+// --max-time
+struct ResultadoObjetivo {
+    Resultado resultado;
+    double tolerancia = 0.0;
+    bool alcanzado = false;
+};
+
+// Muestrea hasta alcanzar la precisión pedida, hasta N muestras o hasta
+// p.tiempo_maximo segundos. Cada hilo toma el bloque siguiente de un contador
+// atómico, lo suma al total y evalúa el criterio; el primero que lo cumple
+// levanta una bandera que los demás leen antes de tomar otro bloque, sin
+// barreras entre lotes. Todo bloque tomado se termina, así que las muestras
+// usadas son siempre un prefijo [0, n) de la secuencia.
+template <class Flujo, class F>
+ResultadoObjetivo integrar_hasta_objetivo(const F& func, const Dominio& dominio, const Parametros& p) {
+    const long long ultimo = (p.N + TAMANO_BLOQUE - 1) / TAMANO_BLOQUE;
+    const double volumen = dominio.volumen();
+    const double inicio_tiempo = tiempo();
+
+    Momentos total;
+    long long siguiente = 0;
+    bool detener = false;
+    bool alcanzado = false;
+
+    despachar_muestreo<F>(dominio.dimensiones, [&](auto D) {
+        constexpr int DIM = decltype(D)::value;
+
+        MONTECARLO_OMP(parallel)
+        {
+            fijar_hilo();
+            Flujo flujo(p.seed, dominio.dimensiones);
+            EspacioLote espacio(dominio.dimensiones);
+
+            while (true) {
+                bool parar;
+                MONTECARLO_OMP(atomic read)
+                parar = detener;
+                if (parar) break;
+
+                long long b;
+                MONTECARLO_OMP(atomic capture)
+                b = siguiente++;
+                if (b >= ultimo) break;
+
+                long long inicio = b * TAMANO_BLOQUE;
+                long long fin = inicio + TAMANO_BLOQUE < p.N ? inicio + TAMANO_BLOQUE : p.N;
+                Momentos bloque;
+                {
+                    TramoInstrumentado tramo(Fase::BLOQUE, fin - inicio);
+                    flujo.saltar_a_muestra(inicio);
+                    bloque = muestrear<DIM>(func, dominio, flujo, fin - inicio, espacio);
+                }
+
+                // Con --profile, la suma al total y el criterio cuentan como reducción
+                bool listo;
+                TramoInstrumentado tramo(Fase::REDUCCION);
+                MONTECARLO_OMP(critical)
+                {
+                    total += bloque;
+                    if (objetivo_cumplido(p, total, volumen)) alcanzado = true;
+                    listo = alcanzado || (p.tiempo_maximo > 0.0 && tiempo() - inicio_tiempo > p.tiempo_maximo);
+                }
+                if (listo) {
+                    MONTECARLO_OMP(atomic write)
+                    detener = true;
+                }
+            }
+        }
+        return 0;
+    });
+
+    ResultadoObjetivo r;
+    r.resultado = estimar(total, total.n, volumen);
+    r.tolerancia = tolerancia_objetivo(p, r.resultado.integral);
+    r.alcanzado = alcanzado;
+    return r;
+}
+
+// Igual que la anterior, con el motor y la semilla de la línea de comando
+template <class F>
+ResultadoObjetivo integrar_hasta_objetivo(const F& func, const Dominio& dominio, const Parametros& p) {
+    return despachar_motor(p.motor, [&](auto tipo) {
+        using Flujo = typename decltype(tipo)::type;
+        return integrar_hasta_objetivo<Flujo>(func, dominio, p);
+    });
+}
+
+} // namespace montecarlo
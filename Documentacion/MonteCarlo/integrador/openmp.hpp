@@ -0,0 +1,15 @@
+#pragma once
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Directivas OpenMP: MONTECARLO_OMP(parallel for schedule(dynamic)) equivale a
+// la directiva omp con el mismo texto. Compiladas sin -fopenmp no dejan nada,
+// así que el ejecutable secuencial no provoca -Wunknown-pragmas.
+#ifdef _OPENMP
+#define MONTECARLO_TEXTO(...) #__VA_ARGS__
+#define MONTECARLO_OMP(...) _Pragma(MONTECARLO_TEXTO(omp __VA_ARGS__))
+#else
+#define MONTECARLO_OMP(...)
+#endif
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <chrono>
+
+#include "instrumentacion.hpp"
+#include "lotes.hpp"
+#include "motores.hpp"
+#include "muestras.hpp"
+#include "nucleo.hpp"
+#include "openmp.hpp"
+#include "parametros.hpp"
+#include "philox.hpp"
+#include "qmc.hpp"
+#include "topologia.hpp"
+
+namespace montecarlo {
+
+// Reloj de pared en segundos
+inline double tiempo() {
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Integra las muestras de índice global [muestras.inicio, muestras.fin) con
+// todos los hilos disponibles. Los bloques de TAMANO_BLOQUE muestras se
+// reparten dinámicamente; cada muestra sale de un flujo indexado (Philox por
+// defecto o FlujoMotor sobre un motor secuencial), y los
+// parciales se combinan de forma compensada, primero dentro de cada socket y
+// después entre sockets, así que el resultado es el mismo con cualquier número
+// de hilos (o de procesos, si los rangos están alineados con repartir_bloques).
+template <class Flujo = FlujoPhilox, class F>
+Momentos integrar(const F& func, const Dominio& dominio, Rango muestras, unsigned long long seed) {
+    Momentos total;
+    const long long primero = muestras.inicio / TAMANO_BLOQUE;
+    const long long ultimo = (muestras.fin + TAMANO_BLOQUE - 1) / TAMANO_BLOQUE;
+    ReduccionPorSocket<Momentos> reduccion(hilos_disponibles());
+
+    despachar_muestreo<F>(dominio.dimensiones, [&](auto D) {
+        constexpr int DIM = decltype(D)::value;
+
+        // Apertura del scope paralelo
+        MONTECARLO_OMP(parallel)
+        {
+            // Con --pin, el hilo se fija antes de crear su estado: el flujo (16
+            // bytes con Philox) y los buffers del lote se tocan por primera vez
+            // desde su CPU y quedan en su nodo NUMA
+            fijar_hilo();
+            Flujo flujo(seed, dominio.dimensiones);
+            EspacioLote espacio(dominio.dimensiones);
+            Momentos local;
+
+            MONTECARLO_OMP(for schedule(dynamic) nowait)
+            for (long long b = primero; b < ultimo; b++) {
+                long long inicio = b * TAMANO_BLOQUE;
+                long long fin = inicio + TAMANO_BLOQUE;
+                if (inicio < muestras.inicio) inicio = muestras.inicio;
+                if (fin > muestras.fin) fin = muestras.fin;
+
+                TramoInstrumentado tramo(Fase::BLOQUE, fin - inicio);
+                flujo.saltar_a_muestra(inicio);
+
+                // Con --store, los lotes del bloque se copian a un búfer del escritor
+                BloqueMuestras* captura = escritor_muestras ? escritor_muestras->tomar(inicio, fin - inicio) : nullptr;
+                if (captura) {
+                    espacio.captura = captura->datos.data();
+                    espacio.filas_captura = std::size_t(fin - inicio);
+                }
+                local += muestrear<DIM>(func, dominio, flujo, fin - inicio, espacio);
+                if (captura) {
+                    espacio.captura = nullptr;
+                    escritor_muestras->entregar(captura);
+                }
+            }
+
+            // Con --profile, la espera en la barrera mide el desbalance entre hilos
+            if (instrumentacion_activa) {
+                TramoInstrumentado espera(Fase::ESPERA);
+                MONTECARLO_OMP(barrier)
+            }
+
+            // Reducción de los parciales: dentro de cada socket y después entre sockets
+            TramoInstrumentado tramo(Fase::REDUCCION);
+            reduccion.reducir(local, total);
+        }
+        return 0;
+    });
+
+    return total;
+}
+
+// Llama a funcion(Tipo<Flujo>{}) con el flujo de la estrategia de muestreo y
+// el motor elegidos en la línea de comando
+template <class Funcion>
+decltype(auto) despachar_flujo(const Parametros& p, Funcion&& funcion) {
+    switch (p.muestreo) {
+        case Muestreo::SOBOL: return funcion(Tipo<FlujoSobol>{});
+        case Muestreo::HALTON: return funcion(Tipo<FlujoHalton>{});
+        default: return despachar_motor(p.motor, funcion);
+    }
+}
+
+// Igual que la anterior, con la estrategia de muestreo, el motor y la semilla
+// elegidos en la línea de comando. Devuelve los momentos de cada réplica; la
+// réplica 0 usa la semilla tal cual y las demás semillas derivadas de ella.
+template <class F>
+Replicas integrar(const F& func, const Dominio& dominio, Rango muestras, const Parametros& p) {
+    Replicas replicas;
+    for (int r = 0; r < p.replicas; r++) {
+        replicas.push_back(despachar_flujo(p, [&](auto tipo) {
+            using Flujo = typename decltype(tipo)::type;
+            return integrar<Flujo>(func, dominio, muestras, derivar_semilla(p.seed, r));
+        }));
+    }
+    return replicas;
+}
+
+} // namespace montecarlo
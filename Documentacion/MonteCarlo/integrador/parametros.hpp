@@ -0,0 +1,394 @@
+#pragma once
+
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "motores.hpp"
+#include "nucleo.hpp"
+#include "qmc.hpp"
+#include "topologia.hpp"
+
+namespace montecarlo {
+
+// Estrategia de muestreo del hipercubo
+enum class Muestreo { PSEUDOALEATORIO, SOBOL, HALTON };
+
+// Método de integración: muestreo (Monte Carlo y sus variantes) o cubatura
+// adaptativa determinista (cubatura.hpp)
+enum class Metodo { MONTECARLO, CUBATURA };
+
+// Con --method auto (por defecto) se usa la cubatura hasta esta dimensión, si
+// el integrando es suave y ninguna opción pide muestrear; con --method
+// cubature, hasta la máxima. La regla de Genz-Malik usa 2^d + 2d^2 + 2d + 1
+// evaluaciones por región.
+constexpr int DIMENSION_AUTOMATICA_CUBATURA = 6;
+constexpr int DIMENSION_MAXIMA_CUBATURA = 12;
+
+// Evaluaciones de una región: Gauss-Kronrod 7-15 con d = 1, Genz-Malik si no
+inline long long evaluaciones_region(int dimensiones) {
+    if (dimensiones == 1) return 15;
+    const long long d = dimensiones;
+    return (1LL << d) + 2 * d * d + 2 * d + 1;
+}
+
+// Parámetros elegidos por el usuario en la línea de comando
+struct Parametros {
+    double lim_inf = 0.0;
+    double lim_sup = 1.0;
+    int dimensiones = 0;
+    long long N = 0;
+
+    // semilla
+    unsigned long long seed = 12345;
+
+    // Generador de números uniformes
+    Motor motor = Motor::PHILOX;
+
+    // Secuencia de puntos y número de réplicas independientes (RQMC)
+    Muestreo muestreo = Muestreo::PSEUDOALEATORIO;
+    int replicas = 1;
+
+    // Iteraciones de VEGAS (0: muestreo uniforme del hipercubo)
+    int iteraciones_vegas = 0;
+
+    // Muestreo estratificado recursivo (MISER)
+    bool miser = false;
+
+    // Cada réplica usa N / replicas puntos
+    long long puntos_por_replica() const { return N / replicas; }
+
+    // Cada iteración de VEGAS usa N / iteraciones puntos
+    long long puntos_por_iteracion() const { return N / iteraciones_vegas; }
+
+    // Precisión objetivo: se muestrea hasta que el error estimado baja de
+    // max(objetivo_abs, objetivo_rel * |I|), hasta N puntos o tiempo_maximo segundos
+    double objetivo_abs = 0.0;
+    double objetivo_rel = 0.0;
+    double tiempo_maximo = 0.0;
+
+    // Reparto de muestras entre procesos MPI: estático (por defecto) o dinámico
+    bool reparto_dinamico = false;
+
+    // Puntos de control: archivo (vacío: desactivados), segundos entre escrituras
+    // y si se continúa desde el archivo existente
+    std::string punto_control;
+    double intervalo_punto_control = 60.0;
+    bool reanudar = false;
+
+    // Integrando escrito como expresión o cargado de una biblioteca compartida
+    // (ambos vacíos: la gaussiana). Con varias --expr se integran todas sobre
+    // los mismos puntos (integrando vectorial).
+    std::vector<std::string> expresiones;
+    std::string plugin;
+
+    // Reducción de varianza: pares antitéticos x, lim_inf + lim_sup - x, o una
+    // variable de control h (expresión barata) con integral exacta conocida
+    bool antitetico = false;
+    std::string variable_control;
+    double integral_control = 0.0;
+
+    // Precisión mixta: puntos y evaluación en float, sumas en double
+    bool precision_mixta = false;
+
+    // Instrumentación: archivo de la traza de Chrome (vacío: desactivada)
+    std::string perfil;
+
+    // Caché persistente de resultados: directorio (vacío: desactivada)
+    std::string cache;
+
+    // Almacén de muestras: archivo con los puntos y valores de f (vacío: no se guardan)
+    std::string almacen;
+
+    // Templado paralelo: temperaturas de la escalera (0: desactivado) y
+    // escaleras de cadenas (se redondea a grupos completos)
+    int temperaturas = 0;
+    int cadenas = 64;
+
+    // Ubicación de los hilos de OpenMP en los sockets y nodos NUMA (--pin)
+    Afinidad afinidad = Afinidad::NINGUNA;
+
+    // Método que se usa y si lo eligió --method auto
+    Metodo metodo = Metodo::MONTECARLO;
+    bool metodo_automatico = false;
+
+    bool cubatura() const { return metodo == Metodo::CUBATURA; }
+
+    bool templado() const { return temperaturas > 0; }
+
+    bool vectorial() const { return expresiones.size() > 1; }
+
+    bool reduccion_varianza() const { return antitetico || !variable_control.empty(); }
+
+    // Muestras del flujo: con variables antitéticas cada una es un par de
+    // evaluaciones, así que --n sigue contando evaluaciones de f
+    long long muestras_reduccion() const { return antitetico ? N / 2 : N; }
+
+    bool modo_objetivo() const { return objetivo_abs > 0.0 || objetivo_rel > 0.0 || tiempo_maximo > 0.0; }
+};
+
+// Mensaje de uso común a todos los ejecutables
+inline void uso(const char* programa) {
+    std::cerr << "Usage: " << programa << " --li [límite inferior] --ls [límite superior] --d [número de dimensiones] --n [cantidad de puntos] [--seed semilla] [--motor philox|xoshiro|pcg64|splitmix|mt] [--sampler mc|sobol|halton|rqmc] [--replicas R] [--vegas iteraciones] [--miser] [--target-abs error] [--target-rel error] [--max-time segundos] [--schedule static|dynamic] [--checkpoint archivo] [--checkpoint-interval segundos] [--resume] [--profile traza.json] [--expr \"exp(-sum(x_i^2))\"] [--plugin libf.so] [--precision double|mixed] [--pin close|spread|none] [--cache directorio] [--store muestras.mcs] [--tempering T] [--chains C] [--method auto|mc|cubature] [--antithetic] [--control-variate \"1 - sum(x_i^2)\" --control-integral valor]" << std::endl;
+    exit(1);
+}
+
+// Cantidad de puntos de 64 bits; también acepta notación científica (1e11),
+// exacta para cualquier entero de hasta 2^53
+inline long long leer_cantidad(const char* texto) {
+    char* fin;
+    long long n = strtoll(texto, &fin, 10);
+    if (*fin != '\0') n = std::llround(strtod(texto, nullptr));
+    return n;
+}
+
+// ¿Alguna opción pide muestrear? La cubatura solo combina con --target-abs,
+// --target-rel, --max-time, --pin y --profile; --seed y --motor no la afectan.
+inline bool pide_muestreo(const Parametros& p) {
+    return p.replicas > 1 || p.muestreo != Muestreo::PSEUDOALEATORIO || p.iteraciones_vegas > 0 || p.miser ||
+           p.reparto_dinamico || !p.punto_control.empty() || p.vectorial() || p.reduccion_varianza() ||
+           p.precision_mixta || !p.cache.empty() || !p.almacen.empty() || p.templado();
+}
+
+// ¿Se sabe que el integrando es suave? La gaussiana sí, una expresión si no
+// usa abs, min ni max (sus quiebres no los ve la regla de cubatura y el error
+// estimado queda muy por debajo del real) y un plugin no se sabe
+inline bool integrando_suave(const Parametros& p) {
+    if (!p.plugin.empty()) return false;
+    for (const std::string& texto : p.expresiones) {
+        for (std::size_t i = 0; i < texto.size();) {
+            if (!std::isalpha((unsigned char)texto[i])) {
+                i++;
+                continue;
+            }
+            std::size_t fin = i;
+            while (fin < texto.size() && (std::isalnum((unsigned char)texto[fin]) || texto[fin] == '_')) fin++;
+            const std::string nombre = texto.substr(i, fin - i);
+            if (nombre == "abs" || nombre == "min" || nombre == "max") return false;
+            i = fin;
+        }
+    }
+    return true;
+}
+
+// Lectura de los argumentos --li, --ls, --d y --n (en cualquier orden) y opcionales
+inline Parametros leer_parametros(int argc, char* argv[]) {
+    Parametros p;
+    bool hay_li = false, hay_ls = false, hay_d = false, hay_n = false;
+    bool rqmc = false, hay_replicas = false;
+    bool hay_integral_control = false;
+    bool metodo_automatico = true;
+
+    for (int i = 1; i < argc; i++) {
+        std::string opcion = argv[i];
+
+        // Valor asociado a la opción actual
+        auto valor = [&]() -> const char* {
+            if (i + 1 >= argc) uso(argv[0]);
+            return argv[++i];
+        };
+
+        if (opcion == "--li") {
+            p.lim_inf = atof(valor());
+            hay_li = true;
+        } else if (opcion == "--ls") {
+            p.lim_sup = atof(valor());
+            hay_ls = true;
+        } else if (opcion == "--d") {
+            p.dimensiones = atoi(valor());
+            hay_d = true;
+        } else if (opcion == "--n") {
+            p.N = leer_cantidad(valor());
+            hay_n = true;
+        } else if (opcion == "--seed") {
+            p.seed = strtoull(valor(), nullptr, 10);
+        } else if (opcion == "--motor") {
+            if (!leer_motor(valor(), p.motor)) uso(argv[0]);
+        } else if (opcion == "--sampler") {
+            std::string muestreo = valor();
+            if (muestreo == "mc") p.muestreo = Muestreo::PSEUDOALEATORIO;
+            else if (muestreo == "sobol") p.muestreo = Muestreo::SOBOL;
+            else if (muestreo == "halton") p.muestreo = Muestreo::HALTON;
+            else if (muestreo == "rqmc") { p.muestreo = Muestreo::SOBOL; rqmc = true; }
+            else uso(argv[0]);
+        } else if (opcion == "--replicas") {
+            p.replicas = atoi(valor());
+            hay_replicas = true;
+        } else if (opcion == "--vegas") {
+            p.iteraciones_vegas = atoi(valor());
+            if (p.iteraciones_vegas <= 0) uso(argv[0]);
+        } else if (opcion == "--miser") {
+            p.miser = true;
+        } else if (opcion == "--target-abs") {
+            p.objetivo_abs = atof(valor());
+            if (p.objetivo_abs <= 0.0) uso(argv[0]);
+        } else if (opcion == "--target-rel") {
+            p.objetivo_rel = atof(valor());
+            if (p.objetivo_rel <= 0.0) uso(argv[0]);
+        } else if (opcion == "--schedule") {
+            std::string reparto = valor();
+            if (reparto == "static") p.reparto_dinamico = false;
+            else if (reparto == "dynamic") p.reparto_dinamico = true;
+            else uso(argv[0]);
+        } else if (opcion == "--checkpoint") {
+            p.punto_control = valor();
+        } else if (opcion == "--checkpoint-interval") {
+            p.intervalo_punto_control = atof(valor());
+            if (p.intervalo_punto_control <= 0.0) uso(argv[0]);
+        } else if (opcion == "--resume") {
+            p.reanudar = true;
+        } else if (opcion == "--expr") {
+            p.expresiones.push_back(valor());
+        } else if (opcion == "--plugin") {
+            p.plugin = valor();
+        } else if (opcion == "--precision") {
+            std::string precision = valor();
+            if (precision == "double") p.precision_mixta = false;
+            else if (precision == "mixed") p.precision_mixta = true;
+            else uso(argv[0]);
+        } else if (opcion == "--antithetic") {
+            p.antitetico = true;
+        } else if (opcion == "--control-variate") {
+            p.variable_control = valor();
+        } else if (opcion == "--control-integral") {
+            p.integral_control = atof(valor());
+            hay_integral_control = true;
+        } else if (opcion == "--profile") {
+            p.perfil = valor();
+        } else if (opcion == "--cache") {
+            p.cache = valor();
+        } else if (opcion == "--store") {
+            p.almacen = valor();
+        } else if (opcion == "--tempering") {
+            p.temperaturas = atoi(valor());
+            if (p.temperaturas < 2) uso(argv[0]);
+        } else if (opcion == "--chains") {
+            p.cadenas = atoi(valor());
+            if (p.cadenas <= 0) uso(argv[0]);
+        } else if (opcion == "--method") {
+            std::string metodo = valor();
+            metodo_automatico = metodo == "auto";
+            if (metodo == "mc") p.metodo = Metodo::MONTECARLO;
+            else if (metodo == "cubature") p.metodo = Metodo::CUBATURA;
+            else if (!metodo_automatico) uso(argv[0]);
+        } else if (opcion == "--pin") {
+            if (!leer_afinidad(valor(), p.afinidad)) uso(argv[0]);
+        } else if (opcion == "--max-time") {
+            p.tiempo_maximo = atof(valor());
+            if (p.tiempo_maximo <= 0.0) uso(argv[0]);
+        } else {
+            uso(argv[0]);
+        }
+    }
+
+    // RQMC: 16 aleatorizaciones independientes de Sobol salvo que se pida otra cantidad
+    if (rqmc && !hay_replicas) p.replicas = 16;
+
+    if (!(hay_li && hay_ls && hay_d && hay_n) || p.dimensiones <= 0 || p.N <= 0) {
+        uso(argv[0]);
+    }
+    if (p.replicas < 1 || (rqmc && p.replicas < 2) || p.puntos_por_replica() <= 0) {
+        uso(argv[0]);
+    }
+    // VEGAS estima su error entre iteraciones: no se combina con réplicas
+    if (p.iteraciones_vegas > 0 && (p.replicas > 1 || p.puntos_por_iteracion() <= 0)) {
+        uso(argv[0]);
+    }
+    // MISER estima su error por estratos: no se combina con réplicas ni con VEGAS
+    if (p.miser && (p.replicas > 1 || p.iteraciones_vegas > 0)) {
+        uso(argv[0]);
+    }
+    // La precisión objetivo usa el error estadístico del muestreo uniforme; --n es
+    // el máximo de puntos
+    if (p.modo_objetivo() && (p.replicas > 1 || p.iteraciones_vegas > 0 || p.miser ||
+                              p.muestreo != Muestreo::PSEUDOALEATORIO)) {
+        uso(argv[0]);
+    }
+    // Los puntos de control guardan los momentos de la integración directa
+    if (p.reanudar && p.punto_control.empty()) {
+        uso(argv[0]);
+    }
+    if (!p.punto_control.empty() && (p.replicas > 1 || p.iteraciones_vegas > 0 || p.miser || p.modo_objetivo())) {
+        uso(argv[0]);
+    }
+    if (!p.expresiones.empty() && !p.plugin.empty()) {
+        uso(argv[0]);
+    }
+    // Los integrandos vectoriales usan la integración directa, con una sola réplica
+    if (p.vectorial() && (p.replicas > 1 || p.iteraciones_vegas > 0 || p.miser || p.modo_objetivo() ||
+                          !p.punto_control.empty())) {
+        uso(argv[0]);
+    }
+    // Las variables antitéticas y de control se estiman con los co-momentos de
+    // la integración directa; la variable de control necesita su integral exacta
+    if (p.reduccion_varianza() && (p.replicas > 1 || p.iteraciones_vegas > 0 || p.miser || p.modo_objetivo() ||
+                                   !p.punto_control.empty() || p.vectorial() || p.muestras_reduccion() <= 0)) {
+        uso(argv[0]);
+    }
+    // La caché guarda los momentos de la integración directa, por réplica
+    if (!p.cache.empty() && (p.iteraciones_vegas > 0 || p.miser || p.modo_objetivo() || !p.punto_control.empty() ||
+                             p.vectorial() || p.reduccion_varianza() || p.reparto_dinamico)) {
+        uso(argv[0]);
+    }
+    // El almacén guarda los puntos uniformes de la integración directa, de una réplica
+    if (!p.almacen.empty() && (p.replicas > 1 || p.iteraciones_vegas > 0 || p.miser || p.modo_objetivo() ||
+                               !p.punto_control.empty() || p.vectorial() || p.reduccion_varianza() ||
+                               !p.cache.empty())) {
+        uso(argv[0]);
+    }
+    // El templado paralelo estima con sus propias cadenas de Markov: solo
+    // admite el motor pseudoaleatorio, en double
+    if (p.templado() && (p.replicas > 1 || p.iteraciones_vegas > 0 || p.miser || p.modo_objetivo() ||
+                         !p.punto_control.empty() || p.vectorial() || p.reduccion_varianza() || !p.cache.empty() ||
+                         !p.almacen.empty() || p.precision_mixta || p.reparto_dinamico ||
+                         p.muestreo != Muestreo::PSEUDOALEATORIO)) {
+        uso(argv[0]);
+    }
+    // Los plugins evalúan en double (plugin_abi.h) y los integrandos vectoriales
+    // se evalúan como un solo programa double
+    if (p.precision_mixta && (!p.plugin.empty() || p.vectorial())) {
+        uso(argv[0]);
+    }
+    if (p.antitetico && !p.variable_control.empty()) {
+        uso(argv[0]);
+    }
+    if (p.variable_control.empty() == hay_integral_control) {
+        uso(argv[0]);
+    }
+    if (p.dimensiones > DIMENSION_MAXIMA) {
+        std::cerr << "--d admite hasta " << DIMENSION_MAXIMA << " dimensiones" << std::endl;
+        exit(1);
+    }
+    if (p.muestreo != Muestreo::PSEUDOALEATORIO && p.dimensiones > DIMENSION_MAXIMA_QMC) {
+        std::cerr << "Las secuencias de baja discrepancia admiten hasta " << DIMENSION_MAXIMA_QMC << " dimensiones" << std::endl;
+        exit(1);
+    }
+    // La cubatura adaptativa en dimensión baja con un integrando suave, salvo
+    // que se pida muestrear
+    if (metodo_automatico) {
+        p.metodo_automatico = true;
+        const bool cubatura = p.dimensiones <= DIMENSION_AUTOMATICA_CUBATURA &&
+                              p.N >= evaluaciones_region(p.dimensiones) && integrando_suave(p) && !pide_muestreo(p);
+        p.metodo = cubatura ? Metodo::CUBATURA : Metodo::MONTECARLO;
+    }
+    if (p.cubatura() && pide_muestreo(p)) {
+        uso(argv[0]);
+    }
+    if (p.cubatura() && p.dimensiones > DIMENSION_MAXIMA_CUBATURA) {
+        std::cerr << "La cubatura adaptativa admite hasta " << DIMENSION_MAXIMA_CUBATURA << " dimensiones" << std::endl;
+        exit(1);
+    }
+
+    // La topología se lee aquí, desde el hilo principal y antes de fijar
+    // ningún hilo, con la máscara de CPUs que le dio el sistema (o mpirun)
+    afinidad_hilos = p.afinidad;
+    if (p.afinidad != Afinidad::NINGUNA) topologia();
+
+    return p;
+}
+
+} // namespace montecarlo
@@ -0,0 +1,424 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "simd.hpp"
+
+namespace montecarlo {
+
+// Conversión de 64 bits aleatorios a un double uniforme en [0, 1) con 53 bits de mantisa
+// (la conversión desde entero con signo es una sola instrucción, la de sin signo no)
+inline double a_unidad(std::uint64_t bits) {
+    return double(std::int64_t(bits >> 11)) * 0x1.0p-53;
+}
+
+// Conversión de 32 bits aleatorios a un float uniforme: los 23 bits altos eligen
+// una de 2^23 celdas de [0, 1) y el valor es su centro, (2k + 1) * 2^-24, exacto
+// en float. La media es exactamente 1/2 y nunca sale 0 ni 1.
+inline float a_unidad_float(std::uint32_t bits) {
+    return float(std::int32_t((bits >> 8) | 1u)) * 0x1.0p-24f;
+}
+
+// Generador basado en contador Philox4x32-10 (Salmon et al., SC'11).
+// Cada bloque de salida depende solo de (contador, clave): no hay estado
+// secuencial y cualquier posición de la secuencia se calcula en O(1).
+namespace philox {
+
+constexpr std::uint32_t M0 = 0xD2511F53u;
+constexpr std::uint32_t M1 = 0xCD9E8D57u;
+constexpr std::uint32_t W0 = 0x9E3779B9u;
+constexpr std::uint32_t W1 = 0xBB67AE85u;
+constexpr int RONDAS = 10;
+
+// Bloque escalar: las 10 rondas sobre (x0, x1, x2, x3) con clave (k0, k1)
+inline void bloque(std::uint32_t& x0, std::uint32_t& x1, std::uint32_t& x2, std::uint32_t& x3,
+                   std::uint32_t k0, std::uint32_t k1) {
+    for (int ronda = 0; ronda < RONDAS; ronda++) {
+        std::uint64_t p0 = std::uint64_t(M0) * x0;
+        std::uint64_t p1 = std::uint64_t(M1) * x2;
+        std::uint32_t y0 = std::uint32_t(p1 >> 32) ^ x1 ^ k0;
+        std::uint32_t y2 = std::uint32_t(p0 >> 32) ^ x3 ^ k1;
+        x1 = std::uint32_t(p1);
+        x3 = std::uint32_t(p0);
+        x0 = y0;
+        x2 = y2;
+        k0 += W0;
+        k1 += W1;
+    }
+}
+
+// Escribe los 2 uniformes de cada bloque con contador c, c+1, ..., c+pares-1
+inline void llenar_pares_escalar(double* destino, std::uint64_t c, std::size_t pares,
+                                 std::uint32_t k0, std::uint32_t k1) {
+    for (std::size_t t = 0; t < pares; t++) {
+        std::uint64_t contador = c + t;
+        std::uint32_t x0 = std::uint32_t(contador), x1 = std::uint32_t(contador >> 32), x2 = 0, x3 = 0;
+        bloque(x0, x1, x2, x3, k0, k1);
+        destino[2 * t] = a_unidad(x0 | std::uint64_t(x1) << 32);
+        destino[2 * t + 1] = a_unidad(x2 | std::uint64_t(x3) << 32);
+    }
+}
+
+// Escribe los 4 uniformes float de cada bloque con contador c, ..., c+cuartetos-1
+inline void llenar_cuartetos_escalar(float* destino, std::uint64_t c, std::size_t cuartetos,
+                                     std::uint32_t k0, std::uint32_t k1) {
+    for (std::size_t t = 0; t < cuartetos; t++) {
+        std::uint64_t contador = c + t;
+        std::uint32_t x0 = std::uint32_t(contador), x1 = std::uint32_t(contador >> 32), x2 = 0, x3 = 0;
+        bloque(x0, x1, x2, x3, k0, k1);
+        destino[4 * t] = a_unidad_float(x0);
+        destino[4 * t + 1] = a_unidad_float(x1);
+        destino[4 * t + 2] = a_unidad_float(x2);
+        destino[4 * t + 3] = a_unidad_float(x3);
+    }
+}
+
+#ifdef MONTECARLO_X86
+
+constexpr int VECTORES = 4;
+
+// Versiones vectoriales: cada carril de 64 bits lleva una palabra de 32 bits
+// de un contador distinto y mul_epu32 da el producto 32x32 -> 64 completo.
+// La conversión a double es exacta y bit a bit igual a a_unidad:
+// u = alto * 2^-32 + (bajo >> 11) * 2^-53, con cada parte < 2^32 convertida
+// mediante el truco del exponente 2^52.
+
+__attribute__((target("avx2,fma")))
+inline __m256d a_unidad_avx2(__m256i bajo, __m256i alto) {
+    const __m256i magia = _mm256_set1_epi64x(0x4330000000000000LL);
+    const __m256d dos52 = _mm256_set1_pd(0x1.0p52);
+    __m256d a = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(alto, magia)), dos52);
+    __m256d b = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bajo, 11), magia)), dos52);
+    return _mm256_fmadd_pd(a, _mm256_set1_pd(0x1.0p-32), _mm256_mul_pd(b, _mm256_set1_pd(0x1.0p-53)));
+}
+
+__attribute__((target("avx2,fma")))
+inline void llenar_pares_avx2(double* destino, std::uint64_t c, std::size_t pares,
+                              std::uint32_t k0, std::uint32_t k1) {
+    const __m256i mascara = _mm256_set1_epi64x(0xFFFFFFFFLL);
+    const __m256i m0 = _mm256_set1_epi64x(M0), m1 = _mm256_set1_epi64x(M1);
+    __m256i contador = _mm256_add_epi64(_mm256_set1_epi64x(std::int64_t(c)), _mm256_set_epi64x(3, 2, 1, 0));
+
+    std::size_t t = 0;
+    // VECTORES cadenas independientes por iteración para ocultar la latencia de mul_epu32
+    for (; t + VECTORES * 4 <= pares; t += VECTORES * 4) {
+        __m256i x0[VECTORES], x1[VECTORES], x2[VECTORES], x3[VECTORES];
+        for (int v = 0; v < VECTORES; v++) {
+            __m256i cv = _mm256_add_epi64(contador, _mm256_set1_epi64x(4 * v));
+            x0[v] = _mm256_and_si256(cv, mascara);
+            x1[v] = _mm256_srli_epi64(cv, 32);
+            x2[v] = _mm256_setzero_si256();
+            x3[v] = _mm256_setzero_si256();
+        }
+        std::uint32_t c0 = k0, c1 = k1;
+        for (int ronda = 0; ronda < RONDAS; ronda++) {
+            for (int v = 0; v < VECTORES; v++) {
+                __m256i p0 = _mm256_mul_epu32(x0[v], m0);
+                __m256i p1 = _mm256_mul_epu32(x2[v], m1);
+                __m256i y0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p1, 32), x1[v]), _mm256_set1_epi64x(c0));
+                __m256i y2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p0, 32), x3[v]), _mm256_set1_epi64x(c1));
+                x1[v] = _mm256_and_si256(p1, mascara);
+                x3[v] = _mm256_and_si256(p0, mascara);
+                x0[v] = y0;
+                x2[v] = y2;
+            }
+            c0 += W0;
+            c1 += W1;
+        }
+        for (int v = 0; v < VECTORES; v++) {
+            __m256d a = a_unidad_avx2(x0[v], x1[v]);  // primer uniforme de cada bloque
+            __m256d b = a_unidad_avx2(x2[v], x3[v]);  // segundo uniforme de cada bloque
+            __m256d lo = _mm256_unpacklo_pd(a, b), hi = _mm256_unpackhi_pd(a, b);
+            _mm256_storeu_pd(destino + 2 * (t + 4 * v), _mm256_permute2f128_pd(lo, hi, 0x20));
+            _mm256_storeu_pd(destino + 2 * (t + 4 * v) + 4, _mm256_permute2f128_pd(lo, hi, 0x31));
+        }
+        contador = _mm256_add_epi64(contador, _mm256_set1_epi64x(VECTORES * 4));
+    }
+    llenar_pares_escalar(destino + 2 * t, c + t, pares - t, k0, k1);
+}
+
+// Palabras de 32 bits (en carriles de 64) a float con a_unidad_float
+__attribute__((target("avx2,fma")))
+inline __m128 a_unidad_float_avx2(__m256i x) {
+    __m256i juntas = _mm256_permutevar8x32_epi32(x, _mm256_set_epi32(7, 5, 3, 1, 6, 4, 2, 0));
+    __m128i k = _mm_or_si128(_mm_srli_epi32(_mm256_castsi256_si128(juntas), 8), _mm_set1_epi32(1));
+    return _mm_mul_ps(_mm_cvtepi32_ps(k), _mm_set1_ps(0x1.0p-24f));
+}
+
+// Mismas rondas que llenar_pares_avx2; las 4 palabras de cada bloque van a float
+__attribute__((target("avx2,fma")))
+inline void llenar_cuartetos_avx2(float* destino, std::uint64_t c, std::size_t cuartetos,
+                                  std::uint32_t k0, std::uint32_t k1) {
+    const __m256i mascara = _mm256_set1_epi64x(0xFFFFFFFFLL);
+    const __m256i m0 = _mm256_set1_epi64x(M0), m1 = _mm256_set1_epi64x(M1);
+    __m256i contador = _mm256_add_epi64(_mm256_set1_epi64x(std::int64_t(c)), _mm256_set_epi64x(3, 2, 1, 0));
+
+    std::size_t t = 0;
+    for (; t + VECTORES * 4 <= cuartetos; t += VECTORES * 4) {
+        __m256i x0[VECTORES], x1[VECTORES], x2[VECTORES], x3[VECTORES];
+        for (int v = 0; v < VECTORES; v++) {
+            __m256i cv = _mm256_add_epi64(contador, _mm256_set1_epi64x(4 * v));
+            x0[v] = _mm256_and_si256(cv, mascara);
+            x1[v] = _mm256_srli_epi64(cv, 32);
+            x2[v] = _mm256_setzero_si256();
+            x3[v] = _mm256_setzero_si256();
+        }
+        std::uint32_t c0 = k0, c1 = k1;
+        for (int ronda = 0; ronda < RONDAS; ronda++) {
+            for (int v = 0; v < VECTORES; v++) {
+                __m256i p0 = _mm256_mul_epu32(x0[v], m0);
+                __m256i p1 = _mm256_mul_epu32(x2[v], m1);
+                __m256i y0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p1, 32), x1[v]), _mm256_set1_epi64x(c0));
+                __m256i y2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p0, 32), x3[v]), _mm256_set1_epi64x(c1));
+                x1[v] = _mm256_and_si256(p1, mascara);
+                x3[v] = _mm256_and_si256(p0, mascara);
+                x0[v] = y0;
+                x2[v] = y2;
+            }
+            c0 += W0;
+            c1 += W1;
+        }
+        for (int v = 0; v < VECTORES; v++) {
+            // Fila w: palabra w de los 4 bloques; al trasponer queda cada bloque seguido
+            __m128 f0 = a_unidad_float_avx2(x0[v]), f1 = a_unidad_float_avx2(x1[v]);
+            __m128 f2 = a_unidad_float_avx2(x2[v]), f3 = a_unidad_float_avx2(x3[v]);
+            _MM_TRANSPOSE4_PS(f0, f1, f2, f3);
+            float* salida = destino + 4 * (t + 4 * v);
+            _mm_storeu_ps(salida, f0);
+            _mm_storeu_ps(salida + 4, f1);
+            _mm_storeu_ps(salida + 8, f2);
+            _mm_storeu_ps(salida + 12, f3);
+        }
+        contador = _mm256_add_epi64(contador, _mm256_set1_epi64x(VECTORES * 4));
+    }
+    llenar_cuartetos_escalar(destino + 4 * t, c + t, cuartetos - t, k0, k1);
+}
+
+// Falsos avisos de GCC 12 en los intrínsecos AVX-512 (ver simd.hpp)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f")))
+inline __m512d a_unidad_avx512(__m512i bajo, __m512i alto) {
+    const __m512i magia = _mm512_set1_epi64(0x4330000000000000LL);
+    const __m512d dos52 = _mm512_set1_pd(0x1.0p52);
+    __m512d a = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(alto, magia)), dos52);
+    __m512d b = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(_mm512_srli_epi64(bajo, 11), magia)), dos52);
+    return _mm512_fmadd_pd(a, _mm512_set1_pd(0x1.0p-32), _mm512_mul_pd(b, _mm512_set1_pd(0x1.0p-53)));
+}
+
+__attribute__((target("avx512f")))
+inline void llenar_pares_avx512(double* destino, std::uint64_t c, std::size_t pares,
+                                std::uint32_t k0, std::uint32_t k1) {
+    const __m512i mascara = _mm512_set1_epi64(0xFFFFFFFFLL);
+    const __m512i m0 = _mm512_set1_epi64(M0), m1 = _mm512_set1_epi64(M1);
+    const __m512i intercalar_lo = _mm512_set_epi64(11, 3, 10, 2, 9, 1, 8, 0);
+    const __m512i intercalar_hi = _mm512_set_epi64(15, 7, 14, 6, 13, 5, 12, 4);
+    __m512i contador = _mm512_add_epi64(_mm512_set1_epi64(std::int64_t(c)), _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0));
+
+    std::size_t t = 0;
+    // VECTORES cadenas independientes por iteración para ocultar la latencia de mul_epu32
+    for (; t + VECTORES * 8 <= pares; t += VECTORES * 8) {
+        __m512i x0[VECTORES], x1[VECTORES], x2[VECTORES], x3[VECTORES];
+        for (int v = 0; v < VECTORES; v++) {
+            __m512i cv = _mm512_add_epi64(contador, _mm512_set1_epi64(8 * v));
+            x0[v] = _mm512_and_si512(cv, mascara);
+            x1[v] = _mm512_srli_epi64(cv, 32);
+            x2[v] = _mm512_setzero_si512();
+            x3[v] = _mm512_setzero_si512();
+        }
+        std::uint32_t c0 = k0, c1 = k1;
+        for (int ronda = 0; ronda < RONDAS; ronda++) {
+            for (int v = 0; v < VECTORES; v++) {
+                __m512i p0 = _mm512_mul_epu32(x0[v], m0);
+                __m512i p1 = _mm512_mul_epu32(x2[v], m1);
+                __m512i y0 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p1, 32), x1[v]), _mm512_set1_epi64(c0));
+                __m512i y2 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p0, 32), x3[v]), _mm512_set1_epi64(c1));
+                x1[v] = _mm512_and_si512(p1, mascara);
+                x3[v] = _mm512_and_si512(p0, mascara);
+                x0[v] = y0;
+                x2[v] = y2;
+            }
+            c0 += W0;
+            c1 += W1;
+        }
+        for (int v = 0; v < VECTORES; v++) {
+            __m512d a = a_unidad_avx512(x0[v], x1[v]);
+            __m512d b = a_unidad_avx512(x2[v], x3[v]);
+            _mm512_storeu_pd(destino + 2 * (t + 8 * v), _mm512_permutex2var_pd(a, intercalar_lo, b));
+            _mm512_storeu_pd(destino + 2 * (t + 8 * v) + 8, _mm512_permutex2var_pd(a, intercalar_hi, b));
+        }
+        contador = _mm512_add_epi64(contador, _mm512_set1_epi64(VECTORES * 8));
+    }
+    llenar_pares_escalar(destino + 2 * t, c + t, pares - t, k0, k1);
+}
+
+__attribute__((target("avx512f")))
+inline __m256 a_unidad_float_avx512(__m512i x) {
+    __m256i k = _mm256_or_si256(_mm256_srli_epi32(_mm512_cvtepi64_epi32(x), 8), _mm256_set1_epi32(1));
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(k), _mm256_set1_ps(0x1.0p-24f));
+}
+
+__attribute__((target("avx512f")))
+inline void llenar_cuartetos_avx512(float* destino, std::uint64_t c, std::size_t cuartetos,
+                                    std::uint32_t k0, std::uint32_t k1) {
+    const __m512i mascara = _mm512_set1_epi64(0xFFFFFFFFLL);
+    const __m512i m0 = _mm512_set1_epi64(M0), m1 = _mm512_set1_epi64(M1);
+    __m512i contador = _mm512_add_epi64(_mm512_set1_epi64(std::int64_t(c)), _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0));
+
+    std::size_t t = 0;
+    for (; t + VECTORES * 8 <= cuartetos; t += VECTORES * 8) {
+        __m512i x0[VECTORES], x1[VECTORES], x2[VECTORES], x3[VECTORES];
+        for (int v = 0; v < VECTORES; v++) {
+            __m512i cv = _mm512_add_epi64(contador, _mm512_set1_epi64(8 * v));
+            x0[v] = _mm512_and_si512(cv, mascara);
+            x1[v] = _mm512_srli_epi64(cv, 32);
+            x2[v] = _mm512_setzero_si512();
+            x3[v] = _mm512_setzero_si512();
+        }
+        std::uint32_t c0 = k0, c1 = k1;
+        for (int ronda = 0; ronda < RONDAS; ronda++) {
+            for (int v = 0; v < VECTORES; v++) {
+                __m512i p0 = _mm512_mul_epu32(x0[v], m0);
+                __m512i p1 = _mm512_mul_epu32(x2[v], m1);
+                __m512i y0 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p1, 32), x1[v]), _mm512_set1_epi64(c0));
+                __m512i y2 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p0, 32), x3[v]), _mm512_set1_epi64(c1));
+                x1[v] = _mm512_and_si512(p1, mascara);
+                x3[v] = _mm512_and_si512(p0, mascara);
+                x0[v] = y0;
+                x2[v] = y2;
+            }
+            c0 += W0;
+            c1 += W1;
+        }
+        for (int v = 0; v < VECTORES; v++) {
+            // Trasposición 4x4 dentro de cada mitad de 128 bits: bloques 0-3 y 4-7
+            __m256 f0 = a_unidad_float_avx512(x0[v]), f1 = a_unidad_float_avx512(x1[v]);
+            __m256 f2 = a_unidad_float_avx512(x2[v]), f3 = a_unidad_float_avx512(x3[v]);
+            __m256d a = _mm256_castps_pd(_mm256_unpacklo_ps(f0, f1)), b = _mm256_castps_pd(_mm256_unpackhi_ps(f0, f1));
+            __m256d e = _mm256_castps_pd(_mm256_unpacklo_ps(f2, f3)), g = _mm256_castps_pd(_mm256_unpackhi_ps(f2, f3));
+            __m256 b0 = _mm256_castpd_ps(_mm256_unpacklo_pd(a, e));  // bloques 0 | 4
+            __m256 b1 = _mm256_castpd_ps(_mm256_unpackhi_pd(a, e));  // bloques 1 | 5
+            __m256 b2 = _mm256_castpd_ps(_mm256_unpacklo_pd(b, g));  // bloques 2 | 6
+            __m256 b3 = _mm256_castpd_ps(_mm256_unpackhi_pd(b, g));  // bloques 3 | 7
+            float* salida = destino + 4 * (t + 8 * v);
+            _mm256_storeu_ps(salida, _mm256_permute2f128_ps(b0, b1, 0x20));
+            _mm256_storeu_ps(salida + 8, _mm256_permute2f128_ps(b2, b3, 0x20));
+            _mm256_storeu_ps(salida + 16, _mm256_permute2f128_ps(b0, b1, 0x31));
+            _mm256_storeu_ps(salida + 24, _mm256_permute2f128_ps(b2, b3, 0x31));
+        }
+        contador = _mm512_add_epi64(contador, _mm512_set1_epi64(VECTORES * 8));
+    }
+    llenar_cuartetos_escalar(destino + 4 * t, c + t, cuartetos - t, k0, k1);
+}
+
+#pragma GCC diagnostic pop
+
+#endif // MONTECARLO_X86
+
+inline void llenar_cuartetos(float* destino, std::uint64_t c, std::size_t cuartetos,
+                             std::uint32_t k0, std::uint32_t k1) {
+#ifdef MONTECARLO_X86
+    switch (simd::nivel()) {
+        case simd::Nivel::AVX512: return llenar_cuartetos_avx512(destino, c, cuartetos, k0, k1);
+        case simd::Nivel::AVX2: return llenar_cuartetos_avx2(destino, c, cuartetos, k0, k1);
+        default: break;
+    }
+#endif
+    llenar_cuartetos_escalar(destino, c, cuartetos, k0, k1);
+}
+
+inline void llenar_pares(double* destino, std::uint64_t c, std::size_t pares,
+                         std::uint32_t k0, std::uint32_t k1) {
+#ifdef MONTECARLO_X86
+    switch (simd::nivel()) {
+        case simd::Nivel::AVX512: return llenar_pares_avx512(destino, c, pares, k0, k1);
+        case simd::Nivel::AVX2: return llenar_pares_avx2(destino, c, pares, k0, k1);
+        default: break;
+    }
+#endif
+    llenar_pares_escalar(destino, c, pares, k0, k1);
+}
+
+} // namespace philox
+
+// Flujo de uniformes indexado: el sorteo j usa la mitad j % 2 del bloque Philox
+// con contador j / 2. La coordenada k de la muestra i es el sorteo i*d + k, de
+// modo que cada muestra es la misma sin importar qué hilo o proceso la genere.
+class FlujoPhilox {
+public:
+    FlujoPhilox(std::uint64_t seed, int dimensiones)
+        : k0(std::uint32_t(seed)), k1(std::uint32_t(seed >> 32)), d(std::uint64_t(dimensiones)) {}
+
+    // Salto en O(1) a la primera coordenada de la muestra i
+    void saltar_a_muestra(std::uint64_t i) { posicionar(i * d); }
+
+    // Salto en O(1) al sorteo j
+    void posicionar(std::uint64_t j) {
+        sorteo = j;
+        valido = false;
+    }
+
+    double operator()() {
+        if (!valido || (sorteo & 1) == 0) {
+            generar(sorteo >> 1, par);
+            valido = true;
+        }
+        return par[sorteo++ & 1];
+    }
+
+    // Llena n uniformes consecutivos, calculando varios bloques a la vez
+    void llenar(double* destino, std::size_t n) {
+        std::size_t hechos = 0;
+        if (n > 0 && (sorteo & 1)) destino[hechos++] = (*this)();
+
+        std::size_t pares = (n - hechos) / 2;
+        philox::llenar_pares(destino + hechos, sorteo >> 1, pares, k0, k1);
+        hechos += 2 * pares;
+        sorteo += 2 * pares;
+
+        valido = false;
+        while (hechos < n) destino[hechos++] = (*this)();
+    }
+
+    // Flujo float de la precisión mixta: el sorteo j es la palabra j % 4 del
+    // bloque con contador j / 4 (un bloque da 4 floats y solo 2 doubles). Las
+    // posiciones cuentan sorteos float; un flujo se usa en una sola precisión.
+    void llenar(float* destino, std::size_t n) {
+        std::size_t hechos = 0;
+        while (hechos < n && (sorteo & 3)) destino[hechos++] = sorteo_float(sorteo++);
+
+        std::size_t cuartetos = (n - hechos) / 4;
+        philox::llenar_cuartetos(destino + hechos, sorteo >> 2, cuartetos, k0, k1);
+        hechos += 4 * cuartetos;
+        sorteo += 4 * cuartetos;
+
+        while (hechos < n) destino[hechos++] = sorteo_float(sorteo++);
+        valido = false;
+    }
+
+private:
+    float sorteo_float(std::uint64_t j) const {
+        std::uint64_t c = j >> 2;
+        std::uint32_t x[4] = {std::uint32_t(c), std::uint32_t(c >> 32), 0, 0};
+        philox::bloque(x[0], x[1], x[2], x[3], k0, k1);
+        return a_unidad_float(x[j & 3]);
+    }
+
+    void generar(std::uint64_t c, double (&salida)[2]) const {
+        std::uint32_t x0 = std::uint32_t(c), x1 = std::uint32_t(c >> 32), x2 = 0, x3 = 0;
+        philox::bloque(x0, x1, x2, x3, k0, k1);
+        salida[0] = a_unidad(x0 | std::uint64_t(x1) << 32);
+        salida[1] = a_unidad(x2 | std::uint64_t(x3) << 32);
+    }
+
+    std::uint32_t k0, k1;
+    std::uint64_t d;
+    std::uint64_t sorteo = 0;
+    bool valido = false;
+    double par[2] = {0.0, 0.0};
+};
+
+} // namespace montecarlo
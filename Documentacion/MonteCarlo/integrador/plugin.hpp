@@ -0,0 +1,188 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include "expresion.hpp"
+#include "integrando.hpp"
+#include "lotes.hpp"
+#include "parametros.hpp"
+#include "plugin_abi.h"
+
+namespace montecarlo {
+
+// Biblioteca abierta con dlopen y sus símbolos (plugin_abi.h). Al destruirse
+// libera los estados por hilo, llama a teardown y la cierra.
+struct BibliotecaPlugin {
+    void* manejador = nullptr;
+    montecarlo_eval_batch_t eval_batch = nullptr;
+    montecarlo_teardown_t teardown = nullptr;
+    montecarlo_thread_init_t thread_init = nullptr;
+    montecarlo_thread_teardown_t thread_teardown = nullptr;
+    montecarlo_eval_batch_state_t eval_batch_state = nullptr;
+    bool iniciada = false;
+
+    // Distingue esta carga de otras en la caché por hilo del estado
+    unsigned long long generacion = 0;
+
+    // Estados creados por thread_init, para liberarlos al cerrar
+    std::mutex cerrojo;
+    std::vector<void*> estados;
+
+    BibliotecaPlugin() = default;
+    BibliotecaPlugin(const BibliotecaPlugin&) = delete;
+    BibliotecaPlugin& operator=(const BibliotecaPlugin&) = delete;
+
+    ~BibliotecaPlugin() {
+        if (thread_teardown) {
+            for (void* estado : estados) thread_teardown(estado);
+        }
+        if (iniciada && teardown) teardown();
+        if (manejador) dlclose(manejador);
+    }
+};
+
+inline std::atomic<unsigned long long> generacion_plugins{0};
+
+// Integrando cargado desde una biblioteca compartida: una llamada indirecta por
+// lote de hasta TAMANO_LOTE muestras. Las copias comparten la biblioteca.
+class Plugin {
+public:
+    void evaluar_lote(const double* soa, std::size_t n, std::size_t d, double* out) const {
+        if (biblioteca->eval_batch_state) biblioteca->eval_batch_state(estado_hilo(), soa, n, d, out);
+        else biblioteca->eval_batch(soa, n, d, out);
+    }
+
+    template <class Punto>
+    double operator()(const Punto& punto) const {
+        thread_local std::vector<double> columna;
+        columna.resize(punto.size());
+        for (std::size_t k = 0; k < punto.size(); k++) columna[k] = punto[k];
+        double valor;
+        evaluar_lote(columna.data(), 1, columna.size(), &valor);
+        return valor;
+    }
+
+    const std::string& ruta() const { return ruta_; }
+
+private:
+    friend bool cargar_plugin(const std::string& ruta, int dimensiones, Plugin& plugin, std::string& error);
+
+    // Estado del hilo actual, creado con thread_init la primera vez
+    void* estado_hilo() const {
+        struct EstadoHilo {
+            unsigned long long generacion = 0;
+            void* estado = nullptr;
+        };
+        thread_local EstadoHilo cache;
+        if (cache.generacion != biblioteca->generacion) {
+            cache.estado = biblioteca->thread_init();
+            cache.generacion = biblioteca->generacion;
+            std::lock_guard<std::mutex> guardia(biblioteca->cerrojo);
+            biblioteca->estados.push_back(cache.estado);
+        }
+        return cache.estado;
+    }
+
+    std::shared_ptr<BibliotecaPlugin> biblioteca;
+    std::string ruta_;
+};
+
+// Abre la biblioteca, comprueba la versión de la ABI y llama a init(d). Una
+// ruta sin '/' se busca primero en el directorio actual y después donde la
+// busca dlopen. Devuelve false con el motivo en error si no se puede usar.
+inline bool cargar_plugin(const std::string& ruta, int dimensiones, Plugin& plugin, std::string& error) {
+    auto biblioteca = std::make_shared<BibliotecaPlugin>();
+
+    std::string abrir = ruta;
+    if (ruta.find('/') == std::string::npos && access(ruta.c_str(), F_OK) == 0) abrir = "./" + ruta;
+    biblioteca->manejador = dlopen(abrir.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!biblioteca->manejador) {
+        error = dlerror();
+        return false;
+    }
+
+    auto simbolo = [&](const char* nombre) { return dlsym(biblioteca->manejador, nombre); };
+    biblioteca->eval_batch = reinterpret_cast<montecarlo_eval_batch_t>(simbolo("eval_batch"));
+    biblioteca->teardown = reinterpret_cast<montecarlo_teardown_t>(simbolo("teardown"));
+    biblioteca->thread_init = reinterpret_cast<montecarlo_thread_init_t>(simbolo("thread_init"));
+    biblioteca->thread_teardown = reinterpret_cast<montecarlo_thread_teardown_t>(simbolo("thread_teardown"));
+    biblioteca->eval_batch_state = reinterpret_cast<montecarlo_eval_batch_state_t>(simbolo("eval_batch_state"));
+    auto version = reinterpret_cast<montecarlo_plugin_abi_version_t>(simbolo("plugin_abi_version"));
+    auto init = reinterpret_cast<montecarlo_init_t>(simbolo("init"));
+
+    if (!biblioteca->eval_batch) {
+        error = ruta + " no exporta eval_batch";
+        return false;
+    }
+    if (version && version() != MONTECARLO_PLUGIN_ABI_VERSION) {
+        error = ruta + " usa la ABI " + std::to_string(version()) + ", se esperaba la " +
+                std::to_string(MONTECARLO_PLUGIN_ABI_VERSION);
+        return false;
+    }
+    const int hooks = (biblioteca->thread_init != nullptr) + (biblioteca->thread_teardown != nullptr) +
+                      (biblioteca->eval_batch_state != nullptr);
+    if (hooks != 0 && hooks != 3) {
+        error = ruta + ": thread_init, thread_teardown y eval_batch_state van juntos";
+        return false;
+    }
+    if (init && init(std::size_t(dimensiones)) != 0) {
+        error = ruta + " rechazó d = " + std::to_string(dimensiones);
+        return false;
+    }
+    biblioteca->iniciada = true;
+    biblioteca->generacion = ++generacion_plugins;
+
+    plugin.biblioteca = std::move(biblioteca);
+    plugin.ruta_ = ruta;
+    return true;
+}
+
+// Los plugins, como las expresiones, usan solo el camino dinámico (D = 0)
+template <>
+struct dimension_dinamica<Plugin> : std::true_type {};
+
+// Llama a funcion(integrando) con el integrando pedido: la gaussiana, la
+// expresión de --expr compilada para p.dimensiones o el plugin de --plugin;
+// con --precision mixed, envuelto en PrecisionMixta
+template <class Funcion>
+decltype(auto) despachar_integrando(const Parametros& p, Funcion&& funcion) {
+    auto llamar = [&](const auto& func) {
+        using F = std::decay_t<decltype(func)>;
+        if constexpr (tiene_evaluar_lote_float<F>::value) {
+            if (p.precision_mixta) return funcion(PrecisionMixta<F>(func));
+        }
+        return funcion(func);
+    };
+
+    std::string error;
+    if (!p.plugin.empty()) {
+        Plugin plugin;
+        if (!cargar_plugin(p.plugin, p.dimensiones, plugin, error)) {
+            std::cerr << "--plugin: " << error << std::endl;
+            exit(1);
+        }
+        return funcion(plugin);
+    }
+    if (!p.expresiones.empty()) {
+        Expresion expresion;
+        if (!compilar_expresion(p.expresiones[0], p.dimensiones, expresion, error)) {
+            std::cerr << "--expr: " << error << std::endl;
+            exit(1);
+        }
+        return llamar(expresion);
+    }
+    return llamar(Gaussiana{});
+}
+
+} // namespace montecarlo
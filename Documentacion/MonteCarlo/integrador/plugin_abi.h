@@ -0,0 +1,51 @@
+#ifndef MONTECARLO_PLUGIN_ABI_H
+#define MONTECARLO_PLUGIN_ABI_H
+
+/*
+ * ABI en C de los integrandos en bibliotecas compartidas (--plugin libf.so).
+ * Se puede incluir desde C o C++; los símbolos se buscan por nombre con dlsym.
+ *
+ * Los puntos llegan en bloques SoA de n <= 256 muestras: la coordenada k del
+ * punto i está en soa[k*n + i]. Una llamada por bloque reparte el costo de la
+ * llamada indirecta entre todas sus muestras.
+ *
+ * Obligatorio:
+ *   void eval_batch(const double* soa, size_t n, size_t d, double* out);
+ *       out[i] = f(punto i). Se llama desde varios hilos a la vez.
+ *
+ * Opcionales:
+ *   int plugin_abi_version(void);
+ *       Debe devolver MONTECARLO_PLUGIN_ABI_VERSION; si falta se asume la 1.
+ *   int init(size_t d);
+ *       Una vez al cargar, antes de evaluar. Distinto de 0 rechaza la dimensión.
+ *   void teardown(void);
+ *       Una vez al terminar, después de todos los thread_teardown.
+ *   void* thread_init(void);
+ *   void thread_teardown(void* estado);
+ *   void eval_batch_state(void* estado, const double* soa, size_t n, size_t d, double* out);
+ *       Estado por hilo: thread_init se llama la primera vez que un hilo evalúa
+ *       y su resultado se pasa a eval_batch_state en ese hilo. thread_teardown
+ *       puede llamarse desde otro hilo. Los tres van juntos.
+ */
+
+#include <stddef.h>
+
+#define MONTECARLO_PLUGIN_ABI_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*montecarlo_eval_batch_t)(const double* soa, size_t n, size_t d, double* out);
+typedef int (*montecarlo_plugin_abi_version_t)(void);
+typedef int (*montecarlo_init_t)(size_t d);
+typedef void (*montecarlo_teardown_t)(void);
+typedef void* (*montecarlo_thread_init_t)(void);
+typedef void (*montecarlo_thread_teardown_t)(void* estado);
+typedef void (*montecarlo_eval_batch_state_t)(void* estado, const double* soa, size_t n, size_t d, double* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONTECARLO_PLUGIN_ABI_H */
@@ -0,0 +1,344 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cache.hpp"
+#include "momentos.hpp"
+#include "nucleo.hpp"
+#include "paralelo.hpp"
+#include "parametros.hpp"
+
+namespace montecarlo {
+
+// Rangos de muestras ya integradas, ordenados, disjuntos y no contiguos
+struct Intervalos {
+    std::vector<Rango> rangos;
+
+    void agregar(Rango r) {
+        if (r.tamano() <= 0) return;
+        auto it = std::lower_bound(rangos.begin(), rangos.end(), r,
+                                   [](const Rango& a, const Rango& b) { return a.inicio < b.inicio; });
+        it = rangos.insert(it, r);
+        // Fusión con el anterior y con los siguientes que se solapen o toquen
+        if (it != rangos.begin() && std::prev(it)->fin >= it->inicio) {
+            std::prev(it)->fin = std::max(std::prev(it)->fin, it->fin);
+            it = std::prev(rangos.erase(it));
+        }
+        while (std::next(it) != rangos.end() && std::next(it)->inicio <= it->fin) {
+            it->fin = std::max(it->fin, std::next(it)->fin);
+            rangos.erase(std::next(it));
+        }
+    }
+
+    void agregar(const Intervalos& otros) {
+        for (const Rango& r : otros.rangos) agregar(r);
+    }
+
+    // Partes de r que todavía no se integraron
+    std::vector<Rango> faltantes(Rango r) const {
+        std::vector<Rango> resultado;
+        long long desde = r.inicio;
+        auto it = std::upper_bound(rangos.begin(), rangos.end(), r.inicio,
+                                   [](long long x, const Rango& a) { return x < a.fin; });
+        for (; it != rangos.end() && it->inicio < r.fin; ++it) {
+            if (it->inicio > desde) resultado.push_back({desde, it->inicio});
+            desde = std::max(desde, it->fin);
+        }
+        if (desde < r.fin) resultado.push_back({desde, r.fin});
+        return resultado;
+    }
+
+    long long total() const {
+        long long n = 0;
+        for (const Rango& r : rangos) n += r.tamano();
+        return n;
+    }
+
+    long long fin() const { return rangos.empty() ? 0 : rangos.back().fin; }
+};
+
+// Contenido de un archivo de punto de control: la identidad de la corrida (para
+// no mezclar muestras de otra semilla, motor, dominio, integrando o precisión),
+// los momentos de las muestras integradas y sus rangos. La posición de cada flujo es el índice de
+// muestra, así que no hace falta guardar el estado interno de ningún generador.
+struct EstadoPuntoControl {
+    unsigned long long seed = 0;
+    int motor = 0;
+    int muestreo = 0;
+    int dimensiones = 0;
+    double lim_inf = 0.0;
+    double lim_sup = 0.0;
+    long long N = 0;
+
+    // identidad_evaluacion, la misma que usa la clave de --cache; vacía en
+    // archivos de versiones que no la guardaban
+    std::string integrando;
+
+    // Procesos de la corrida que escribió el archivo y proceso escritor
+    int procesos = 1;
+    int proceso = 0;
+
+    Momentos momentos;
+    Intervalos hechos;
+};
+
+inline EstadoPuntoControl estado_inicial(const Parametros& p, int procesos, int proceso) {
+    EstadoPuntoControl e;
+    e.seed = p.seed;
+    e.motor = int(p.motor);
+    e.muestreo = int(p.muestreo);
+    e.dimensiones = p.dimensiones;
+    e.lim_inf = p.lim_inf;
+    e.lim_sup = p.lim_sup;
+    e.N = p.N;
+    e.integrando = identidad_evaluacion(p);
+    e.procesos = procesos;
+    e.proceso = proceso;
+    return e;
+}
+
+// Formato binario: firma, campos de tamaño fijo, la identidad del integrando
+// con su largo, los momentos y los pares (inicio, fin)
+constexpr char FIRMA_PUNTO_CONTROL[8] = {'M', 'C', 'P', 'C', '0', '0', '0', '3'};
+
+// Versiones 1 y 2: la misma cabecera sin el integrando. Se lee solo la
+// cabecera, para rechazarlas con un motivo en lugar de mezclar integrandos.
+constexpr char FIRMA_PUNTO_CONTROL_1[8] = {'M', 'C', 'P', 'C', '0', '0', '0', '1'};
+constexpr char FIRMA_PUNTO_CONTROL_2[8] = {'M', 'C', 'P', 'C', '0', '0', '0', '2'};
+
+// Escribe en ruta.tmp y renombra: un corte a mitad de escritura deja intacto el
+// archivo anterior
+inline bool guardar_punto_control(const std::string& ruta, const EstadoPuntoControl& e) {
+    const std::string temporal = ruta + ".tmp";
+    std::FILE* archivo = std::fopen(temporal.c_str(), "wb");
+    if (!archivo) return false;
+
+    bool ok = true;
+    auto escribir = [&](const void* datos, std::size_t bytes) {
+        ok = ok && std::fwrite(datos, 1, bytes, archivo) == bytes;
+    };
+    const std::int64_t rangos = std::int64_t(e.hechos.rangos.size());
+    const std::int64_t largo = std::int64_t(e.integrando.size());
+    escribir(FIRMA_PUNTO_CONTROL, sizeof(FIRMA_PUNTO_CONTROL));
+    escribir(&e.seed, sizeof(e.seed));
+    escribir(&e.motor, sizeof(e.motor));
+    escribir(&e.muestreo, sizeof(e.muestreo));
+    escribir(&e.dimensiones, sizeof(e.dimensiones));
+    escribir(&e.procesos, sizeof(e.procesos));
+    escribir(&e.proceso, sizeof(e.proceso));
+    escribir(&e.lim_inf, sizeof(e.lim_inf));
+    escribir(&e.lim_sup, sizeof(e.lim_sup));
+    escribir(&e.N, sizeof(e.N));
+    escribir(&largo, sizeof(largo));
+    escribir(e.integrando.data(), e.integrando.size());
+    escribir(&e.momentos, sizeof(e.momentos));
+    escribir(&rangos, sizeof(rangos));
+    escribir(e.hechos.rangos.data(), e.hechos.rangos.size() * sizeof(Rango));
+
+    ok = (std::fclose(archivo) == 0) && ok;
+    return ok && std::rename(temporal.c_str(), ruta.c_str()) == 0;
+}
+
+inline bool cargar_punto_control(const std::string& ruta, EstadoPuntoControl& e) {
+    std::FILE* archivo = std::fopen(ruta.c_str(), "rb");
+    if (!archivo) return false;
+
+    bool ok = true;
+    auto leer = [&](void* datos, std::size_t bytes) {
+        ok = ok && std::fread(datos, 1, bytes, archivo) == bytes;
+    };
+    char firma[sizeof(FIRMA_PUNTO_CONTROL)];
+    std::int64_t rangos = 0, largo = 0;
+    leer(firma, sizeof(firma));
+    const bool anterior = ok && (std::memcmp(firma, FIRMA_PUNTO_CONTROL_1, sizeof(firma)) == 0 ||
+                                 std::memcmp(firma, FIRMA_PUNTO_CONTROL_2, sizeof(firma)) == 0);
+    ok = ok && (anterior || std::memcmp(firma, FIRMA_PUNTO_CONTROL, sizeof(firma)) == 0);
+    leer(&e.seed, sizeof(e.seed));
+    leer(&e.motor, sizeof(e.motor));
+    leer(&e.muestreo, sizeof(e.muestreo));
+    leer(&e.dimensiones, sizeof(e.dimensiones));
+    leer(&e.procesos, sizeof(e.procesos));
+    leer(&e.proceso, sizeof(e.proceso));
+    leer(&e.lim_inf, sizeof(e.lim_inf));
+    leer(&e.lim_sup, sizeof(e.lim_sup));
+    leer(&e.N, sizeof(e.N));
+    e.integrando.clear();
+    if (!ok || anterior) {
+        std::fclose(archivo);
+        return ok;
+    }
+    leer(&largo, sizeof(largo));
+    if (ok && largo >= 0 && largo <= (1 << 20)) {
+        e.integrando.resize(std::size_t(largo));
+        leer(&e.integrando[0], e.integrando.size());
+    } else {
+        ok = false;
+    }
+    leer(&e.momentos, sizeof(e.momentos));
+    leer(&rangos, sizeof(rangos));
+    if (ok && rangos >= 0) {
+        e.hechos.rangos.resize(std::size_t(rangos));
+        leer(e.hechos.rangos.data(), e.hechos.rangos.size() * sizeof(Rango));
+    }
+    std::fclose(archivo);
+    return ok && rangos >= 0;
+}
+
+// Motivo por el que un punto de control no sirve para reanudar con p (vacío si sirve).
+// --n puede crecer: las muestras nuevas son las de índice mayor.
+inline std::string validar_punto_control(const Parametros& p, const EstadoPuntoControl& e) {
+    if (e.seed != p.seed || e.motor != int(p.motor) || e.muestreo != int(p.muestreo))
+        return "la semilla, el motor o el muestreo no coinciden con el punto de control";
+    if (e.dimensiones != p.dimensiones || e.lim_inf != p.lim_inf || e.lim_sup != p.lim_sup)
+        return "el dominio no coincide con el punto de control";
+    if (e.integrando.empty())
+        return "el punto de control es de una versión que no guardaba el integrando; hay que empezar sin --resume";
+    if (e.integrando != identidad_evaluacion(p))
+        return "el integrando (--expr, --plugin) o la precisión no coinciden con el punto de control";
+    if (e.hechos.fin() > p.N)
+        return "el punto de control tiene muestras más allá de --n";
+    return "";
+}
+
+// Escritura asíncrona: publicar copia el estado y vuelve enseguida; un hilo
+// aparte lo escribe. Si llegan varios estados antes de terminar una escritura
+// solo se escribe el último.
+class EscritorPuntoControl {
+public:
+    explicit EscritorPuntoControl(std::string ruta) : ruta(std::move(ruta)), hilo([this] { atender(); }) {}
+
+    // Escribe el último estado publicado antes de terminar
+    ~EscritorPuntoControl() {
+        {
+            std::lock_guard<std::mutex> cerrojo(mutex);
+            terminar = true;
+        }
+        aviso.notify_one();
+        hilo.join();
+    }
+
+    EscritorPuntoControl(const EscritorPuntoControl&) = delete;
+    EscritorPuntoControl& operator=(const EscritorPuntoControl&) = delete;
+
+    void publicar(const EstadoPuntoControl& estado) {
+        {
+            std::lock_guard<std::mutex> cerrojo(mutex);
+            pendiente = estado;
+            hay_pendiente = true;
+        }
+        aviso.notify_one();
+    }
+
+private:
+    void atender() {
+        std::unique_lock<std::mutex> cerrojo(mutex);
+        while (true) {
+            aviso.wait(cerrojo, [this] { return hay_pendiente || terminar; });
+            if (hay_pendiente) {
+                EstadoPuntoControl estado = std::move(pendiente);
+                hay_pendiente = false;
+                cerrojo.unlock();
+                if (!guardar_punto_control(ruta, estado)) {
+                    std::cerr << "No se pudo escribir el punto de control " << ruta << std::endl;
+                }
+                cerrojo.lock();
+            } else if (terminar) {
+                return;
+            }
+        }
+    }
+
+    std::string ruta;
+    std::mutex mutex;
+    std::condition_variable aviso;
+    EstadoPuntoControl pendiente;
+    bool hay_pendiente = false;
+    bool terminar = false;
+    std::thread hilo;
+};
+
+// Bloques por tramo entre puntos de control: con 2^10 bloques (16M muestras)
+// la espera al final de cada tramo es despreciable frente al tramo
+constexpr long long BLOQUES_POR_TRAMO_CONTROL = 1 << 10;
+
+// Integración con puntos de control. Las muestras se integran en tramos con
+// integrar, omitiendo las que ya figuran en "excluidos" (hechas por esta u otra
+// corrida); al terminar cada tramo se actualiza el estado y, si pasaron
+// "intervalo" segundos desde la última escritura, se publica al escritor.
+class PuntoControl {
+public:
+    PuntoControl(const std::string& ruta, double intervalo, EstadoPuntoControl estado, Intervalos excluidos)
+        : estado(std::move(estado)), excluidos(std::move(excluidos)), intervalo(intervalo),
+          ultima_escritura(tiempo()), escritor(ruta) {}
+
+    template <class Flujo, class F>
+    void integrar(const F& func, const Dominio& dominio, Rango muestras, unsigned long long seed) {
+        const long long tramo = BLOQUES_POR_TRAMO_CONTROL * TAMANO_BLOQUE;
+        for (long long inicio = muestras.inicio; inicio < muestras.fin; inicio += tramo) {
+            Rango actual{inicio, std::min(inicio + tramo, muestras.fin)};
+            for (Rango pieza : excluidos.faltantes(actual)) {
+                estado.momentos += montecarlo::integrar<Flujo>(func, dominio, pieza, seed);
+                estado.hechos.agregar(pieza);
+            }
+            if (intervalo > 0.0 && tiempo() - ultima_escritura >= intervalo) guardar();
+        }
+    }
+
+    // Publica el estado actual (también al final, para poder extender la corrida)
+    void guardar() {
+        escritor.publicar(estado);
+        ultima_escritura = tiempo();
+    }
+
+    const Momentos& momentos() const { return estado.momentos; }
+
+private:
+    EstadoPuntoControl estado;
+    Intervalos excluidos;
+    double intervalo;
+    double ultima_escritura;
+    EscritorPuntoControl escritor;
+};
+
+// Integración de [0, N) en memoria compartida con puntos de control en
+// p.punto_control; con --resume continúa desde el archivo existente
+template <class F>
+Momentos integrar_con_punto_control(const F& func, const Dominio& dominio, const Parametros& p) {
+    EstadoPuntoControl estado = estado_inicial(p, 1, 0);
+    if (p.reanudar) {
+        EstadoPuntoControl anterior;
+        if (!cargar_punto_control(p.punto_control, anterior)) {
+            std::cerr << "No se pudo leer el punto de control " << p.punto_control << std::endl;
+            exit(1);
+        }
+        std::string error = validar_punto_control(p, anterior);
+        if (!error.empty()) {
+            std::cerr << error << std::endl;
+            exit(1);
+        }
+        estado.momentos = anterior.momentos;
+        estado.hechos = anterior.hechos;
+    }
+
+    Intervalos excluidos = estado.hechos;
+    PuntoControl control(p.punto_control, p.intervalo_punto_control, std::move(estado), std::move(excluidos));
+    despachar_flujo(p, [&](auto tipo) {
+        using Flujo = typename decltype(tipo)::type;
+        control.integrar<Flujo>(func, dominio, Rango{0, p.N}, p.seed);
+        return 0;
+    });
+    control.guardar();
+    return control.momentos();
+}
+
+} // namespace montecarlo
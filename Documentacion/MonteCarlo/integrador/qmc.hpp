@@ -0,0 +1,273 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "motores.hpp"
+#include "philox.hpp"
+#include "sobol_joe_kuo.hpp"
+
+namespace montecarlo {
+
+// Dimensiones soportadas por las secuencias de baja discrepancia
+constexpr int DIMENSION_MAXIMA_QMC = 1024;
+static_assert(DIMENSION_MAXIMA_QMC <= qmc::DIMENSIONES_JOE_KUO, "faltan filas de Joe-Kuo");
+
+namespace qmc {
+
+// Invierte el orden de los 64 bits
+inline std::uint64_t invertir_bits(std::uint64_t x) {
+    x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+    x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return __builtin_bswap64(x);
+}
+
+// Aleatorización anidada tipo Owen por hash (Laine-Karras / Burley 2020, en 64 bits).
+// Sobre los bits invertidos, cada operación cambia el bit j solo en función de
+// los bits menores que j, es decir, cada dígito binario de x se permuta según
+// los dígitos más significativos: exactamente la estructura del scrambling de Owen.
+inline std::uint64_t owen(std::uint64_t x, std::uint64_t semilla) {
+    x = invertir_bits(x);
+    x ^= x * 0x3D20ADEA6F1C4B2EULL;
+    x += semilla;
+    x *= (semilla >> 32) | 1;
+    x ^= x * 0x05526C56B1D3F8A4ULL;
+    x ^= x * 0x53A22864E9C07D1AULL;
+    return invertir_bits(x);
+}
+
+// Semilla de aleatorización de la dimensión k
+inline std::uint64_t semilla_dimension(std::uint64_t seed, int k) {
+    return mezclar64(seed ^ mezclar64(std::uint64_t(k) + 0xA0761D6478BD642FULL));
+}
+
+// ---------------------------------------------------------------------------
+// Números de dirección de Sobol
+// ---------------------------------------------------------------------------
+
+// Tabla V[k][j] de números de dirección (64 bits) para las DIMENSION_MAXIMA_QMC
+// primeras dimensiones. La dimensión 0 es van der Corput; las demás usan los
+// polinomios primitivos y los m_i iniciales publicados por Joe y Kuo
+// (sobol_joe_kuo.hpp), elegidos por ellos para acotar los valores t de las
+// proyecciones bidimensionales: la secuencia es la Sobol estándar y se puede
+// comparar con cualquier implementación de referencia.
+class TablaSobol {
+public:
+    static constexpr int BITS = 64;
+
+    static const TablaSobol& instancia() {
+        static const TablaSobol tabla;
+        return tabla;
+    }
+
+    const std::uint64_t* direcciones(int k) const { return v.data() + std::size_t(k) * BITS; }
+
+private:
+    TablaSobol() : v(std::size_t(DIMENSION_MAXIMA_QMC) * BITS) {
+        for (int j = 0; j < BITS; j++) v[j] = std::uint64_t(1) << (BITS - 1 - j);
+        for (int k = 1; k < DIMENSION_MAXIMA_QMC; k++) {
+            direcciones_polinomio(JOE_KUO[k - 1], v.data() + std::size_t(k) * BITS);
+        }
+    }
+
+    // Números de dirección de una fila de Joe-Kuo
+    static void direcciones_polinomio(const DireccionesJoeKuo& fila, std::uint64_t* salida) {
+        const int grado = fila.grado;
+        std::uint64_t m[BITS + 1] = {0};
+        for (int i = 1; i <= grado; i++) m[i] = fila.m[i - 1];
+        // Recurrencia m_i = 2a_1 m_{i-1} ^ 4a_2 m_{i-2} ^ ... ^ 2^s m_{i-s} ^ m_{i-s}
+        for (int i = grado + 1; i <= BITS; i++) {
+            std::uint64_t nuevo = m[i - grado] ^ (m[i - grado] << grado);
+            for (int t = 1; t < grado; t++) {
+                if (fila.a >> (grado - 1 - t) & 1) nuevo ^= m[i - t] << t;
+            }
+            m[i] = nuevo;
+        }
+        for (int j = 0; j < BITS; j++) salida[j] = m[j + 1] << (BITS - 1 - j);
+    }
+
+    std::vector<std::uint64_t> v;
+};
+
+// Primos para las bases de Halton
+inline const std::vector<std::uint32_t>& primos() {
+    static const std::vector<std::uint32_t> lista = [] {
+        std::vector<std::uint32_t> p;
+        for (std::uint32_t n = 2; p.size() < std::size_t(DIMENSION_MAXIMA_QMC); n++) {
+            bool primo = true;
+            for (std::uint32_t q : p) {
+                if (q * q > n) break;
+                if (n % q == 0) { primo = false; break; }
+            }
+            if (primo) p.push_back(n);
+        }
+        return p;
+    }();
+    return lista;
+}
+
+} // namespace qmc
+
+// ---------------------------------------------------------------------------
+// Flujos de baja discrepancia con la misma interfaz que FlujoPhilox
+// ---------------------------------------------------------------------------
+
+// Sobol con aleatorización de Owen. El punto i se obtiene en O(64 d) con el
+// código Gray de i, y el siguiente con un XOR por coordenada (Antonov-Saleev),
+// de modo que cada hilo o proceso salta directamente a su bloque de índices.
+class FlujoSobol {
+public:
+    FlujoSobol(std::uint64_t seed, int dimensiones)
+        : tabla(qmc::TablaSobol::instancia()), x(dimensiones), semillas(dimensiones) {
+        for (int k = 0; k < dimensiones; k++) semillas[k] = qmc::semilla_dimension(seed, k);
+    }
+
+    void saltar_a_muestra(std::uint64_t i) {
+        indice = i;
+        coordenada = 0;
+        std::uint64_t gray = i ^ (i >> 1);
+        for (std::size_t k = 0; k < x.size(); k++) {
+            const std::uint64_t* v = tabla.direcciones(int(k));
+            std::uint64_t valor = 0;
+            for (std::uint64_t g = gray, j = 0; g; g >>= 1, j++) {
+                if (g & 1) valor ^= v[j];
+            }
+            x[k] = valor;
+        }
+    }
+
+    void posicionar(std::uint64_t j) {
+        saltar_a_muestra(j / x.size());
+        for (std::uint64_t t = 0; t < j % x.size(); t++) (*this)();
+    }
+
+    double operator()() {
+        double u = a_unidad(qmc::owen(x[coordenada], semillas[coordenada]));
+        if (++coordenada == x.size()) siguiente();
+        return u;
+    }
+
+    void llenar(double* destino, std::size_t n) {
+        for (std::size_t t = 0; t < n; t++) destino[t] = (*this)();
+    }
+
+private:
+    // Paso Gray: cambia el bit menos significativo en 0 del índice actual
+    void siguiente() {
+        int j = __builtin_ctzll(~indice);
+        for (std::size_t k = 0; k < x.size(); k++) x[k] ^= tabla.direcciones(int(k))[j];
+        indice++;
+        coordenada = 0;
+    }
+
+    const qmc::TablaSobol& tabla;
+    std::vector<std::uint64_t> x;
+    std::vector<std::uint64_t> semillas;
+    std::uint64_t indice = 0;
+    std::size_t coordenada = 0;
+};
+
+// Halton con desplazamiento aleatorio de dígitos (mod b) en cada posición:
+// cada punto queda uniforme en el hipercubo y el estimador es insesgado.
+class FlujoHalton {
+public:
+    FlujoHalton(std::uint64_t seed, int dimensiones)
+        : bases(qmc::primos().begin(), qmc::primos().begin() + dimensiones),
+          desplazamientos(std::size_t(dimensiones) * DIGITOS),
+          pesos(std::size_t(dimensiones) * DIGITOS),
+          colas(std::size_t(dimensiones) * (DIGITOS + 1)),
+          digitos(std::size_t(dimensiones) * DIGITOS),
+          longitudes(dimensiones) {
+        for (int k = 0; k < dimensiones; k++) {
+            SplitMix64 sm;
+            sm.sembrar(qmc::semilla_dimension(seed, k));
+            const double inv_b = 1.0 / double(bases[k]);
+            double escala = inv_b;
+            for (int t = 0; t < DIGITOS; t++) {
+                desplazamientos[k * DIGITOS + t] = std::uint32_t(sm() % bases[k]);
+                pesos[k * DIGITOS + t] = escala;
+                escala *= inv_b;
+            }
+            // Los dígitos más allá de la longitud del índice son 0 + desplazamiento:
+            // su aporte es constante y se precalcula (sumando de menor a mayor)
+            double* cola = colas.data() + k * (DIGITOS + 1);
+            cola[DIGITOS] = 0.0;
+            for (int t = DIGITOS - 1; t >= 0; t--) cola[t] = cola[t + 1] + desplazamientos[k * DIGITOS + t] * pesos[k * DIGITOS + t];
+        }
+        saltar_a_muestra(0);
+    }
+
+    void saltar_a_muestra(std::uint64_t i) {
+        indice = i;
+        coordenada = 0;
+        for (std::size_t k = 0; k < bases.size(); k++) descomponer(k, i);
+    }
+
+    void posicionar(std::uint64_t j) {
+        saltar_a_muestra(j / bases.size());
+        coordenada = j % bases.size();
+        // Las coordenadas anteriores ya se leyeron para esta muestra
+        for (std::size_t k = 0; k < coordenada; k++) descomponer(k, indice + 1);
+    }
+
+    // Inverso radical aleatorizado de indice en la base de la coordenada actual.
+    // Cada coordenada guarda los dígitos de su índice y los incrementa con acarreo.
+    double operator()() {
+        const std::size_t k = coordenada;
+        const std::uint32_t b = bases[k];
+        const std::uint32_t* s = desplazamientos.data() + k * DIGITOS;
+        const double* w = pesos.data() + k * DIGITOS;
+        std::uint32_t* dig = digitos.data() + k * DIGITOS;
+        const int L = longitudes[k];
+
+        double u = colas[k * (DIGITOS + 1) + L];
+        for (int t = L - 1; t >= 0; t--) {
+            std::uint32_t digito = dig[t] + s[t];
+            if (digito >= b) digito -= b;
+            u += double(digito) * w[t];
+        }
+        if (u >= 1.0) u = 0x1.fffffffffffffp-1;
+
+        // Siguiente índice para esta coordenada
+        int t = 0;
+        while (t < L && ++dig[t] == b) dig[t++] = 0;
+        if (t == L && L < DIGITOS) dig[longitudes[k]++] = 1;
+
+        if (++coordenada == bases.size()) {
+            coordenada = 0;
+            indice++;
+        }
+        return u;
+    }
+
+    void llenar(double* destino, std::size_t n) {
+        for (std::size_t t = 0; t < n; t++) destino[t] = (*this)();
+    }
+
+private:
+    // Dígitos necesarios para 53 bits en base 2
+    static constexpr int DIGITOS = 54;
+
+    void descomponer(std::size_t k, std::uint64_t n) {
+        std::uint32_t* dig = digitos.data() + k * DIGITOS;
+        int L = 0;
+        for (; n > 0 && L < DIGITOS; L++) {
+            dig[L] = std::uint32_t(n % bases[k]);
+            n /= bases[k];
+        }
+        longitudes[k] = L;
+    }
+
+    std::vector<std::uint32_t> bases;
+    std::vector<std::uint32_t> desplazamientos;
+    std::vector<double> pesos;
+    std::vector<double> colas;
+    std::vector<std::uint32_t> digitos;
+    std::vector<int> longitudes;
+    std::uint64_t indice = 0;
+    std::size_t coordenada = 0;
+};
+
+} // namespace montecarlo
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "expresion.hpp"
+#include "lotes.hpp"
+#include "momentos.hpp"
+#include "nucleo.hpp"
+#include "parametros.hpp"
+#include "vectorial.hpp"
+
+namespace montecarlo {
+
+// Ambos modos se integran como un integrando de dos salidas con
+// integrar_vectorial: los momentos de f y de la segunda salida y su co-momento
+// bastan para estimar la integral reducida, y se combinan (compensados) entre
+// hilos y procesos como cualquier MomentosVectoriales.
+
+// Variables antitéticas: para cada punto x del lote evalúa f(x) (salida 0) y
+// f(x') con x' = lim_inf + lim_sup - x (salida 1). Si f es monótona en cada
+// coordenada, f(x) y f(x') están anticorrelacionadas y su promedio varía menos.
+template <class F>
+class Antitetico {
+public:
+    Antitetico(const F& func, const Dominio& dominio) : func(func), reflejo(dominio.lim_inf + dominio.lim_sup) {}
+
+    int salidas() const { return 2; }
+
+    void evaluar_lote(const double* soa, std::size_t n, std::size_t d, double* out) const {
+        thread_local std::vector<double> reflejado;
+        reflejado.resize(n * d);
+        for (std::size_t i = 0; i < n * d; i++) reflejado[i] = reflejo - soa[i];
+        func.evaluar_lote(soa, n, d, out);
+        func.evaluar_lote(reflejado.data(), n, d, out + n);
+    }
+
+private:
+    F func;
+    double reflejo;
+};
+
+// Variable de control: evalúa f (salida 0) y h (salida 1) sobre el mismo lote
+template <class F>
+class ConControl {
+public:
+    ConControl(const F& func, const Expresion& control) : func(func), control(control) {}
+
+    int salidas() const { return 2; }
+
+    void evaluar_lote(const double* soa, std::size_t n, std::size_t d, double* out) const {
+        func.evaluar_lote(soa, n, d, out);
+        control.evaluar_lote(soa, n, d, out + n);
+    }
+
+private:
+    F func;
+    Expresion control;
+};
+
+// Llama a funcion(integrando) con f envuelto según el modo pedido en p; termina
+// con el motivo si --control-variate no es una expresión válida
+template <class F, class Funcion>
+decltype(auto) despachar_reduccion(const F& func, const Dominio& dominio, const Parametros& p, Funcion&& funcion) {
+    if (p.antitetico) return funcion(Antitetico<F>(func, dominio));
+
+    Expresion control;
+    std::string error;
+    if (!compilar_expresion(p.variable_control, p.dimensiones, control, error)) {
+        std::cerr << "--control-variate: " << error << std::endl;
+        exit(1);
+    }
+    return funcion(ConControl<F>(func, control));
+}
+
+// Momentos de las muestras [muestras.inicio, muestras.fin) del flujo (pares, con
+// variables antitéticas)
+template <class F>
+MomentosVectoriales integrar_con_reduccion(const F& func, const Dominio& dominio, Rango muestras,
+                                           const Parametros& p) {
+    return despachar_reduccion(func, dominio, p, [&](const auto& reducido) {
+        return integrar_vectorial(reducido, dominio, muestras, p);
+    });
+}
+
+// Estimación con los momentos globales de p.muestras_reduccion() muestras
+inline Resultado estimar_con_reduccion(const MomentosVectoriales& m, const Parametros& p, const Dominio& dominio) {
+    if (p.antitetico) return estimar_antitetico(m, p.muestras_reduccion(), dominio.volumen());
+    return estimar_con_control(m, p.muestras_reduccion(), dominio.volumen(), p.integral_control);
+}
+
+} // namespace montecarlo
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+
+#include "cubatura.hpp"
+#include "instrumentacion.hpp"
+#include "momentos.hpp"
+#include "objetivo.hpp"
+#include "parametros.hpp"
+#include "templado.hpp"
+#include "topologia.hpp"
+
+namespace montecarlo {
+
+// Ubicación de los hilos con --pin
+inline void imprimir_afinidad(const Parametros& p) {
+    if (p.afinidad == Afinidad::NINGUNA) return;
+    const int hilos = hilos_disponibles();
+    std::cout << "Hilos fijados (" << nombre(p.afinidad) << "): " << hilos << " hilos en "
+              << sockets_ocupados(hilos) << " de " << topologia().sockets << " sockets ("
+              << topologia().cpus.size() << " CPUs, " << topologia().nodos << " nodos NUMA)" << std::endl;
+}
+
+// Método que produjo el resultado
+inline std::string nombre_metodo(const Parametros& p) {
+    if (p.cubatura()) {
+        return std::string("cubatura adaptativa (") + nombre_regla(p.dimensiones) + ")" +
+               (p.metodo_automatico ? ", elegida por --method auto" : "");
+    }
+    if (p.templado()) return "templado paralelo (MCMC)";
+    if (p.muestreo != Muestreo::PSEUDOALEATORIO) return "cuasi-Monte Carlo";
+    return "Monte Carlo";
+}
+
+// Con una secuencia QMC y una sola réplica no hay estimación del error de la
+// secuencia: V*sqrt(var/N) es solo la cota de Monte Carlo con esos puntos
+inline bool error_es_cota_mc(const Parametros& p) {
+    return p.muestreo != Muestreo::PSEUDOALEATORIO && p.replicas == 1 && !p.cubatura() && !p.templado();
+}
+
+inline const char* etiqueta_error(const Parametros& p) {
+    return error_es_cota_mc(p) ? " (cota de Monte Carlo, no error QMC)" : "";
+}
+
+inline void imprimir_nota_cota_mc(const Parametros& p) {
+    if (!error_es_cota_mc(p)) return;
+    std::cout << "Nota: el error de la secuencia se estima con --sampler rqmc o --replicas R > 1" << std::endl;
+}
+
+// Potencia de N con exponente -orden / d, como texto simplificado: "N^{-8/3}", "N^{-2}"
+inline std::string potencia_evaluaciones(int orden, int d) {
+    const int comun = std::gcd(orden, d);
+    std::string exponente = std::to_string(orden / comun);
+    if (d / comun > 1) exponente += "/" + std::to_string(d / comun);
+    return "N^{-" + exponente + "}";
+}
+
+// Resultados
+inline void imprimir_resultados(const Parametros& p, const Resultado& r) {
+    std::cout << "Dimensión que utilizaremos: " << p.dimensiones << std::endl;
+    std::cout << "Número de puntos: " << r.muestras << std::endl;
+    std::cout << "Límites: (" << p.lim_inf << ", " << p.lim_sup << ")" << std::endl;
+    imprimir_afinidad(p);
+    if (p.expresiones.size() == 1) {
+        std::cout << "Integrando: " << p.expresiones[0] << std::endl;
+    }
+    if (!p.plugin.empty()) {
+        std::cout << "Integrando: plugin " << p.plugin << std::endl;
+    }
+    std::cout << "Método: " << nombre_metodo(p) << std::endl;
+    std::cout << "RESULTADOS:" << std::endl;
+    std::cout << "Integral estimada: " << r.integral << std::endl;
+    std::cout << "Error estimado: " << r.error << etiqueta_error(p) << std::endl;
+    if (!p.templado() && !p.cubatura()) {
+        std::cout << "Varianza de f: " << r.varianza << std::endl;
+    }
+    if (p.cubatura()) {
+        // Una regla de grado g deja un error O(h^(g+1)) y N crece como h^-d. El
+        // error estimado es el de la regla anidada: G7 (grado 13) con d = 1 y la
+        // de grado 5 de Genz-Malik
+        const int d = p.dimensiones;
+        const int orden = d == 1 ? 24 : 8, orden_estimado = d == 1 ? 14 : 6;
+        std::cout << "Escala del error: O(" << potencia_evaluaciones(orden, d) << ") para f suave; el estimado, O("
+                  << potencia_evaluaciones(orden_estimado, d) << ")" << std::endl;
+    } else if (p.muestreo == Muestreo::PSEUDOALEATORIO) {
+        std::cout << "Escala del error: O(N^{-1/2})" << std::endl;
+    } else {
+        std::cout << "Escala del error: O((log N)^d / N)" << std::endl;
+    }
+    if (p.replicas > 1) {
+        std::cout << "Réplicas: " << p.replicas << " (error estimado entre réplicas)" << std::endl;
+    }
+    imprimir_nota_cota_mc(p);
+    if (p.miser) {
+        std::cout << "Muestreo estratificado recursivo (MISER)" << std::endl;
+    }
+    if (p.iteraciones_vegas > 0) {
+        std::cout << "Iteraciones VEGAS: " << p.iteraciones_vegas << ", chi^2/dof: " << r.chi2_dof << std::endl;
+    }
+    if (p.precision_mixta) {
+        std::cout << "Precisión mixta: puntos y evaluación en float, sumas en double" << std::endl;
+    }
+    if (p.antitetico) {
+        std::cout << "Variables antitéticas: " << r.muestras / 2 << " pares" << std::endl;
+    }
+    if (!p.variable_control.empty()) {
+        std::cout << "Variable de control: " << p.variable_control << " (integral " << p.integral_control
+                  << "), coeficiente: " << r.coeficiente_control << std::endl;
+    }
+    if (!p.cache.empty()) {
+        std::cout << "Caché: " << r.muestras_cache << " muestras reutilizadas, " << r.muestras - r.muestras_cache
+                  << " integradas" << std::endl;
+    }
+    if (p.reduccion_varianza() && r.varianza_eliminada) {
+        std::cout << "Reducción de varianza: varianza eliminada (la varianza efectiva es nula salvo redondeo)"
+                  << std::endl;
+    } else if (p.reduccion_varianza()) {
+        std::cout << "Reducción de varianza: " << r.reduccion_varianza << " (sin reducción, el mismo error pediría "
+                  << r.muestras * r.reduccion_varianza << " puntos)" << std::endl;
+    }
+}
+
+// Resultados de un integrando vectorial: cada integral con su error y la
+// correlación entre las estimaciones (todas usan los mismos puntos)
+inline void imprimir_resultados(const Parametros& p, const ResultadoVectorial& r) {
+    const int K = int(r.componentes.size());
+    std::cout << "Dimensión que utilizaremos: " << p.dimensiones << std::endl;
+    std::cout << "Número de puntos: " << r.muestras << std::endl;
+    std::cout << "Límites: (" << p.lim_inf << ", " << p.lim_sup << ")" << std::endl;
+    imprimir_afinidad(p);
+    std::cout << "Método: " << nombre_metodo(p) << std::endl;
+    std::cout << "RESULTADOS (" << K << " integrandos sobre los mismos puntos):" << std::endl;
+    for (int j = 0; j < K; j++) {
+        const Resultado& c = r.componentes[j];
+        std::cout << "[" << j + 1 << "] " << p.expresiones[j] << std::endl;
+        std::cout << "    Integral estimada: " << c.integral << std::endl;
+        std::cout << "    Error estimado: " << c.error << etiqueta_error(p) << std::endl;
+        std::cout << "    Varianza de f: " << c.varianza << std::endl;
+    }
+    std::cout << "Correlación entre las estimaciones:" << std::endl;
+    for (int j = 0; j < K; j++) {
+        for (int l = 0; l < K; l++) {
+            double cov = r.covarianza[std::size_t(j) * K + l];
+            double escala = r.componentes[j].error * r.componentes[l].error;
+            std::cout << std::setw(10) << std::fixed << std::setprecision(4) << (escala > 0.0 ? cov / escala : 0.0);
+        }
+        std::cout << std::endl;
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+    imprimir_nota_cota_mc(p);
+}
+
+// Resultados de la cubatura adaptativa: las regiones finales y si el error
+// estimado alcanzó la tolerancia antes de agotar --n o --max-time
+inline void imprimir_resultados(const Parametros& p, const ResultadoCubatura& r) {
+    imprimir_resultados(p, r.resultado);
+    std::cout << "Regiones: " << r.regiones << " en " << r.rondas << " rondas, tolerancia: " << r.tolerancia
+              << std::endl;
+    if (!r.convergida) {
+        std::cout << "Aviso: el error estimado no alcanzó la tolerancia con " << r.resultado.muestras
+                  << " evaluaciones (se puede aumentar --n o --max-time, o relajar la tolerancia con --target-rel)"
+                  << std::endl;
+    }
+}
+
+// Resultados de la precisión objetivo, con un aviso si --n o --max-time se
+// agotaron antes de alcanzarla
+inline void imprimir_resultados(const Parametros& p, const ResultadoObjetivo& r) {
+    imprimir_resultados(p, r.resultado);
+    if (!r.alcanzado) {
+        std::cout << "Aviso: el error estimado no alcanzó el objetivo " << r.tolerancia << " con "
+                  << r.resultado.muestras << " muestras (se puede aumentar --n o --max-time)" << std::endl;
+    }
+}
+
+// Resultados del templado paralelo y, por peldaño, la aceptación de
+// Metropolis, los intercambios con el peldaño siguiente, el tiempo de
+// autocorrelación de w y el tamaño efectivo de la muestra
+inline void imprimir_resultados(const Parametros& p, const ResultadoTemplado& r) {
+    imprimir_resultados(p, r.resultado);
+    std::cout << "Templado paralelo: " << p.temperaturas << " temperaturas, " << r.cadenas
+              << " cadenas por temperatura, " << r.pasos << " pasos (" << r.calentamiento << " de calentamiento)"
+              << std::endl;
+    std::cout << "Error estimado por jackknife entre escaleras" << std::endl;
+    std::cout << "    beta  aceptación  intercambio       tau         ESS   log Z_k+1/Z_k" << std::endl;
+    const std::size_t T = r.temperaturas.size();
+    double ess_minimo = HUGE_VAL;
+    bool truncado = false;
+    long long negativos = 0;
+    for (std::size_t t = 0; t < T; t++) {
+        const EstadisticaTemperatura& e = r.temperaturas[t];
+        negativos += e.negativos;
+        std::cout << std::fixed << std::setprecision(4) << std::setw(8) << r.beta[t] << std::setw(12)
+                  << double(e.aceptadas) / double(e.propuestas);
+        if (t + 1 == T) {
+            std::cout << std::endl;
+            continue;
+        }
+        std::cout << std::setw(13) << double(e.intercambios) / double(e.intentos_intercambio) << std::setprecision(1)
+                  << std::setw(10) << r.tau[t] << (r.tau_truncado[t] ? "+" : " ") << std::setw(12)
+                  << std::setprecision(0) << r.muestras_efectivas[t] << std::setprecision(4) << std::setw(11)
+                  << r.log_cociente[t] << " ± " << r.error_log_cociente[t] << std::endl;
+        ess_minimo = std::min(ess_minimo, r.muestras_efectivas[t]);
+        truncado = truncado || r.tau_truncado[t];
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+    std::cout << "ESS mínimo: " << ess_minimo << std::endl;
+    if (std::isnan(r.integral_termodinamica)) {
+        std::cout << "Integración termodinámica: no disponible (f se anula en algunas muestras)" << std::endl;
+    } else {
+        std::cout << "Integración termodinámica: " << r.integral_termodinamica << std::endl;
+    }
+    if (truncado) {
+        std::cout << "Aviso: en los peldaños con + la autocorrelación no decae en " << RETARDOS_AUTOCORRELACION
+                  << " pasos; tau es una cota inferior y el ESS puede estar sobreestimado" << std::endl;
+    }
+    if (negativos > 0) {
+        std::cout << "Aviso: f tomó " << negativos << " valores negativos; el templado supone f >= 0 y los trató como 0"
+                  << std::endl;
+    }
+}
+
+// Activa la instrumentación si se pidió --profile
+inline void iniciar_instrumentacion(const Parametros& p) {
+    if (!p.perfil.empty()) instrumentacion().activar();
+}
+
+// Traza de Chrome (chrome://tracing o Perfetto) con los eventos dados
+inline void escribir_traza(const std::string& ruta, const std::string& eventos) {
+    std::ofstream archivo(ruta);
+    archivo << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" << eventos << "\n]}\n";
+    if (!archivo) std::cerr << "No se pudo escribir la traza " << ruta << std::endl;
+}
+
+// Tabla por hilo y traza en p.perfil al terminar
+inline void reportar_instrumentacion(const Parametros& p) {
+    if (!instrumentacion_activa) return;
+    std::cout << instrumentacion().resumen(0);
+    escribir_traza(p.perfil, instrumentacion().eventos_json(0));
+}
+
+} // namespace montecarlo
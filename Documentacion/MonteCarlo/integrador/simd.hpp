@@ -0,0 +1,617 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#include "momentos.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define MONTECARLO_X86 1
+#include <immintrin.h>
+#endif
+
+namespace montecarlo {
+namespace simd {
+
+// Conjunto de instrucciones usado por los kernels por lotes
+enum class Nivel { ESCALAR, AVX2, AVX512 };
+
+inline const char* nombre(Nivel nivel) {
+    switch (nivel) {
+        case Nivel::AVX512: return "avx512";
+        case Nivel::AVX2: return "avx2";
+        default: return "escalar";
+    }
+}
+
+// Detección en tiempo de ejecución (una sola vez por proceso). La variable de
+// entorno MONTECARLO_SIMD=escalar|avx2|avx512 permite forzar un nivel inferior.
+inline Nivel detectar() {
+    Nivel nivel = Nivel::ESCALAR;
+#ifdef MONTECARLO_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) nivel = Nivel::AVX2;
+    if (__builtin_cpu_supports("avx512f")) nivel = Nivel::AVX512;
+#endif
+    if (const char* forzado = std::getenv("MONTECARLO_SIMD")) {
+        Nivel pedido = nivel;
+        if (std::strcmp(forzado, "escalar") == 0) pedido = Nivel::ESCALAR;
+        else if (std::strcmp(forzado, "avx2") == 0) pedido = Nivel::AVX2;
+        else if (std::strcmp(forzado, "avx512") == 0) pedido = Nivel::AVX512;
+        if (pedido < nivel) nivel = pedido;
+    }
+    return nivel;
+}
+
+inline Nivel nivel() {
+    static const Nivel nivel_detectado = detectar();
+    return nivel_detectado;
+}
+
+// Los bloques usan disposición SoA: la coordenada k del punto i está en soa[k*n + i]
+
+// ---------------------------------------------------------------------------
+// Versión escalar (respaldo para cualquier CPU)
+// ---------------------------------------------------------------------------
+
+inline void gaussiana_escalar(const double* soa, std::size_t n, std::size_t d, double* out) {
+    for (std::size_t i = 0; i < n; i++) out[i] = 0.0;
+    for (std::size_t k = 0; k < d; k++) {
+        const double* x = soa + k * n;
+        for (std::size_t i = 0; i < n; i++) out[i] += x[i] * x[i];
+    }
+    for (std::size_t i = 0; i < n; i++) out[i] = std::exp(-out[i]);
+}
+
+inline void exponencial_escalar(const double* x, std::size_t n, double* out) {
+    for (std::size_t i = 0; i < n; i++) out[i] = std::exp(x[i]);
+}
+
+// Dos pasadas sobre el lote, que sigue en caché: la media y después
+// m2 = sum (x - media)^2, sin la cancelación de sum x^2 - n media^2
+inline Momentos sumar_escalar(const double* valores, std::size_t n) {
+    Momentos m;
+    if (n == 0) return m;
+    double suma = 0.0;
+    for (std::size_t i = 0; i < n; i++) suma += valores[i];
+    m.n = (long long)n;
+    m.media = suma / double(n);
+    for (std::size_t i = 0; i < n; i++) {
+        double d = valores[i] - m.media;
+        m.m2 += d * d;
+    }
+    return m;
+}
+
+// Precisión mixta: evaluación en float, sumas en double
+inline void gaussiana_escalar(const float* soa, std::size_t n, std::size_t d, float* out) {
+    for (std::size_t i = 0; i < n; i++) out[i] = 0.0f;
+    for (std::size_t k = 0; k < d; k++) {
+        const float* x = soa + k * n;
+        for (std::size_t i = 0; i < n; i++) out[i] += x[i] * x[i];
+    }
+    for (std::size_t i = 0; i < n; i++) out[i] = std::exp(-out[i]);
+}
+
+inline void exponencial_escalar(const float* x, std::size_t n, float* out) {
+    for (std::size_t i = 0; i < n; i++) out[i] = std::exp(x[i]);
+}
+
+inline Momentos sumar_escalar(const float* valores, std::size_t n) {
+    Momentos m;
+    if (n == 0) return m;
+    double suma = 0.0;
+    for (std::size_t i = 0; i < n; i++) suma += double(valores[i]);
+    m.n = (long long)n;
+    m.media = suma / double(n);
+    for (std::size_t i = 0; i < n; i++) {
+        double d = double(valores[i]) - m.media;
+        m.m2 += d * d;
+    }
+    return m;
+}
+
+inline double producto_escalar(const double* a, const double* b, std::size_t n) {
+    double suma = 0.0;
+    for (std::size_t i = 0; i < n; i++) suma += a[i] * b[i];
+    return suma;
+}
+
+#ifdef MONTECARLO_X86
+
+// Coeficientes 1/k! del polinomio de Taylor de e^r, |r| <= ln(2)/2 (error < 1e-17)
+constexpr double EXP_COEF[14] = {
+    1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040,
+    1.0 / 40320, 1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800,
+    1.0 / 479001600, 1.0 / 6227020800.0};
+constexpr double LOG2E = 1.4426950408889634;
+constexpr double LN2_HI = 6.93145751953125e-1;
+constexpr double LN2_LO = 1.42860682030941723212e-6;
+constexpr double EXP_MIN = -708.0;  // por debajo, e^x se toma como 0
+
+// Versión float (Cephes expf): e^r = 1 + r + r^2 P(r), |r| <= ln(2)/2, error < 2 ulp
+constexpr float EXPF_COEF[6] = {1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f,
+                                4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f};
+constexpr float LOG2EF = 1.44269504088896341f;
+constexpr float LN2F_HI = 0.693359375f;
+constexpr float LN2F_LO = -2.12194440e-4f;
+constexpr float EXPF_MIN = -87.0f;  // por debajo, e^x se toma como 0
+constexpr float EXPF_MAX = 88.0f;   // por encima se usa std::exp
+
+// ---------------------------------------------------------------------------
+// AVX2 + FMA (4 doubles por registro)
+// ---------------------------------------------------------------------------
+
+// Suma de los 4 carriles
+__attribute__((target("avx2,fma")))
+inline double horizontal_avx2(__m256d v) {
+    alignas(32) double s[4];
+    _mm256_store_pd(s, v);
+    return (s[0] + s[1]) + (s[2] + s[3]);
+}
+
+// e^x = 2^n * e^r con n = round(x / ln 2) y r = x - n ln 2
+__attribute__((target("avx2,fma")))
+inline __m256d exp_avx2(__m256d x) {
+    __m256d bajo = _mm256_cmp_pd(x, _mm256_set1_pd(EXP_MIN), _CMP_LT_OQ);
+    x = _mm256_max_pd(x, _mm256_set1_pd(EXP_MIN));
+    x = _mm256_min_pd(x, _mm256_set1_pd(709.0));
+
+    __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(LOG2E)),
+                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(LN2_HI), x);
+    r = _mm256_fnmadd_pd(n, _mm256_set1_pd(LN2_LO), r);
+
+    __m256d p = _mm256_set1_pd(EXP_COEF[13]);
+    for (int k = 12; k >= 0; k--) p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(EXP_COEF[k]));
+
+    // 2^n construido directamente en el exponente IEEE-754
+    __m256i e = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n));
+    e = _mm256_slli_epi64(_mm256_add_epi64(e, _mm256_set1_epi64x(1023)), 52);
+    return _mm256_andnot_pd(bajo, _mm256_mul_pd(p, _mm256_castsi256_pd(e)));
+}
+
+__attribute__((target("avx2,fma")))
+inline void gaussiana_avx2(const double* soa, std::size_t n, std::size_t d, double* out) {
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d suma = _mm256_setzero_pd();
+        for (std::size_t k = 0; k < d; k++) {
+            __m256d x = _mm256_loadu_pd(soa + k * n + i);
+            suma = _mm256_fmadd_pd(x, x, suma);
+        }
+        _mm256_storeu_pd(out + i, exp_avx2(_mm256_sub_pd(_mm256_setzero_pd(), suma)));
+    }
+    for (; i < n; i++) {
+        double suma = 0.0;
+        for (std::size_t k = 0; k < d; k++) suma += soa[k * n + i] * soa[k * n + i];
+        out[i] = std::exp(-suma);
+    }
+}
+
+// Grupos con algún valor fuera del rango del kernel (> 709 o NaN) van a std::exp
+__attribute__((target("avx2,fma")))
+inline void exponencial_avx2(const double* x, std::size_t n, double* out) {
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(x + i);
+        if (_mm256_movemask_pd(_mm256_cmp_pd(v, _mm256_set1_pd(709.0), _CMP_NLE_UQ))) {
+            for (std::size_t j = i; j < i + 4; j++) out[j] = std::exp(x[j]);
+        } else {
+            _mm256_storeu_pd(out + i, exp_avx2(v));
+        }
+    }
+    for (; i < n; i++) out[i] = std::exp(x[i]);
+}
+
+// 8 floats por registro: el doble de carriles que en double
+__attribute__((target("avx2,fma")))
+inline __m256 exp_avx2(__m256 x) {
+    __m256 bajo = _mm256_cmp_ps(x, _mm256_set1_ps(EXPF_MIN), _CMP_LT_OQ);
+    x = _mm256_max_ps(x, _mm256_set1_ps(EXPF_MIN));
+    x = _mm256_min_ps(x, _mm256_set1_ps(EXPF_MAX));
+
+    __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(LOG2EF)),
+                               _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(LN2F_HI), x);
+    r = _mm256_fnmadd_ps(n, _mm256_set1_ps(LN2F_LO), r);
+
+    __m256 p = _mm256_set1_ps(EXPF_COEF[0]);
+    for (int k = 1; k < 6; k++) p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(EXPF_COEF[k]));
+    p = _mm256_fmadd_ps(p, _mm256_mul_ps(r, r), _mm256_add_ps(r, _mm256_set1_ps(1.0f)));
+
+    __m256i e = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_andnot_ps(bajo, _mm256_mul_ps(p, _mm256_castsi256_ps(e)));
+}
+
+__attribute__((target("avx2,fma")))
+inline void gaussiana_avx2(const float* soa, std::size_t n, std::size_t d, float* out) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 suma = _mm256_setzero_ps();
+        for (std::size_t k = 0; k < d; k++) {
+            __m256 x = _mm256_loadu_ps(soa + k * n + i);
+            suma = _mm256_fmadd_ps(x, x, suma);
+        }
+        _mm256_storeu_ps(out + i, exp_avx2(_mm256_sub_ps(_mm256_setzero_ps(), suma)));
+    }
+    for (; i < n; i++) {
+        float suma = 0.0f;
+        for (std::size_t k = 0; k < d; k++) suma += soa[k * n + i] * soa[k * n + i];
+        out[i] = std::exp(-suma);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+inline void exponencial_avx2(const float* x, std::size_t n, float* out) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(x + i);
+        if (_mm256_movemask_ps(_mm256_cmp_ps(v, _mm256_set1_ps(EXPF_MAX), _CMP_NLE_UQ))) {
+            for (std::size_t j = i; j < i + 8; j++) out[j] = std::exp(x[j]);
+        } else {
+            _mm256_storeu_ps(out + i, exp_avx2(v));
+        }
+    }
+    for (; i < n; i++) out[i] = std::exp(x[i]);
+}
+
+// Cada grupo de 4 floats se amplía a double antes de sumar
+__attribute__((target("avx2,fma")))
+inline Momentos sumar_avx2(const float* valores, std::size_t n) {
+    Momentos m;
+    if (n == 0) return m;
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        s0 = _mm256_add_pd(s0, _mm256_cvtps_pd(_mm_loadu_ps(valores + i)));
+        s1 = _mm256_add_pd(s1, _mm256_cvtps_pd(_mm_loadu_ps(valores + i + 4)));
+    }
+    double suma = horizontal_avx2(_mm256_add_pd(s0, s1));
+    for (; i < n; i++) suma += double(valores[i]);
+    m.n = (long long)n;
+    m.media = suma / double(n);
+
+    const __m256d media = _mm256_set1_pd(m.media);
+    __m256d c0 = _mm256_setzero_pd(), c1 = _mm256_setzero_pd();
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m256d a = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(valores + i)), media);
+        __m256d b = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(valores + i + 4)), media);
+        c0 = _mm256_fmadd_pd(a, a, c0);
+        c1 = _mm256_fmadd_pd(b, b, c1);
+    }
+    m.m2 = horizontal_avx2(_mm256_add_pd(c0, c1));
+    for (; i < n; i++) {
+        double d = double(valores[i]) - m.media;
+        m.m2 += d * d;
+    }
+    return m;
+}
+
+// Dos pasadas, como sumar_escalar; dos acumuladores por pasada para ocultar la
+// latencia de la suma
+__attribute__((target("avx2,fma")))
+inline Momentos sumar_avx2(const double* valores, std::size_t n) {
+    Momentos m;
+    if (n == 0) return m;
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        s0 = _mm256_add_pd(s0, _mm256_loadu_pd(valores + i));
+        s1 = _mm256_add_pd(s1, _mm256_loadu_pd(valores + i + 4));
+    }
+    double suma = horizontal_avx2(_mm256_add_pd(s0, s1));
+    for (; i < n; i++) suma += valores[i];
+    m.n = (long long)n;
+    m.media = suma / double(n);
+
+    const __m256d media = _mm256_set1_pd(m.media);
+    __m256d c0 = _mm256_setzero_pd(), c1 = _mm256_setzero_pd();
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m256d a = _mm256_sub_pd(_mm256_loadu_pd(valores + i), media);
+        __m256d b = _mm256_sub_pd(_mm256_loadu_pd(valores + i + 4), media);
+        c0 = _mm256_fmadd_pd(a, a, c0);
+        c1 = _mm256_fmadd_pd(b, b, c1);
+    }
+    m.m2 = horizontal_avx2(_mm256_add_pd(c0, c1));
+    for (; i < n; i++) {
+        double d = valores[i] - m.media;
+        m.m2 += d * d;
+    }
+    return m;
+}
+
+__attribute__((target("avx2,fma")))
+inline double producto_avx2(const double* a, const double* b, std::size_t n) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), s0);
+        s1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), s1);
+    }
+    double suma = horizontal_avx2(_mm256_add_pd(s0, s1));
+    for (; i < n; i++) suma += a[i] * b[i];
+    return suma;
+}
+
+// ---------------------------------------------------------------------------
+// AVX-512 (8 doubles por registro, colas con máscara)
+// ---------------------------------------------------------------------------
+
+// Los intrínsecos de GCC 12 usan _mm512_undefined_pd() y disparan falsos
+// avisos de variable sin inicializar con -Wall
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f")))
+inline __m512d exp_avx512(__m512d x) {
+    const __mmask8 bajo = _mm512_cmp_pd_mask(x, _mm512_set1_pd(EXP_MIN), _CMP_LT_OQ);
+    x = _mm512_max_pd(x, _mm512_set1_pd(EXP_MIN));
+    x = _mm512_min_pd(x, _mm512_set1_pd(709.0));
+
+    __m512d n = _mm512_roundscale_pd(_mm512_mul_pd(x, _mm512_set1_pd(LOG2E)),
+                                     _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512d r = _mm512_fnmadd_pd(n, _mm512_set1_pd(LN2_HI), x);
+    r = _mm512_fnmadd_pd(n, _mm512_set1_pd(LN2_LO), r);
+
+    __m512d p = _mm512_set1_pd(EXP_COEF[13]);
+    for (int k = 12; k >= 0; k--) p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(EXP_COEF[k]));
+
+    // p * 2^n; por debajo de EXP_MIN, 0 como en exp_avx2 (no el subnormal
+    // más chico que daría scalef con x acotado)
+    return _mm512_maskz_scalef_pd(__mmask8(~bajo), p, n);
+}
+
+__attribute__((target("avx512f")))
+inline void gaussiana_avx512(const double* soa, std::size_t n, std::size_t d, double* out) {
+    for (std::size_t i = 0; i < n; i += 8) {
+        __mmask8 mascara = n - i >= 8 ? __mmask8(0xFF) : __mmask8((1u << (n - i)) - 1);
+        __m512d suma = _mm512_setzero_pd();
+        for (std::size_t k = 0; k < d; k++) {
+            __m512d x = _mm512_maskz_loadu_pd(mascara, soa + k * n + i);
+            suma = _mm512_fmadd_pd(x, x, suma);
+        }
+        _mm512_mask_storeu_pd(out + i, mascara, exp_avx512(_mm512_sub_pd(_mm512_setzero_pd(), suma)));
+    }
+}
+
+__attribute__((target("avx512f")))
+inline void exponencial_avx512(const double* x, std::size_t n, double* out) {
+    for (std::size_t i = 0; i < n; i += 8) {
+        __mmask8 mascara = n - i >= 8 ? __mmask8(0xFF) : __mmask8((1u << (n - i)) - 1);
+        __m512d v = _mm512_maskz_loadu_pd(mascara, x + i);
+        if (_mm512_mask_cmp_pd_mask(mascara, v, _mm512_set1_pd(709.0), _CMP_NLE_UQ)) {
+            for (std::size_t j = i; j < n && j < i + 8; j++) out[j] = std::exp(x[j]);
+        } else {
+            _mm512_mask_storeu_pd(out + i, mascara, exp_avx512(v));
+        }
+    }
+}
+
+// 16 floats por registro
+__attribute__((target("avx512f")))
+inline __m512 exp_avx512(__m512 x) {
+    const __mmask16 bajo = _mm512_cmp_ps_mask(x, _mm512_set1_ps(EXPF_MIN), _CMP_LT_OQ);
+    x = _mm512_max_ps(x, _mm512_set1_ps(EXPF_MIN));
+    x = _mm512_min_ps(x, _mm512_set1_ps(EXPF_MAX));
+
+    __m512 n = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(LOG2EF)),
+                                    _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(LN2F_HI), x);
+    r = _mm512_fnmadd_ps(n, _mm512_set1_ps(LN2F_LO), r);
+
+    __m512 p = _mm512_set1_ps(EXPF_COEF[0]);
+    for (int k = 1; k < 6; k++) p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(EXPF_COEF[k]));
+    p = _mm512_fmadd_ps(p, _mm512_mul_ps(r, r), _mm512_add_ps(r, _mm512_set1_ps(1.0f)));
+
+    return _mm512_maskz_scalef_ps(__mmask16(~bajo), p, n);
+}
+
+__attribute__((target("avx512f")))
+inline void gaussiana_avx512(const float* soa, std::size_t n, std::size_t d, float* out) {
+    for (std::size_t i = 0; i < n; i += 16) {
+        __mmask16 mascara = n - i >= 16 ? __mmask16(0xFFFF) : __mmask16((1u << (n - i)) - 1);
+        __m512 suma = _mm512_setzero_ps();
+        for (std::size_t k = 0; k < d; k++) {
+            __m512 x = _mm512_maskz_loadu_ps(mascara, soa + k * n + i);
+            suma = _mm512_fmadd_ps(x, x, suma);
+        }
+        _mm512_mask_storeu_ps(out + i, mascara, exp_avx512(_mm512_sub_ps(_mm512_setzero_ps(), suma)));
+    }
+}
+
+__attribute__((target("avx512f")))
+inline void exponencial_avx512(const float* x, std::size_t n, float* out) {
+    for (std::size_t i = 0; i < n; i += 16) {
+        __mmask16 mascara = n - i >= 16 ? __mmask16(0xFFFF) : __mmask16((1u << (n - i)) - 1);
+        __m512 v = _mm512_maskz_loadu_ps(mascara, x + i);
+        if (_mm512_mask_cmp_ps_mask(mascara, v, _mm512_set1_ps(EXPF_MAX), _CMP_NLE_UQ)) {
+            for (std::size_t j = i; j < n && j < i + 16; j++) out[j] = std::exp(x[j]);
+        } else {
+            _mm512_mask_storeu_ps(out + i, mascara, exp_avx512(v));
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+inline Momentos sumar_avx512(const float* valores, std::size_t n) {
+    Momentos m;
+    if (n == 0) return m;
+    __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        s0 = _mm512_add_pd(s0, _mm512_cvtps_pd(_mm256_loadu_ps(valores + i)));
+        s1 = _mm512_add_pd(s1, _mm512_cvtps_pd(_mm256_loadu_ps(valores + i + 8)));
+    }
+    for (; i < n; i += 8) {
+        __mmask8 mascara = n - i >= 8 ? __mmask8(0xFF) : __mmask8((1u << (n - i)) - 1);
+        s0 = _mm512_add_pd(s0, _mm512_cvtps_pd(_mm512_castps512_ps256(_mm512_maskz_loadu_ps(mascara, valores + i))));
+    }
+    m.n = (long long)n;
+    m.media = _mm512_reduce_add_pd(_mm512_add_pd(s0, s1)) / double(n);
+
+    // Los carriles fuera del lote quedan en 0 tras la resta enmascarada
+    const __m512d media = _mm512_set1_pd(m.media);
+    __m512d c0 = _mm512_setzero_pd(), c1 = _mm512_setzero_pd();
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m512d a = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(valores + i)), media);
+        __m512d b = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(valores + i + 8)), media);
+        c0 = _mm512_fmadd_pd(a, a, c0);
+        c1 = _mm512_fmadd_pd(b, b, c1);
+    }
+    for (; i < n; i += 8) {
+        __mmask8 mascara = n - i >= 8 ? __mmask8(0xFF) : __mmask8((1u << (n - i)) - 1);
+        __m512d x = _mm512_cvtps_pd(_mm512_castps512_ps256(_mm512_maskz_loadu_ps(mascara, valores + i)));
+        __m512d a = _mm512_maskz_sub_pd(mascara, x, media);
+        c0 = _mm512_fmadd_pd(a, a, c0);
+    }
+    m.m2 = _mm512_reduce_add_pd(_mm512_add_pd(c0, c1));
+    return m;
+}
+
+__attribute__((target("avx512f")))
+inline Momentos sumar_avx512(const double* valores, std::size_t n) {
+    Momentos m;
+    if (n == 0) return m;
+    __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        s0 = _mm512_add_pd(s0, _mm512_loadu_pd(valores + i));
+        s1 = _mm512_add_pd(s1, _mm512_loadu_pd(valores + i + 8));
+    }
+    for (; i < n; i += 8) {
+        __mmask8 mascara = n - i >= 8 ? __mmask8(0xFF) : __mmask8((1u << (n - i)) - 1);
+        s0 = _mm512_add_pd(s0, _mm512_maskz_loadu_pd(mascara, valores + i));
+    }
+    m.n = (long long)n;
+    m.media = _mm512_reduce_add_pd(_mm512_add_pd(s0, s1)) / double(n);
+
+    const __m512d media = _mm512_set1_pd(m.media);
+    __m512d c0 = _mm512_setzero_pd(), c1 = _mm512_setzero_pd();
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m512d a = _mm512_sub_pd(_mm512_loadu_pd(valores + i), media);
+        __m512d b = _mm512_sub_pd(_mm512_loadu_pd(valores + i + 8), media);
+        c0 = _mm512_fmadd_pd(a, a, c0);
+        c1 = _mm512_fmadd_pd(b, b, c1);
+    }
+    for (; i < n; i += 8) {
+        __mmask8 mascara = n - i >= 8 ? __mmask8(0xFF) : __mmask8((1u << (n - i)) - 1);
+        __m512d a = _mm512_maskz_sub_pd(mascara, _mm512_maskz_loadu_pd(mascara, valores + i), media);
+        c0 = _mm512_fmadd_pd(a, a, c0);
+    }
+    m.m2 = _mm512_reduce_add_pd(_mm512_add_pd(c0, c1));
+    return m;
+}
+
+__attribute__((target("avx512f")))
+inline double producto_avx512(const double* a, const double* b, std::size_t n) {
+    __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        s0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), s0);
+        s1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8), s1);
+    }
+    for (; i < n; i += 8) {
+        __mmask8 mascara = n - i >= 8 ? __mmask8(0xFF) : __mmask8((1u << (n - i)) - 1);
+        s0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mascara, a + i), _mm512_maskz_loadu_pd(mascara, b + i), s0);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(s0, s1));
+}
+
+#pragma GCC diagnostic pop
+
+#endif // MONTECARLO_X86
+
+// ---------------------------------------------------------------------------
+// Puntos de entrada con despacho según la CPU
+// ---------------------------------------------------------------------------
+
+// out[i] = e^(-(x_1^2 + ... + x_d^2)) para los n puntos del bloque
+inline void gaussiana(const double* soa, std::size_t n, std::size_t d, double* out) {
+#ifdef MONTECARLO_X86
+    switch (nivel()) {
+        case Nivel::AVX512: return gaussiana_avx512(soa, n, d, out);
+        case Nivel::AVX2: return gaussiana_avx2(soa, n, d, out);
+        default: break;
+    }
+#endif
+    gaussiana_escalar(soa, n, d, out);
+}
+
+// out[i] = e^(x[i]); x y out pueden ser el mismo arreglo
+inline void exponencial(const double* x, std::size_t n, double* out) {
+#ifdef MONTECARLO_X86
+    switch (nivel()) {
+        case Nivel::AVX512: return exponencial_avx512(x, n, out);
+        case Nivel::AVX2: return exponencial_avx2(x, n, out);
+        default: break;
+    }
+#endif
+    exponencial_escalar(x, n, out);
+}
+
+// Momentos de n valores: cantidad, media y M2 = sum (x - media)^2, en dos
+// pasadas vectoriales; quien llama los combina con los de otros lotes por Chan
+inline Momentos sumar(const double* valores, std::size_t n) {
+#ifdef MONTECARLO_X86
+    switch (nivel()) {
+        case Nivel::AVX512: return sumar_avx512(valores, n);
+        case Nivel::AVX2: return sumar_avx2(valores, n);
+        default: break;
+    }
+#endif
+    return sumar_escalar(valores, n);
+}
+
+// Versiones float de la precisión mixta (--precision mixed)
+inline void gaussiana(const float* soa, std::size_t n, std::size_t d, float* out) {
+#ifdef MONTECARLO_X86
+    switch (nivel()) {
+        case Nivel::AVX512: return gaussiana_avx512(soa, n, d, out);
+        case Nivel::AVX2: return gaussiana_avx2(soa, n, d, out);
+        default: break;
+    }
+#endif
+    gaussiana_escalar(soa, n, d, out);
+}
+
+inline void exponencial(const float* x, std::size_t n, float* out) {
+#ifdef MONTECARLO_X86
+    switch (nivel()) {
+        case Nivel::AVX512: return exponencial_avx512(x, n, out);
+        case Nivel::AVX2: return exponencial_avx2(x, n, out);
+        default: break;
+    }
+#endif
+    exponencial_escalar(x, n, out);
+}
+
+// Valores float acumulados en double
+inline Momentos sumar(const float* valores, std::size_t n) {
+#ifdef MONTECARLO_X86
+    switch (nivel()) {
+        case Nivel::AVX512: return sumar_avx512(valores, n);
+        case Nivel::AVX2: return sumar_avx2(valores, n);
+        default: break;
+    }
+#endif
+    return sumar_escalar(valores, n);
+}
+
+// Suma de a[i] * b[i] (productos cruzados de integrandos vectoriales)
+inline double producto(const double* a, const double* b, std::size_t n) {
+#ifdef MONTECARLO_X86
+    switch (nivel()) {
+        case Nivel::AVX512: return producto_avx512(a, b, n);
+        case Nivel::AVX2: return producto_avx2(a, b, n);
+        default: break;
+    }
+#endif
+    return producto_escalar(a, b, n);
+}
+
+} // namespace simd
+} // namespace montecarlo
@@ -0,0 +1,510 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "instrumentacion.hpp"
+#include "lotes.hpp"
+#include "momentos.hpp"
+#include "motores.hpp"
+#include "nucleo.hpp"
+#include "openmp.hpp"
+#include "parametros.hpp"
+#include "topologia.hpp"
+
+namespace montecarlo {
+
+// Templado paralelo (--tempering T). Para f >= 0 concentrada en una región
+// diminuta del dominio, el muestreo uniforme casi nunca la toca. Se recorre
+// la escalera de densidades pi_k(x) ~ f(x)^beta_k en el dominio, con
+// 0 = beta_0 < beta_1 < ... < beta_{T-1} = 1: pi_0 es la uniforme y pi_{T-1}
+// es proporcional a f. Z(beta) = int f^beta, así que Z(0) = V y Z(1) = I.
+//
+// Cada escalera es un conjunto de T cadenas de Metropolis, una por
+// temperatura, que además intercambian estados entre temperaturas vecinas.
+// Con las muestras de pi_k, el cociente entre peldaños es
+//     Z(beta_{k+1}) / Z(beta_k) = E_k[f^(beta_{k+1} - beta_k)]
+// (estimador de cociente, "stepping stone") e I = V * prod_k de los cocientes.
+// Como verificación se informa también la integración termodinámica,
+// log I - log V = int_0^1 E_beta[log f] dbeta, por trapecios en la escalera.
+//
+// Las escaleras son independientes entre sí: el error de la integral sale de
+// un jackknife que quita una escalera a la vez, e incluye la autocorrelación
+// y la correlación entre peldaños que introducen los intercambios. Por
+// temperatura se informan además el tiempo de autocorrelación y el tamaño
+// efectivo de la muestra (ESS) de w, estimados en línea.
+//
+// Las cadenas se agrupan de a CADENAS_POR_GRUPO escaleras: un grupo guarda
+// las posiciones de sus CADENAS_POR_GRUPO * T cadenas en SoA, propone un
+// paso para todas a la vez y las evalúa juntas, en lotes de a lo sumo
+// TAMANO_LOTE (un solo evaluar_lote mientras T <= 32). Los grupos
+// son independientes y cada uno usa su propio flujo (semilla derivada del
+// número de grupo), así que el resultado no depende de hilos ni procesos.
+
+// Escaleras por grupo: un vector AVX-512 de doubles
+constexpr int CADENAS_POR_GRUPO = 8;
+
+// Retardos de la autocorrelación en línea
+constexpr int RETARDOS_AUTOCORRELACION = 64;
+
+// Adaptación del paso durante el calentamiento
+constexpr double ACEPTACION_OBJETIVO = 0.3;
+constexpr int PASOS_ADAPTACION = 25;
+
+// Fracción de los pasos que se descarta como calentamiento
+constexpr int FRACCION_CALENTAMIENTO = 5;
+
+// beta_k = (k / (T - 1))^4: peldaños más juntos cerca de beta = 0, donde
+// E_beta[log f] cambia más rápido
+inline std::vector<double> escalera_temperaturas(int temperaturas) {
+    std::vector<double> beta(std::size_t(temperaturas), 0.0);
+    for (int k = 1; k < temperaturas; k++) beta[k] = std::pow(double(k) / (temperaturas - 1), 4.0);
+    return beta;
+}
+
+// Momentos de a * x a partir de los de x
+inline Momentos escalar(Momentos m, double a) {
+    m.media *= a;
+    m.compensacion_media *= a;
+    m.m2 *= a * a;
+    m.compensacion_m2 *= a * a;
+    return m;
+}
+
+// Autocovarianzas de una serie para los retardos 0..RETARDOS_AUTOCORRELACION,
+// acumuladas en línea con los últimos valores en un búfer circular. Los
+// valores se centran en el primero: cerca de beta = 0, w es casi constante y
+// sum x_t x_{t-l} / n - media^2 perdería todas sus cifras.
+class Autocorrelacion {
+public:
+    static constexpr int L = RETARDOS_AUTOCORRELACION;
+
+    void agregar(double x) {
+        if (n == 0) referencia = x;
+        x -= referencia;
+        const int posicion = int(n % L);
+        const int retardos = n < L ? int(n) : L;
+        // historia[posicion - l] es el valor de hace l pasos
+        for (int l = 1; l <= std::min(retardos, posicion); l++) productos[l] += x * historia[posicion - l];
+        for (int l = posicion + 1; l <= retardos; l++) productos[l] += x * historia[posicion - l + L];
+        productos[0] += x * x;
+        suma += x;
+        historia[posicion] = x;
+        n++;
+    }
+
+    // Multiplica toda la serie por a
+    void escalar(double a) {
+        for (double& h : historia) h *= a;
+        for (double& s : productos) s *= a * a;
+        suma *= a;
+        referencia *= a;
+    }
+
+    // Suma a rho[l] la autocorrelación de retardo l (cero si la serie es constante)
+    void sumar_autocorrelaciones(double* rho) const {
+        if (n <= L) return;
+        const double media = suma / double(n);
+        const double varianza = productos[0] / double(n) - media * media;
+        if (!(varianza > 0.0)) return;
+        for (int l = 0; l <= L; l++) rho[l] += (productos[l] / double(n - l) - media * media) / varianza;
+    }
+
+private:
+    long long n = 0;
+    double referencia = 0.0;
+    double suma = 0.0;
+    double historia[L] = {};
+    double productos[L + 1] = {};
+};
+
+// Estadísticas de una temperatura en una escalera, o sumadas sobre escaleras.
+// Son datos planos: con MPI viajan como bytes.
+struct EstadisticaTemperatura {
+    // log f de las muestras con f > 0 (integración termodinámica) y las demás
+    Momentos log_f;
+    long long ceros = 0;
+    long long negativos = 0;
+
+    // w = exp((beta_{k+1} - beta_k) log f - desplazamiento), el cociente al
+    // peldaño siguiente. El desplazamiento (el mayor exponente visto) evita
+    // desbordes; los momentos de escaleras con otro desplazamiento se
+    // re-escalan al combinarlos.
+    Momentos peso;
+    double desplazamiento = -std::numeric_limits<double>::infinity();
+
+    // Metropolis e intercambios con la temperatura siguiente
+    long long propuestas = 0, aceptadas = 0;
+    long long intentos_intercambio = 0, intercambios = 0;
+
+    // Suma sobre cadenas de la autocorrelación de w para cada retardo
+    double autocorrelacion[RETARDOS_AUTOCORRELACION + 1] = {};
+    long long cadenas = 0;
+
+    // Media de w con el desplazamiento d (>= el propio)
+    double peso_medio(double d) const {
+        return peso.n == 0 ? 0.0 : peso.promedio() * std::exp(desplazamiento - d);
+    }
+
+    // Lleva los pesos a un desplazamiento mayor
+    void desplazar(double nuevo) {
+        if (!(nuevo > desplazamiento)) return;
+        peso = escalar(peso, std::exp(desplazamiento - nuevo));
+        desplazamiento = nuevo;
+    }
+
+    EstadisticaTemperatura& operator+=(EstadisticaTemperatura otra) {
+        log_f += otra.log_f;
+        ceros += otra.ceros;
+        negativos += otra.negativos;
+
+        desplazar(otra.desplazamiento);
+        otra.desplazar(desplazamiento);
+        peso += otra.peso;
+
+        propuestas += otra.propuestas;
+        aceptadas += otra.aceptadas;
+        intentos_intercambio += otra.intentos_intercambio;
+        intercambios += otra.intercambios;
+        for (int l = 0; l <= RETARDOS_AUTOCORRELACION; l++) autocorrelacion[l] += otra.autocorrelacion[l];
+        cadenas += otra.cadenas;
+        return *this;
+    }
+
+    // Tiempo de autocorrelación integrado de w, promediando la autocorrelación
+    // de las cadenas, con la secuencia inicial positiva de Geyer: se suman los
+    // pares rho_{2m} + rho_{2m+1} mientras son positivos. Si no se cortan antes
+    // del último retardo, truncado indica que tau es solo una cota inferior.
+    double tiempo_autocorrelacion(bool& truncado) const {
+        truncado = false;
+        if (cadenas == 0) return 1.0;
+        double tau = -1.0;
+        for (int m = 0; 2 * m + 1 <= RETARDOS_AUTOCORRELACION; m++) {
+            const double par = (autocorrelacion[2 * m] + autocorrelacion[2 * m + 1]) / double(cadenas);
+            if (!(par > 0.0)) return std::max(tau, 1.0);
+            tau += 2.0 * par;
+        }
+        truncado = true;
+        return std::max(tau, 1.0);
+    }
+};
+
+// Reflexión de y en [0, ancho]: mantiene la propuesta simétrica en los bordes
+inline double reflejar(double y, double ancho) {
+    const double periodo = 2.0 * ancho;
+    y = std::fmod(y, periodo);
+    if (y < 0.0) y += periodo;
+    return y > ancho ? periodo - y : y;
+}
+
+// Una escalera de T cadenas en cada uno de los CADENAS_POR_GRUPO carriles,
+// durante pasos pasos (los primeros calentamiento no se registran y adaptan
+// el paso de cada temperatura). Las estadísticas de la escalera c y la
+// temperatura t van a estadisticas[c * T + t].
+template <int DIM, class Flujo, class F>
+void templar_grupo(const F& func, const Dominio& dominio, const std::vector<double>& beta, long long pasos,
+                   long long calentamiento, std::uint64_t seed, EstadisticaTemperatura* estadisticas) {
+    const std::size_t T = beta.size();
+    const std::size_t C = CADENAS_POR_GRUPO;
+    const std::size_t m = T * C;  // la cadena i = t * C + c: temperatura t, escalera c
+    const std::size_t d = std::size_t(dominio.dimensiones);
+    const double lim_inf = dominio.lim_inf;
+    const double ancho = dominio.ancho();
+    constexpr double MENOS_INFINITO = -std::numeric_limits<double>::infinity();
+
+    Flujo flujo(seed, 1);
+    std::vector<double> x(m * d), propuesta(m * d), sorteos(m * (d + 2));
+    std::vector<double> valores(m), log_f(m), log_propuesta(m);
+    std::vector<double> lote(m > TAMANO_LOTE ? d * TAMANO_LOTE : 0);
+    std::vector<char> aceptada(m);
+    std::vector<Autocorrelacion> series((T - 1) * C);
+
+    // Semiancho del paso por temperatura, como fracción del ancho del dominio
+    std::vector<double> paso(T, 0.5);
+    std::vector<long long> aceptadas_ventana(T, 0);
+
+    // f en las m cadenas; con más de TAMANO_LOTE, el máximo de evaluar_lote,
+    // cada tramo de cadenas se copia a un lote SoA propio
+    auto evaluar = [&](const double* soa) {
+        if (m <= TAMANO_LOTE) {
+            evaluar_soa<DIM>(func, soa, m, d, valores.data());
+            return;
+        }
+        for (std::size_t inicio = 0; inicio < m; inicio += TAMANO_LOTE) {
+            const std::size_t n = std::min(TAMANO_LOTE, m - inicio);
+            for (std::size_t k = 0; k < d; k++) {
+                std::copy(soa + k * m + inicio, soa + k * m + inicio + n, lote.data() + k * n);
+            }
+            evaluar_soa<DIM>(func, lote.data(), n, d, valores.data() + inicio);
+        }
+    };
+
+    // log f, contando los valores negativos (se tratan como f = 0)
+    auto logaritmos = [&](double* destino) {
+        for (std::size_t i = 0; i < m; i++) {
+            if (valores[i] < 0.0) estadisticas[(i % C) * T + i / C].negativos++;
+            destino[i] = valores[i] > 0.0 ? std::log(valores[i]) : MENOS_INFINITO;
+        }
+    };
+
+    // Estado inicial: puntos uniformes, la distribución exacta para beta = 0
+    flujo.llenar(x.data(), m * d);
+    for (std::size_t j = 0; j < m * d; j++) x[j] = lim_inf + ancho * x[j];
+    evaluar(x.data());
+    logaritmos(log_f.data());
+
+    for (long long s = 0; s < pasos; s++) {
+        const bool registrar = s >= calentamiento;
+        flujo.llenar(sorteos.data(), sorteos.size());
+        const double* u_paso = sorteos.data();
+        const double* u_aceptar = u_paso + m * d;
+        const double* u_intercambio = u_aceptar + m;
+
+        // Paseo aleatorio uniforme en [-h, h]^d, reflejado en los bordes
+        for (std::size_t k = 0; k < d; k++) {
+            for (std::size_t t = 0; t < T; t++) {
+                const double h = paso[t] * ancho;
+                for (std::size_t c = 0; c < C; c++) {
+                    const std::size_t j = k * m + t * C + c;
+                    propuesta[j] = lim_inf + reflejar(x[j] - lim_inf + h * (2.0 * u_paso[j] - 1.0), ancho);
+                }
+            }
+        }
+        evaluar(propuesta.data());
+        logaritmos(log_propuesta.data());
+
+        // Metropolis: se acepta con probabilidad min(1, (f'/f)^beta)
+        for (std::size_t i = 0; i < m; i++) {
+            const double b = beta[i / C];
+            bool acepta;
+            if (b == 0.0) acepta = true;
+            else if (log_propuesta[i] == MENOS_INFINITO) acepta = false;
+            else if (log_f[i] == MENOS_INFINITO) acepta = true;
+            else acepta = std::log(u_aceptar[i]) < b * (log_propuesta[i] - log_f[i]);
+            aceptada[i] = acepta;
+            if (acepta) log_f[i] = log_propuesta[i];
+        }
+        for (std::size_t k = 0; k < d; k++) {
+            double* xk = x.data() + k * m;
+            const double* pk = propuesta.data() + k * m;
+            for (std::size_t i = 0; i < m; i++) xk[i] = aceptada[i] ? pk[i] : xk[i];
+        }
+        for (std::size_t i = 0; i < m; i++) {
+            aceptadas_ventana[i / C] += aceptada[i];
+            if (registrar) {
+                estadisticas[(i % C) * T + i / C].propuestas++;
+                estadisticas[(i % C) * T + i / C].aceptadas += aceptada[i];
+            }
+        }
+
+        // Intercambio entre t y t + 1 (pares y nones en pasos alternos): se
+        // acepta con probabilidad min(1, (f_t / f_{t+1})^(beta_{t+1} - beta_t))
+        for (std::size_t t = std::size_t(s & 1); t + 1 < T; t += 2) {
+            for (std::size_t c = 0; c < C; c++) {
+                const std::size_t i = t * C + c, j = i + C;
+                const double log_a =
+                    log_f[i] == log_f[j] ? 0.0 : (beta[t + 1] - beta[t]) * (log_f[i] - log_f[j]);
+                const bool intercambia = std::log(u_intercambio[i]) < log_a;
+                if (registrar) {
+                    estadisticas[c * T + t].intentos_intercambio++;
+                    estadisticas[c * T + t].intercambios += intercambia;
+                }
+                if (!intercambia) continue;
+                std::swap(log_f[i], log_f[j]);
+                for (std::size_t k = 0; k < d; k++) std::swap(x[k * m + i], x[k * m + j]);
+            }
+        }
+
+        // Calentamiento: cada PASOS_ADAPTACION pasos, el paso de cada
+        // temperatura se acerca a la aceptación objetivo. Después queda fijo
+        // y la cadena conserva pi_k exactamente.
+        if (!registrar) {
+            if ((s + 1) % PASOS_ADAPTACION == 0) {
+                for (std::size_t t = 0; t < T; t++) {
+                    const double tasa = double(aceptadas_ventana[t]) / double(PASOS_ADAPTACION * C);
+                    paso[t] = std::min(1.0, std::max(1e-9, paso[t] * std::exp(2.0 * (tasa - ACEPTACION_OBJETIVO))));
+                    aceptadas_ventana[t] = 0;
+                }
+            }
+            continue;
+        }
+
+        for (std::size_t t = 0; t < T; t++) {
+            for (std::size_t c = 0; c < C; c++) {
+                EstadisticaTemperatura& e = estadisticas[c * T + t];
+                const double lf = log_f[t * C + c];
+                if (lf == MENOS_INFINITO) e.ceros++;
+                else e.log_f.agregar(lf);
+                if (t + 1 == T) continue;
+
+                // Un exponente mayor que el desplazamiento re-escala lo acumulado
+                const double exponente = (beta[t + 1] - beta[t]) * lf;
+                if (exponente > e.desplazamiento) {
+                    series[t * C + c].escalar(std::exp(e.desplazamiento - exponente));
+                    e.desplazar(exponente);
+                }
+                const double w = lf == MENOS_INFINITO ? 0.0 : std::exp(exponente - e.desplazamiento);
+                e.peso.agregar(w);
+                series[t * C + c].agregar(w);
+            }
+        }
+    }
+
+    for (std::size_t t = 0; t + 1 < T; t++) {
+        for (std::size_t c = 0; c < C; c++) {
+            series[t * C + c].sumar_autocorrelaciones(estadisticas[c * T + t].autocorrelacion);
+            estadisticas[c * T + t].cadenas = 1;
+        }
+    }
+}
+
+// Estadísticas de la corrida y su estimación
+struct ResultadoTemplado {
+    Resultado resultado;
+    std::vector<double> beta;
+    std::vector<EstadisticaTemperatura> temperaturas;
+    long long cadenas = 0;        // escaleras
+    long long pasos = 0;
+    long long calentamiento = 0;
+
+    // Por peldaño: log(Z(beta_{k+1}) / Z(beta_k)), su error con tau, el
+    // tiempo de autocorrelación de w y el tamaño efectivo de la muestra
+    std::vector<double> log_cociente, error_log_cociente, tau, muestras_efectivas;
+    std::vector<char> tau_truncado;
+
+    // Integración termodinámica (NaN si f se anula en alguna muestra)
+    double integral_termodinamica = 0.0;
+};
+
+// Escaleras y pasos que caben en p.N evaluaciones
+inline long long grupos_templado(const Parametros& p) {
+    return (p.cadenas + CADENAS_POR_GRUPO - 1) / CADENAS_POR_GRUPO;
+}
+
+inline long long pasos_templado(const Parametros& p) {
+    return p.N / (grupos_templado(p) * CADENAS_POR_GRUPO * p.temperaturas) - 1;
+}
+
+// Estadísticas por escalera y temperatura de los grupos [grupos.inicio,
+// grupos.fin): la escalera e (desde la primera del tramo) y la temperatura t
+// en e * T + t
+template <class F>
+std::vector<EstadisticaTemperatura> templar(const F& func, const Dominio& dominio, Rango grupos,
+                                            const Parametros& p) {
+    const std::vector<double> beta = escalera_temperaturas(p.temperaturas);
+    const std::size_t T = beta.size();
+    const long long pasos = pasos_templado(p);
+    const long long calentamiento = pasos / FRACCION_CALENTAMIENTO;
+    if (pasos < FRACCION_CALENTAMIENTO * PASOS_ADAPTACION * 4) {
+        std::cerr << "--tempering: --n alcanza para " << pasos << " pasos por cadena; hacen falta al menos "
+                  << FRACCION_CALENTAMIENTO * PASOS_ADAPTACION * 4 << std::endl;
+        exit(1);
+    }
+
+    const std::size_t por_grupo = CADENAS_POR_GRUPO * T;
+    std::vector<EstadisticaTemperatura> escaleras(std::size_t(grupos.tamano()) * por_grupo);
+    despachar_motor(p.motor, [&](auto tipo) {
+        using Flujo = typename decltype(tipo)::type;
+        return despachar_evaluacion<F>(dominio.dimensiones, [&](auto D) {
+            constexpr int DIM = decltype(D)::value;
+
+            MONTECARLO_OMP(parallel)
+            {
+                fijar_hilo();
+                MONTECARLO_OMP(for schedule(dynamic))
+                for (long long g = grupos.inicio; g < grupos.fin; g++) {
+                    TramoInstrumentado tramo(Fase::BLOQUE, (pasos + 1) * (long long)por_grupo);
+                    templar_grupo<DIM, Flujo>(func, dominio, beta, pasos, calentamiento, derivar_semilla(p.seed, g),
+                                              &escaleras[std::size_t(g - grupos.inicio) * por_grupo]);
+                }
+            }
+            return 0;
+        });
+    });
+
+    return escaleras;
+}
+
+// Integral por el producto de cocientes de las medias de w sobre todas las
+// escaleras. Su error es el jackknife de log I quitando una escalera a la vez;
+// el error de cada cociente con tau, var(media de w) = var(w) tau / n, queda
+// como diagnóstico.
+inline ResultadoTemplado estimar_templado(const std::vector<EstadisticaTemperatura>& escaleras,
+                                          const Parametros& p, double volumen) {
+    ResultadoTemplado r;
+    r.beta = escalera_temperaturas(p.temperaturas);
+    r.cadenas = grupos_templado(p) * CADENAS_POR_GRUPO;
+    r.pasos = pasos_templado(p);
+    r.calentamiento = r.pasos / FRACCION_CALENTAMIENTO;
+
+    const std::size_t T = r.beta.size();
+    const std::size_t E = escaleras.size() / T;
+    r.temperaturas.assign(T, EstadisticaTemperatura());
+    for (std::size_t e = 0; e < E; e++) {
+        for (std::size_t t = 0; t < T; t++) r.temperaturas[t] += escaleras[e * T + t];
+    }
+
+    double log_integral = std::log(volumen), varianza_log = 0.0;
+    for (std::size_t t = 0; t + 1 < T; t++) {
+        const EstadisticaTemperatura& e = r.temperaturas[t];
+        bool truncado;
+        const double tau = e.tiempo_autocorrelacion(truncado);
+        const double media = e.peso.promedio();
+        const double n = double(e.peso.n);
+        const double error = media > 0.0 ? std::sqrt(e.peso.varianza() * tau / n) / media : HUGE_VAL;
+        r.log_cociente.push_back(std::log(media) + e.desplazamiento);
+        r.error_log_cociente.push_back(error);
+        r.tau.push_back(tau);
+        r.tau_truncado.push_back(truncado);
+        r.muestras_efectivas.push_back(n / tau);
+        log_integral += r.log_cociente.back();
+        varianza_log += error * error;
+    }
+
+    // Jackknife: sin la escalera e, la suma de w del peldaño t pierde
+    // n_e * media_e (con el desplazamiento común) y n pierde n_e
+    if (E > 1) {
+        Momentos sin_una;
+        for (std::size_t e = 0; e < E; e++) {
+            double log_parcial = std::log(volumen);
+            for (std::size_t t = 0; t + 1 < T; t++) {
+                const EstadisticaTemperatura& total = r.temperaturas[t];
+                const EstadisticaTemperatura& propia = escaleras[e * T + t];
+                const double suma = double(total.peso.n) * total.peso.promedio() -
+                                    double(propia.peso.n) * propia.peso_medio(total.desplazamiento);
+                log_parcial += std::log(suma / double(total.peso.n - propia.peso.n)) + total.desplazamiento;
+            }
+            sin_una.agregar(log_parcial);
+        }
+        varianza_log = double(E - 1) * sin_una.varianza();
+    }
+
+    r.resultado.integral = std::exp(log_integral);
+    r.resultado.error = r.resultado.integral * std::sqrt(varianza_log);
+    r.resultado.muestras = r.cadenas * p.temperaturas * (r.pasos + 1);
+
+    // Trapecios de E_beta[log f]
+    double area = 0.0;
+    bool anulada = false;
+    for (std::size_t t = 0; t + 1 < T; t++) {
+        area += 0.5 * (r.beta[t + 1] - r.beta[t]) *
+                (r.temperaturas[t].log_f.promedio() + r.temperaturas[t + 1].log_f.promedio());
+    }
+    for (const EstadisticaTemperatura& e : r.temperaturas) anulada = anulada || e.ceros > 0;
+    r.integral_termodinamica = anulada ? std::nan("") : volumen * std::exp(area);
+    return r;
+}
+
+// Templado paralelo con memoria compartida: todos los grupos en este proceso
+template <class F>
+ResultadoTemplado templado(const F& func, const Dominio& dominio, const Parametros& p) {
+    return estimar_templado(templar(func, dominio, {0, grupos_templado(p)}, p), p, dominio.volumen());
+}
+
+} // namespace montecarlo
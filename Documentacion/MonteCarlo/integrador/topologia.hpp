@@ -0,0 +1,287 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "openmp.hpp"
+
+namespace montecarlo {
+
+// Número de hilo y de hilos; sin OpenMP el programa corre con un único hilo
+inline int numero_hilo() {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+inline int numero_hilos() {
+#ifdef _OPENMP
+    return omp_get_num_threads();
+#else
+    return 1;
+#endif
+}
+
+// Hilos que tendrá la próxima región paralela
+inline int hilos_disponibles() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+// Ubicación de los hilos (--pin). NINGUNA deja la del sistema (o la de
+// OMP_PROC_BIND / OMP_PLACES). CERCANA llena un socket antes de pasar al
+// siguiente, con los núcleos físicos antes que sus hermanos SMT. DISPERSA
+// reparte los hilos entre los sockets por turnos.
+enum class Afinidad { NINGUNA, CERCANA, DISPERSA };
+
+inline bool leer_afinidad(const char* texto, Afinidad& afinidad) {
+    if (std::strcmp(texto, "none") == 0) afinidad = Afinidad::NINGUNA;
+    else if (std::strcmp(texto, "close") == 0) afinidad = Afinidad::CERCANA;
+    else if (std::strcmp(texto, "spread") == 0) afinidad = Afinidad::DISPERSA;
+    else return false;
+    return true;
+}
+
+inline const char* nombre(Afinidad afinidad) {
+    switch (afinidad) {
+        case Afinidad::CERCANA: return "close";
+        case Afinidad::DISPERSA: return "spread";
+        default: return "none";
+    }
+}
+
+// CPU lógica del proceso y su ubicación en la máquina
+struct CpuLogica {
+    int cpu = 0;
+    int socket = 0;
+    int nodo = 0;     // nodo NUMA
+    int nucleo = 0;   // core_id dentro del socket
+    int hermano = 0;  // 0 para el primer hilo SMT del núcleo, 1 para el segundo, ...
+};
+
+struct Topologia {
+    std::vector<CpuLogica> cpus;  // las que el proceso puede usar, en orden de CPU
+    int sockets = 1;
+    int nodos = 1;
+};
+
+// Lista de CPUs o de nodos de /sys ("0-3,8-11")
+inline std::vector<int> leer_lista_cpus(const std::string& texto) {
+    std::vector<int> lista;
+    std::stringstream campos(texto);
+    std::string campo;
+    while (std::getline(campos, campo, ',')) {
+        std::size_t guion = campo.find('-');
+        int desde = atoi(campo.c_str());
+        int hasta = guion == std::string::npos ? desde : atoi(campo.c_str() + guion + 1);
+        for (int i = desde; i <= hasta; i++) lista.push_back(i);
+    }
+    return lista;
+}
+
+inline int leer_entero_sysfs(const std::string& ruta, int defecto) {
+    std::ifstream archivo(ruta);
+    int valor;
+    return archivo >> valor ? valor : defecto;
+}
+
+// Topología leída de /sys (Linux). Solo cuenta las CPUs permitidas al proceso,
+// así que respeta el binding de mpirun (--bind-to socket, --map-by ...). Sin
+// /sys, la máquina es un solo socket con un solo nodo.
+inline Topologia detectar_topologia() {
+    Topologia t;
+#ifdef __linux__
+    cpu_set_t permitidas;
+    CPU_ZERO(&permitidas);
+    if (sched_getaffinity(0, sizeof(permitidas), &permitidas) == 0) {
+        std::vector<int> nodo_de(CPU_SETSIZE, 0);
+        std::ifstream en_linea("/sys/devices/system/node/online");
+        std::string nodos;
+        if (en_linea >> nodos) {
+            for (int nodo : leer_lista_cpus(nodos)) {
+                std::ifstream archivo("/sys/devices/system/node/node" + std::to_string(nodo) + "/cpulist");
+                std::string cpus;
+                if (!(archivo >> cpus)) continue;
+                for (int cpu : leer_lista_cpus(cpus)) {
+                    if (cpu >= 0 && cpu < CPU_SETSIZE) nodo_de[cpu] = nodo;
+                }
+            }
+        }
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (!CPU_ISSET(cpu, &permitidas)) continue;
+            const std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+            CpuLogica c;
+            c.cpu = cpu;
+            c.socket = leer_entero_sysfs(base + "physical_package_id", 0);
+            c.nodo = nodo_de[cpu];
+            c.nucleo = leer_entero_sysfs(base + "core_id", cpu);
+            t.cpus.push_back(c);
+        }
+    }
+#endif
+    if (t.cpus.empty()) t.cpus.push_back(CpuLogica{});
+
+    std::set<int> sockets, nodos;
+    for (CpuLogica& c : t.cpus) {
+        for (const CpuLogica& otra : t.cpus) {
+            if (otra.cpu < c.cpu && otra.socket == c.socket && otra.nucleo == c.nucleo) c.hermano++;
+        }
+        sockets.insert(c.socket);
+        nodos.insert(c.nodo);
+    }
+    t.sockets = int(sockets.size());
+    t.nodos = int(nodos.size());
+    return t;
+}
+
+// Se detecta una vez, antes de fijar ningún hilo (leer_parametros la consulta)
+inline const Topologia& topologia() {
+    static const Topologia t = detectar_topologia();
+    return t;
+}
+
+// CPUs en el orden en que se asignan a los hilos 0, 1, 2, ...
+inline std::vector<CpuLogica> orden_afinidad(const Topologia& t, Afinidad afinidad) {
+    std::vector<CpuLogica> orden = t.cpus;
+    std::stable_sort(orden.begin(), orden.end(), [](const CpuLogica& a, const CpuLogica& b) {
+        if (a.socket != b.socket) return a.socket < b.socket;
+        if (a.hermano != b.hermano) return a.hermano < b.hermano;
+        if (a.nodo != b.nodo) return a.nodo < b.nodo;
+        return a.nucleo < b.nucleo;
+    });
+    if (afinidad != Afinidad::DISPERSA) return orden;
+
+    // Por turnos entre sockets, cada uno en el orden anterior
+    std::vector<std::vector<CpuLogica>> por_socket;
+    for (const CpuLogica& c : orden) {
+        if (por_socket.empty() || por_socket.back()[0].socket != c.socket) por_socket.emplace_back();
+        por_socket.back().push_back(c);
+    }
+    std::vector<CpuLogica> turnos;
+    for (std::size_t i = 0; turnos.size() < orden.size(); i++) {
+        for (const std::vector<CpuLogica>& socket : por_socket) {
+            if (i < socket.size()) turnos.push_back(socket[i]);
+        }
+    }
+    return turnos;
+}
+
+// Afinidad de todos los equipos de hilos del proceso
+inline Afinidad afinidad_hilos = Afinidad::NINGUNA;
+
+// CPU del hilo h con afinidad_hilos (con más hilos que CPUs, se repiten)
+inline const CpuLogica& cpu_de_hilo(int hilo) {
+    static const std::vector<CpuLogica> cercana = orden_afinidad(topologia(), Afinidad::CERCANA);
+    static const std::vector<CpuLogica> dispersa = orden_afinidad(topologia(), Afinidad::DISPERSA);
+    const std::vector<CpuLogica>& orden = afinidad_hilos == Afinidad::DISPERSA ? dispersa : cercana;
+    return orden[std::size_t(hilo) % orden.size()];
+}
+
+// Fija el hilo actual a su CPU. Se llama al entrar en cada región paralela,
+// antes de crear el estado del hilo (flujo y buffers del lote): así el primer
+// toque de esas páginas cae en el nodo NUMA del hilo. Los hilos de OpenMP se
+// reutilizan entre regiones, y solo se llama al sistema si el hilo cambia de CPU.
+inline void fijar_hilo() {
+    if (afinidad_hilos == Afinidad::NINGUNA) return;
+#ifdef __linux__
+    thread_local int fijado = -1;
+    const int cpu = cpu_de_hilo(numero_hilo()).cpu;
+    if (cpu == fijado) return;
+    cpu_set_t conjunto;
+    CPU_ZERO(&conjunto);
+    CPU_SET(cpu, &conjunto);
+    if (sched_setaffinity(0, sizeof(conjunto), &conjunto) == 0) fijado = cpu;
+#endif
+}
+
+// Socket en el que corre el hilo actual
+inline int socket_hilo() {
+    if (afinidad_hilos != Afinidad::NINGUNA) return cpu_de_hilo(numero_hilo()).socket;
+#ifdef __linux__
+    const int cpu = sched_getcpu();
+    for (const CpuLogica& c : topologia().cpus) {
+        if (c.cpu == cpu) return c.socket;
+    }
+#endif
+    return 0;
+}
+
+// Sockets que ocupan los primeros h hilos con afinidad_hilos (0 sin --pin:
+// el sistema decide dónde corren)
+inline int sockets_ocupados(int hilos) {
+    if (afinidad_hilos == Afinidad::NINGUNA) return 0;
+    std::set<int> sockets;
+    for (int h = 0; h < hilos; h++) sockets.insert(cpu_de_hilo(h).socket);
+    return int(sockets.size());
+}
+
+// Valor alineado a línea de caché: en un arreglo indexado por hilo, cada hilo
+// escribe en su propia línea y no invalida la de sus vecinos
+template <class T>
+struct alignas(64) Alineado {
+    T valor{};
+};
+
+// Reducción en dos niveles dentro de una región paralela: el primer hilo de
+// cada socket combina, en orden de hilo, los parciales de su socket (lecturas
+// dentro del socket) y después el hilo 0 combina los totales de socket. Entre
+// procesos sigue la MPI_Reduce de reducir. Con el mismo número de hilos y la
+// misma afinidad, el orden de combinación es siempre el mismo.
+template <class T>
+class ReduccionPorSocket {
+public:
+    explicit ReduccionPorSocket(int hilos) : parciales(hilos), sockets(hilos) {}
+
+    // Para parciales sin constructor por defecto (p. ej. con tamaño dado por d)
+    ReduccionPorSocket(int hilos, const T& cero) : parciales(hilos, Alineado<T>{cero}), sockets(hilos) {}
+
+    // La llaman todos los hilos del equipo con su parcial; el total se suma a
+    // total (en el hilo 0) y es visible tras la barrera que cierra la región
+    void reducir(const T& local, T& total) {
+        const int hilo = numero_hilo();
+        const int hilos = numero_hilos();
+        parciales[hilo].valor = local;
+        sockets[hilo].valor = socket_hilo();
+        MONTECARLO_OMP(barrier)
+
+        if (primero_de_socket(hilo)) {
+            for (int h = hilo + 1; h < hilos; h++) {
+                if (sockets[h].valor == sockets[hilo].valor) parciales[hilo].valor += parciales[h].valor;
+            }
+        }
+        MONTECARLO_OMP(barrier)
+
+        if (hilo == 0) {
+            for (int h = 0; h < hilos; h++) {
+                if (primero_de_socket(h)) total += parciales[h].valor;
+            }
+        }
+    }
+
+private:
+    bool primero_de_socket(int hilo) const {
+        for (int h = 0; h < hilo; h++) {
+            if (sockets[h].valor == sockets[hilo].valor) return false;
+        }
+        return true;
+    }
+
+    std::vector<Alineado<T>> parciales;
+    std::vector<Alineado<int>> sockets;
+};
+
+} // namespace montecarlo
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <cstdio>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "expresion.hpp"
+#include "integrando.hpp"
+#include "lotes.hpp"
+#include "momentos.hpp"
+#include "nucleo.hpp"
+#include "openmp.hpp"
+#include "philox.hpp"
+#include "topologia.hpp"
+
+namespace montecarlo {
+
+// Expresiones ya compiladas por el servidor, por texto y dimensión: un archivo
+// con miles de trabajos del mismo integrando lo compila una sola vez. Si no
+// compila, queda el motivo para rechazar los trabajos que la piden.
+struct ExpresionCompilada {
+    Expresion expresion;
+    std::string error;
+};
+
+using ExpresionesCompiladas = std::map<std::pair<std::string, int>, ExpresionCompilada>;
+
+// Un registro del archivo de trabajos: "integrando li ls d n [seed]", donde el
+// integrando es gaussiana o una expresión entre comillas, "x1*exp(-sum(x_i^2))"
+struct Trabajo {
+    long long linea = 0;
+    std::string integrando = "gaussiana";
+    const Expresion* expresion = nullptr;  // nula para la gaussiana
+    double lim_inf = 0.0;
+    double lim_sup = 1.0;
+    int dimensiones = 0;
+    long long N = 0;
+    unsigned long long seed = 12345;
+
+    // Motivo del rechazo si el registro es inválido
+    std::string error;
+};
+
+inline Trabajo leer_trabajo(const std::string& texto, long long linea, ExpresionesCompiladas& compiladas) {
+    Trabajo t;
+    t.linea = linea;
+
+    // El integrando: la primera palabra o el texto entre comillas
+    std::istringstream campos(texto);
+    bool comillas = false;
+    std::size_t inicio = texto.find_first_not_of(" \t");
+    if (inicio != std::string::npos && texto[inicio] == '"') {
+        std::size_t cierre = texto.find('"', inicio + 1);
+        if (cierre == std::string::npos) {
+            t.error = "falta cerrar las comillas de la expresión";
+            return t;
+        }
+        t.integrando = texto.substr(inicio + 1, cierre - inicio - 1);
+        campos.str(texto.substr(cierre + 1));
+        comillas = true;
+    } else {
+        campos >> t.integrando;
+    }
+    if (!(campos >> t.lim_inf >> t.lim_sup >> t.dimensiones >> t.N)) {
+        t.error = "se esperaba: integrando li ls d n [seed]";
+        return t;
+    }
+    unsigned long long seed;
+    if (campos >> seed) t.seed = seed;
+
+    std::string sobrante;
+    if (!comillas && t.integrando != "gaussiana") {
+        t.error = "integrando desconocido: " + t.integrando + " (las expresiones van entre comillas)";
+    } else if (t.dimensiones <= 0 || t.N <= 0) {
+        t.error = "d y n deben ser positivos";
+    } else if (t.dimensiones > DIMENSION_MAXIMA) {
+        t.error = "d admite hasta " + std::to_string(DIMENSION_MAXIMA) + " dimensiones";
+    } else if (campos >> sobrante) {
+        t.error = "campos de más: " + sobrante;
+    } else if (comillas) {
+        auto clave = std::make_pair(t.integrando, t.dimensiones);
+        auto it = compiladas.find(clave);
+        if (it == compiladas.end()) {
+            it = compiladas.emplace(clave, ExpresionCompilada{}).first;
+            compilar_expresion(t.integrando, t.dimensiones, it->second.expresion, it->second.error);
+        }
+        if (!it->second.error.empty()) t.error = "expresión: " + it->second.error;
+        else t.expresion = &it->second.expresion;
+    }
+    return t;
+}
+
+// Trabajos leídos por ronda del servidor
+constexpr std::size_t TRABAJOS_POR_RONDA = 4096;
+
+// Muestras [rango) de un trabajo, siempre dentro de un único bloque
+struct Pieza {
+    std::size_t trabajo;
+    Rango rango;
+};
+
+// Divide cada trabajo en piezas alineadas a TAMANO_BLOQUE y las agrupa en
+// unidades de planificación: las piezas de trabajos pequeños se empaquetan
+// hasta completar un bloque de muestras, y los trabajos grandes aportan una
+// unidad por bloque. unidades[u] .. unidades[u + 1] son las piezas de la unidad u.
+inline void planificar(const std::vector<Trabajo>& trabajos, std::vector<Pieza>& piezas,
+                       std::vector<std::size_t>& unidades) {
+    piezas.clear();
+    unidades.assign(1, 0);
+    long long en_unidad = 0;
+    for (std::size_t j = 0; j < trabajos.size(); j++) {
+        const Trabajo& t = trabajos[j];
+        if (!t.error.empty()) continue;
+        for (long long inicio = 0; inicio < t.N; inicio += TAMANO_BLOQUE) {
+            long long fin = inicio + TAMANO_BLOQUE < t.N ? inicio + TAMANO_BLOQUE : t.N;
+            piezas.push_back({j, {inicio, fin}});
+            en_unidad += fin - inicio;
+            if (en_unidad >= TAMANO_BLOQUE) {
+                unidades.push_back(piezas.size());
+                en_unidad = 0;
+            }
+        }
+    }
+    if (unidades.back() != piezas.size()) unidades.push_back(piezas.size());
+}
+
+// Integra una pieza en el hilo actual, con el mismo flujo Philox indexado que
+// integrar: el resultado del trabajo es el mismo que el del ejecutable con
+// --seed y --method mc
+inline Momentos integrar_pieza(const Trabajo& t, Rango rango, EspacioLote& espacio) {
+    Dominio dominio{t.lim_inf, t.lim_sup, t.dimensiones};
+    auto muestrear_con = [&](const auto& func) {
+        using F = std::decay_t<decltype(func)>;
+        return despachar_muestreo<F>(t.dimensiones, [&](auto D) {
+            constexpr int DIM = decltype(D)::value;
+            FlujoPhilox flujo(t.seed, t.dimensiones);
+            flujo.saltar_a_muestra(rango.inicio);
+            return muestrear<DIM>(func, dominio, flujo, rango.tamano(), espacio);
+        });
+    };
+    if (t.expresion) return muestrear_con(*t.expresion);
+    return muestrear_con(Gaussiana{});
+}
+
+// Texto como cadena JSON, con comillas y barras escapadas
+inline std::string texto_json(const std::string& texto) {
+    std::string json = "\"";
+    for (char c : texto) {
+        if (c == '"' || c == '\\') json += '\\';
+        json += c;
+    }
+    return json + "\"";
+}
+
+// Número en JSON con todos sus dígitos (null si no es finito)
+inline std::string numero_json(double x) {
+    if (!(x == x) || x - x != 0.0) return "null";
+    char texto[32];
+    std::snprintf(texto, sizeof(texto), "%.17g", x);
+    return texto;
+}
+
+// Una línea JSON por trabajo
+inline void escribir_json(std::ostream& salida, const Trabajo& t, const Resultado& r) {
+    salida << "{\"linea\":" << t.linea;
+    if (!t.error.empty()) {
+        salida << ",\"error\":" << texto_json(t.error) << "}\n";
+        return;
+    }
+    salida << ",\"integrando\":" << texto_json(t.integrando)
+           << ",\"li\":" << numero_json(t.lim_inf) << ",\"ls\":" << numero_json(t.lim_sup)
+           << ",\"d\":" << t.dimensiones << ",\"n\":" << t.N << ",\"seed\":" << t.seed
+           << ",\"integral\":" << numero_json(r.integral) << ",\"error_estimado\":" << numero_json(r.error)
+           << ",\"varianza\":" << numero_json(r.varianza) << "}\n";
+}
+
+// Servidor de trabajos: lee registros de la entrada (uno por línea, '#' inicia
+// un comentario) y escribe un resultado JSON por línea, en el mismo orden.
+// Un único equipo de hilos vive durante toda la ejecución; en cada ronda un
+// hilo lee hasta TRABAJOS_POR_RONDA registros (una línea vacía cierra la ronda
+// antes, útil con entradas interactivas) y todos reparten dinámicamente las
+// unidades. Devuelve el número de trabajos procesados.
+inline long long servir(std::istream& entrada, std::ostream& salida) {
+    std::vector<Trabajo> trabajos;
+    std::vector<Pieza> piezas;
+    std::vector<std::size_t> unidades;
+    std::vector<Momentos> parciales;
+    ExpresionesCompiladas compiladas;
+    int dimension_maxima = 1;
+    long long linea = 0, procesados = 0;
+    bool fin = false;
+
+    // Copia de fin que todos los hilos leen al cerrar la ronda: solo cambia en
+    // el segundo single, y nadie llega al próximo sin pasar por la barrera del
+    // primero, donde fin ya puede haber cambiado para la ronda siguiente
+    bool ultima_ronda = false;
+
+    MONTECARLO_OMP(parallel)
+    {
+        fijar_hilo();
+        while (true) {
+            MONTECARLO_OMP(single)
+            {
+                trabajos.clear();
+                std::string texto;
+                while (trabajos.size() < TRABAJOS_POR_RONDA) {
+                    if (!std::getline(entrada, texto)) {
+                        fin = true;
+                        break;
+                    }
+                    linea++;
+                    std::size_t comentario = texto.find('#');
+                    if (comentario != std::string::npos) texto.erase(comentario);
+                    if (texto.find_first_not_of(" \t\r") == std::string::npos) {
+                        if (texto.empty() && !trabajos.empty()) break;
+                        continue;
+                    }
+                    trabajos.push_back(leer_trabajo(texto, linea, compiladas));
+                }
+
+                planificar(trabajos, piezas, unidades);
+                parciales.assign(piezas.size(), Momentos{});
+                dimension_maxima = 1;
+                for (const Trabajo& t : trabajos) {
+                    if (t.error.empty() && t.dimensiones > dimension_maxima) dimension_maxima = t.dimensiones;
+                }
+            }
+
+            {
+                EspacioLote espacio(dimension_maxima);
+                const long long total_unidades = (long long)unidades.size() - 1;
+
+                MONTECARLO_OMP(for schedule(dynamic))
+                for (long long u = 0; u < total_unidades; u++) {
+                    for (std::size_t k = unidades[u]; k < unidades[u + 1]; k++) {
+                        parciales[k] = integrar_pieza(trabajos[piezas[k].trabajo], piezas[k].rango, espacio);
+                    }
+                }
+            }
+
+            // Combinación en orden de pieza y escritura en orden de entrada
+            MONTECARLO_OMP(single)
+            {
+                std::vector<Momentos> totales(trabajos.size());
+                for (std::size_t k = 0; k < piezas.size(); k++) totales[piezas[k].trabajo] += parciales[k];
+                for (std::size_t j = 0; j < trabajos.size(); j++) {
+                    const Trabajo& t = trabajos[j];
+                    Resultado r;
+                    if (t.error.empty()) {
+                        Dominio dominio{t.lim_inf, t.lim_sup, t.dimensiones};
+                        r = estimar(totales[j], t.N, dominio.volumen());
+                    }
+                    escribir_json(salida, t, r);
+                }
+                salida.flush();
+                procesados += trabajos.size();
+                ultima_ronda = fin;
+            }
+
+            if (ultima_ronda) break;
+        }
+    }
+
+    return procesados;
+}
+
+} // namespace montecarlo
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "expresion.hpp"
+#include "instrumentacion.hpp"
+#include "lotes.hpp"
+#include "momentos.hpp"
+#include "nucleo.hpp"
+#include "openmp.hpp"
+#include "paralelo.hpp"
+#include "parametros.hpp"
+#include "philox.hpp"
+#include "simd.hpp"
+#include "topologia.hpp"
+
+namespace montecarlo {
+
+// Acumula K integrandos sobre n puntos del flujo: cada lote se genera una vez y
+// se evalúa con func.evaluar_lote, que escribe la salida j del punto i en
+// valores[j*m + i]. Los momentos de cada salida usan simd::sumar; los
+// co-momentos del lote, simd::producto sobre las salidas ya centradas en su media.
+template <class F, class Uniforme>
+MomentosVectoriales acumular_vectorial(const F& func, const Dominio& dominio, Uniforme& uniforme, long long n,
+                                       EspacioLote& espacio, std::vector<double>& valores) {
+    const std::size_t d = dominio.dimensiones;
+    const int K = func.salidas();
+
+    MomentosVectoriales momentos(K), lote(K);
+    for (long long hechos = 0; hechos < n; hechos += TAMANO_LOTE) {
+        std::size_t m = n - hechos < (long long)TAMANO_LOTE ? std::size_t(n - hechos) : TAMANO_LOTE;
+        llenar_lote<0>(espacio.soa.data(), m, dominio, uniforme, espacio.sorteos.data());
+        func.evaluar_lote(espacio.soa.data(), m, d, valores.data());
+        for (int j = 0; j < K; j++) {
+            double* fj = valores.data() + std::size_t(j) * m;
+            lote.componentes[j] = simd::sumar(fj, m);
+            if (K > 1) {
+                for (std::size_t i = 0; i < m; i++) fj[i] -= lote.componentes[j].media;
+            }
+        }
+        for (int j = 0; j < K; j++) {
+            for (int l = j + 1; l < K; l++) {
+                lote.comomentos[lote.cruzado(j, l)] =
+                    simd::producto(valores.data() + std::size_t(j) * m, valores.data() + std::size_t(l) * m, m);
+            }
+        }
+        momentos += lote;
+    }
+    return momentos;
+}
+
+// Como integrar<Flujo>, para un integrando de K salidas: mismos bloques, mismo
+// flujo indexado por muestra y misma combinación compensada, así que cada
+// componente usa los mismos puntos que si se integrara sola y el resultado no
+// depende del número de hilos.
+template <class Flujo = FlujoPhilox, class F>
+MomentosVectoriales integrar_vectorial(const F& func, const Dominio& dominio, Rango muestras,
+                                       unsigned long long seed) {
+    MomentosVectoriales total(func.salidas());
+    const long long primero = muestras.inicio / TAMANO_BLOQUE;
+    const long long ultimo = (muestras.fin + TAMANO_BLOQUE - 1) / TAMANO_BLOQUE;
+    ReduccionPorSocket<MomentosVectoriales> reduccion(hilos_disponibles(), total);
+
+    MONTECARLO_OMP(parallel)
+    {
+        fijar_hilo();
+        Flujo flujo(seed, dominio.dimensiones);
+        EspacioLote espacio(dominio.dimensiones);
+        std::vector<double> valores(std::size_t(func.salidas()) * TAMANO_LOTE);
+        MomentosVectoriales local(func.salidas());
+
+        MONTECARLO_OMP(for schedule(dynamic) nowait)
+        for (long long b = primero; b < ultimo; b++) {
+            long long inicio = b * TAMANO_BLOQUE;
+            long long fin = inicio + TAMANO_BLOQUE;
+            if (inicio < muestras.inicio) inicio = muestras.inicio;
+            if (fin > muestras.fin) fin = muestras.fin;
+
+            TramoInstrumentado tramo(Fase::BLOQUE, fin - inicio);
+            flujo.saltar_a_muestra(inicio);
+            local += acumular_vectorial(func, dominio, flujo, fin - inicio, espacio, valores);
+        }
+
+        if (instrumentacion_activa) {
+            TramoInstrumentado espera(Fase::ESPERA);
+            MONTECARLO_OMP(barrier)
+        }
+
+        // Reducción de los parciales: dentro de cada socket y después entre sockets
+        TramoInstrumentado tramo(Fase::REDUCCION);
+        reduccion.reducir(local, total);
+    }
+
+    return total;
+}
+
+// Programa con todas las --expr de p; termina con el motivo si alguna no es válida
+inline Expresion compilar_expresiones(const Parametros& p) {
+    Expresion expresion;
+    std::string error;
+    if (!compilar_expresiones(p.expresiones, p.dimensiones, expresion, error)) {
+        std::cerr << "--expr: " << error << std::endl;
+        exit(1);
+    }
+    return expresion;
+}
+
+// Con la estrategia de muestreo, el motor y la semilla de la línea de comando
+template <class F>
+MomentosVectoriales integrar_vectorial(const F& func, const Dominio& dominio, Rango muestras, const Parametros& p) {
+    return despachar_flujo(p, [&](auto tipo) {
+        using Flujo = typename decltype(tipo)::type;
+        return integrar_vectorial<Flujo>(func, dominio, muestras, p.seed);
+    });
+}
+
+} // namespace montecarlo
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "instrumentacion.hpp"
+#include "lotes.hpp"
+#include "momentos.hpp"
+#include "nucleo.hpp"
+#include "openmp.hpp"
+#include "paralelo.hpp"
+#include "parametros.hpp"
+#include "simd.hpp"
+#include "topologia.hpp"
+
+namespace montecarlo {
+
+// Rejilla adaptativa de VEGAS (Lepage, 1978). En cada dimensión [0, 1) se divide
+// en INTERVALOS intervalos de igual probabilidad y ancho variable: donde el
+// integrando pesa más los intervalos se estrechan y se concentran las muestras.
+class RejillaVegas {
+public:
+    static constexpr int INTERVALOS = 64;
+
+    explicit RejillaVegas(int dimensiones)
+        : d(dimensiones), bordes(std::size_t(dimensiones) * (INTERVALOS + 1)) {
+        for (int k = 0; k < d; k++) {
+            for (int j = 0; j <= INTERVALOS; j++) bordes[k * (INTERVALOS + 1) + j] = double(j) / INTERVALOS;
+        }
+    }
+
+    // Lleva y en [0, 1)^d a x en [0, 1)^d; x[k * paso] recibe la coordenada k.
+    // Guarda el intervalo de cada coordenada y devuelve el jacobiano dx/dy.
+    double transformar(const double* y, double* x, std::size_t paso, int* intervalos) const {
+        double jacobiano = 1.0;
+        for (int k = 0; k < d; k++) {
+            const double* b = bordes.data() + k * (INTERVALOS + 1);
+            double t = y[k] * INTERVALOS;
+            int j = std::min(int(t), INTERVALOS - 1);
+            double ancho = b[j + 1] - b[j];
+            x[k * paso] = b[j] + (t - j) * ancho;
+            jacobiano *= INTERVALOS * ancho;
+            intervalos[k] = j;
+        }
+        return jacobiano;
+    }
+
+    // Redistribuye los bordes para que cada intervalo reciba la misma parte de
+    // sum (f*J)^2. El histograma se suaviza con los vecinos y se comprime con
+    // exponente alfa para que la rejilla no oscile entre iteraciones.
+    void refinar(const std::vector<double>& histograma, double alfa) {
+        constexpr int K = INTERVALOS;
+        for (int k = 0; k < d; k++) {
+            const double* h = histograma.data() + k * K;
+            double* b = bordes.data() + k * (K + 1);
+
+            double suavizado[K];
+            suavizado[0] = (h[0] + h[1]) / 2.0;
+            suavizado[K - 1] = (h[K - 2] + h[K - 1]) / 2.0;
+            for (int j = 1; j < K - 1; j++) suavizado[j] = (h[j - 1] + h[j] + h[j + 1]) / 3.0;
+
+            double total = 0.0;
+            for (int j = 0; j < K; j++) total += suavizado[j];
+            if (!(total > 0.0)) continue;
+
+            double peso[K], total_pesos = 0.0;
+            for (int j = 0; j < K; j++) {
+                double fraccion = suavizado[j] / total;
+                if (fraccion <= 0.0) peso[j] = 0.0;
+                else if (fraccion >= 1.0) peso[j] = 1.0;
+                else peso[j] = std::pow((fraccion - 1.0) / std::log(fraccion), alfa);
+                total_pesos += peso[j];
+            }
+
+            const double por_intervalo = total_pesos / K;
+            double nuevos[K + 1];
+            nuevos[0] = 0.0;
+            int siguiente = 1;
+            double acumulado = 0.0;
+            for (int j = 0; j < K && siguiente < K; j++) {
+                acumulado += peso[j];
+                while (acumulado > por_intervalo && siguiente < K) {
+                    acumulado -= por_intervalo;
+                    nuevos[siguiente++] = b[j + 1] - (b[j + 1] - b[j]) * acumulado / peso[j];
+                }
+            }
+            // Redondeo: intervalos faltantes al final quedan de ancho nulo
+            while (siguiente < K) nuevos[siguiente++] = 1.0;
+            nuevos[K] = 1.0;
+            std::copy(nuevos, nuevos + K + 1, b);
+        }
+    }
+
+private:
+    int d;
+    std::vector<double> bordes;  // d * (INTERVALOS + 1)
+};
+
+// Sumas de una iteración: momentos de f*J y, por dimensión e intervalo,
+// sum (f*J)^2 para refinar la rejilla
+struct IteracionVegas {
+    Momentos momentos;
+    std::vector<double> histograma;
+    std::vector<double> compensacion;
+
+    explicit IteracionVegas(int dimensiones)
+        : histograma(std::size_t(dimensiones) * RejillaVegas::INTERVALOS),
+          compensacion(std::size_t(dimensiones) * RejillaVegas::INTERVALOS) {}
+
+    void reiniciar() {
+        momentos = Momentos{};
+        std::fill(histograma.begin(), histograma.end(), 0.0);
+        std::fill(compensacion.begin(), compensacion.end(), 0.0);
+    }
+
+    // Combinación compensada, igual que Momentos
+    IteracionVegas& operator+=(const IteracionVegas& otra) {
+        momentos += otra.momentos;
+        for (std::size_t i = 0; i < histograma.size(); i++) {
+            sumar_compensado(histograma[i], compensacion[i], otra.histograma[i]);
+            compensacion[i] += otra.compensacion[i];
+        }
+        return *this;
+    }
+
+    std::vector<double> histograma_total() const {
+        std::vector<double> total(histograma.size());
+        for (std::size_t i = 0; i < total.size(); i++) total[i] = histograma[i] + compensacion[i];
+        return total;
+    }
+};
+
+// Una iteración de VEGAS sobre las muestras [muestras.inicio, muestras.fin),
+// con el mismo reparto por bloques que integrar: el resultado no depende del
+// número de hilos ni de procesos.
+template <class Flujo, class F>
+IteracionVegas iterar_vegas(const F& func, const Dominio& dominio, const RejillaVegas& rejilla,
+                            Rango muestras, unsigned long long seed) {
+    const int d = dominio.dimensiones;
+    const double lim_inf = dominio.lim_inf;
+    const double ancho = dominio.ancho();
+    const long long primero = muestras.inicio / TAMANO_BLOQUE;
+    const long long ultimo = (muestras.fin + TAMANO_BLOQUE - 1) / TAMANO_BLOQUE;
+    IteracionVegas total(d);
+    ReduccionPorSocket<IteracionVegas> reduccion(hilos_disponibles(), total);
+
+    despachar_evaluacion<F>(d, [&](auto D) {
+        constexpr int DIM = decltype(D)::value;
+
+        MONTECARLO_OMP(parallel)
+        {
+            fijar_hilo();
+            Flujo flujo(seed, d);
+            EspacioLote espacio(d);
+            std::vector<double> jacobianos(TAMANO_LOTE);
+            std::vector<int> intervalos(std::size_t(d) * TAMANO_LOTE);
+            IteracionVegas local(d), bloque(d);
+
+            MONTECARLO_OMP(for schedule(dynamic) nowait)
+            for (long long b = primero; b < ultimo; b++) {
+                long long inicio = b * TAMANO_BLOQUE;
+                long long fin = inicio + TAMANO_BLOQUE;
+                if (inicio < muestras.inicio) inicio = muestras.inicio;
+                if (fin > muestras.fin) fin = muestras.fin;
+
+                TramoInstrumentado tramo(Fase::BLOQUE, fin - inicio);
+                flujo.saltar_a_muestra(inicio);
+                bloque.reiniciar();
+                for (long long hechos = inicio; hechos < fin; hechos += TAMANO_LOTE) {
+                    std::size_t m = fin - hechos < (long long)TAMANO_LOTE ? std::size_t(fin - hechos) : TAMANO_LOTE;
+                    double* soa = espacio.soa.data();
+
+                    flujo.llenar(espacio.sorteos.data(), m * d);
+                    for (std::size_t i = 0; i < m; i++) {
+                        jacobianos[i] = rejilla.transformar(&espacio.sorteos[i * d], soa + i, m, &intervalos[i * d]);
+                    }
+                    for (std::size_t j = 0; j < m * d; j++) soa[j] = lim_inf + ancho * soa[j];
+
+                    evaluar_soa<DIM>(func, soa, m, d, espacio.valores.data());
+
+                    for (std::size_t i = 0; i < m; i++) {
+                        double w = espacio.valores[i] * jacobianos[i];
+                        espacio.valores[i] = w;
+                        for (int k = 0; k < d; k++) {
+                            bloque.histograma[k * RejillaVegas::INTERVALOS + intervalos[i * d + k]] += w * w;
+                        }
+                    }
+                    bloque.momentos += simd::sumar(espacio.valores.data(), m);
+                }
+                local += bloque;
+            }
+
+            if (instrumentacion_activa) {
+                TramoInstrumentado espera(Fase::ESPERA);
+                MONTECARLO_OMP(barrier)
+            }
+
+            // Mismo orden de combinación que integrar: dentro de cada socket y después entre sockets
+            TramoInstrumentado tramo(Fase::REDUCCION);
+            reduccion.reducir(local, total);
+        }
+        return 0;
+    });
+
+    return total;
+}
+
+// Compresión del refinamiento (valor usual de VEGAS entre 1 y 2)
+constexpr double ALFA_VEGAS = 1.5;
+
+// VEGAS completo: p.iteraciones_vegas iteraciones de N / iteraciones muestras.
+// repartir(n) da el rango local de cada iteración y reducir(iteracion) la suma
+// global, que todos los procesos necesitan para refinar la misma rejilla. Las
+// estimaciones se combinan con pesos 1/sigma^2 y se informa chi^2 por grado de
+// libertad: un valor mucho mayor que 1 indica que la rejilla aún no converge.
+template <class F, class Repartir, class Reducir>
+Resultado vegas(const F& func, const Dominio& dominio, const Parametros& p, Repartir repartir, Reducir reducir) {
+    const long long n = p.puntos_por_iteracion();
+    const double volumen = dominio.volumen();
+    RejillaVegas rejilla(dominio.dimensiones);
+
+    std::vector<double> integrales, varianzas;
+    Resultado r;
+    for (int it = 0; it < p.iteraciones_vegas; it++) {
+        IteracionVegas iteracion = despachar_flujo(p, [&](auto tipo) {
+            using Flujo = typename decltype(tipo)::type;
+            return iterar_vegas<Flujo>(func, dominio, rejilla, repartir(n), derivar_semilla(p.seed, it));
+        });
+        iteracion = reducir(iteracion);
+
+        Resultado parcial = estimar(iteracion.momentos, n, volumen);
+        integrales.push_back(parcial.integral);
+        varianzas.push_back(parcial.error * parcial.error);
+        r.varianza = parcial.varianza;
+
+        rejilla.refinar(iteracion.histograma_total(), ALFA_VEGAS);
+    }
+
+    // Promedio pesado; una iteración con varianza nula (integrando constante
+    // en la rejilla) se trata con la menor varianza representable
+    double suma_pesos = 0.0, suma = 0.0;
+    for (std::size_t i = 0; i < integrales.size(); i++) {
+        double peso = 1.0 / std::max(varianzas[i], 1e-300);
+        suma_pesos += peso;
+        suma += peso * integrales[i];
+    }
+    r.integral = suma / suma_pesos;
+    r.error = std::sqrt(1.0 / suma_pesos);
+
+    double chi2 = 0.0;
+    for (std::size_t i = 0; i < integrales.size(); i++) {
+        double desvio = integrales[i] - r.integral;
+        chi2 += desvio * desvio / std::max(varianzas[i], 1e-300);
+    }
+    r.chi2_dof = integrales.size() > 1 ? chi2 / (integrales.size() - 1) : 0.0;
+    r.muestras = n * p.iteraciones_vegas;
+    return r;
+}
+
+// VEGAS con memoria compartida: todas las muestras en este proceso
+template <class F>
+Resultado vegas(const F& func, const Dominio& dominio, const Parametros& p) {
+    return vegas(func, dominio, p,
+                 [](long long n) { return Rango{0, n}; },
+                 [](const IteracionVegas& iteracion) { return iteracion; });
+}
+
+} // namespace montecarlo
@@ -0,0 +1,22 @@
+// Plugin de referencia: la gaussiana de integrando.hpp detrás de la ABI en C de
+// plugin_abi.h. Da exactamente los mismos resultados que el integrando compilado.
+//
+//   g++ -O3 -march=native -std=c++17 -shared -fPIC plugins/gaussiana.cpp -o libgaussiana.so
+//   ./ParalelizacionMC --li 0 --ls 1 --d 3 --n 100000000 --plugin ./libgaussiana.so
+
+#include <cstddef>
+
+#include "../integrador/integrando.hpp"
+#include "../integrador/plugin_abi.h"
+
+extern "C" {
+
+int plugin_abi_version(void) {
+    return MONTECARLO_PLUGIN_ABI_VERSION;
+}
+
+void eval_batch(const double* soa, size_t n, size_t d, double* out) {
+    montecarlo::Gaussiana{}.evaluar_lote(soa, n, d, out);
+}
+
+}